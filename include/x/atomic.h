@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_ATOMIC_H
+#define X_ATOMIC_H
+
+#include "detect.h"
+#include <stdbool.h>
+
+#if !defined(__GNUC__) && !defined(__clang__)
+#error "x/atomic.h requires GCC compatible __atomic builtins"
+#endif
+
+#define X_ATOMIC_RELAXED __ATOMIC_RELAXED
+#define X_ATOMIC_ACQUIRE __ATOMIC_ACQUIRE
+#define X_ATOMIC_RELEASE __ATOMIC_RELEASE
+#define X_ATOMIC_ACQ_REL __ATOMIC_ACQ_REL
+#define X_ATOMIC_SEQ_CST __ATOMIC_SEQ_CST
+
+#define x_atomic_load(ptr, order) __atomic_load_n(ptr, order)
+#define x_atomic_store(ptr, val, order) __atomic_store_n(ptr, val, order)
+#define x_atomic_exchange(ptr, val, order) __atomic_exchange_n(ptr, val, order)
+#define x_atomic_fetch_add(ptr, val, order) __atomic_fetch_add(ptr, val, order)
+#define x_atomic_fetch_sub(ptr, val, order) __atomic_fetch_sub(ptr, val, order)
+#define x_atomic_fetch_or(ptr, val, order) __atomic_fetch_or(ptr, val, order)
+#define x_atomic_fetch_and(ptr, val, order) __atomic_fetch_and(ptr, val, order)
+#define x_atomic_fence(order) __atomic_thread_fence(order)
+
+/* On failure *expected is updated with the current value */
+#define x_atomic_cas(ptr, expected, desired, success, failure) \
+	__atomic_compare_exchange_n(ptr, expected, desired, false, success, failure)
+#define x_atomic_cas_weak(ptr, expected, desired, success, failure) \
+	__atomic_compare_exchange_n(ptr, expected, desired, true, success, failure)
+
+/* Hint for spin-wait loops */
+#if defined(X_ARCH_AMD64) || defined(X_ARCH_I386)
+#define x_cpu_relax() __builtin_ia32_pause()
+#elif defined(X_ARCH_AARCH64)
+#define x_cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define x_cpu_relax() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#endif
+
+#define X_CACHE_LINE_SIZE 64
+
+#endif
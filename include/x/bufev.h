@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_BUFEV_H
+#define X_BUFEV_H
+
+#include "types.h"
+#include "event.h"
+#include "pipe.h"
+#include <stdint.h>
+
+/*
+ * Buffered socket on top of x_evsocket. Incoming data is read straight into
+ * the input ring and outgoing data written straight from the output ring,
+ * readv / writev cover both halves of a wrapped ring in one call.
+ *
+ * The owner pops events from the reactor as usual and passes those of a
+ * buffered socket to x_bufev_dispatch, which fills and flushes the rings and
+ * runs the callbacks: on_write once the output is at or below its low
+ * watermark, on_read once the input holds at least the read low watermark,
+ * then on_event for end of stream or an error. Only on_event may free the
+ * x_bufev, nothing touches it after on_event returns.
+ *
+ * Reading pauses while the input holds the read high watermark (0 means the
+ * whole ring) and resumes once x_bufev_read or x_bufev_drain consumed some.
+ * Writes made inside the callbacks are flushed together when they return,
+ * writes from elsewhere are flushed right away. The socket is not closed by
+ * x_bufev_free.
+ *
+ * x_bufev_sendfile streams part of a file to the socket behind the output
+ * already written, without copying it through user space: sendfile for
+ * files, splice for pipes, where the offset is ignored. The transfer is
+ * driven by write readiness (and read readiness of a pipe). Output written
+ * meanwhile follows the file. Completion is reported to on_event as
+ * X_BUFEV_SENDFILE once length bytes or the whole source went out. The
+ * kernel raises SIGPIPE for a closed peer here, unlike for the rings, so a
+ * program using it should ignore that signal. fd stays open.
+ */
+
+#define X_BUFEV_EOF      0x1
+#define X_BUFEV_ERROR    0x2
+#define X_BUFEV_SENDFILE 0x4
+
+typedef void x_bufev_fn(x_bufev *bev, void *arg);
+typedef void x_bufev_event_fn(x_bufev *bev, short what, void *arg);
+
+struct x_bufev_st
+{
+	x_evsocket ev;
+	x_reactor *reactor;
+	x_pipe input, output;
+	size_t read_low, read_high;
+	size_t write_low;
+	x_bufev_fn *on_read, *on_write;
+	x_bufev_event_fn *on_event;
+	void *arg;
+	bool paused;
+	bool eof;
+	bool dispatching;
+
+	/* File transfer, xfer_fd is -1 when there is none */
+	int xfer_fd;
+	uint64_t xfer_off, xfer_left;
+	size_t xfer_skip;
+	bool xfer_pipe, xfer_copy, xfer_done;
+	bool xfer_wait_src, xfer_from_src;
+	x_evsocket xfer_src;
+};
+
+int x_bufev_init(x_bufev *bev, x_reactor *r, x_sock sock, size_t in_size, size_t out_size);
+void x_bufev_free(x_bufev *bev);
+void x_bufev_set_callbacks(x_bufev *bev, x_bufev_fn *on_read, x_bufev_fn *on_write,
+		x_bufev_event_fn *on_event, void *arg);
+void x_bufev_set_watermark(x_bufev *bev, short what, size_t low, size_t high);
+size_t x_bufev_write(x_bufev *bev, const void *data, size_t size);
+int x_bufev_flush(x_bufev *bev);
+size_t x_bufev_read(x_bufev *bev, void *buf, size_t size);
+size_t x_bufev_drain(x_bufev *bev, size_t size);
+int x_bufev_sendfile(x_bufev *bev, int fd, uint64_t offset, uint64_t length);
+void x_bufev_dispatch(x_event *e);
+
+inline static x_pipe *x_bufev_input(x_bufev *bev)
+{
+	return &bev->input;
+}
+
+inline static x_pipe *x_bufev_output(x_bufev *bev)
+{
+	return &bev->output;
+}
+
+#endif
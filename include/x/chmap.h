@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_CHMAP_H
+#define X_CHMAP_H
+
+#include "types.h"
+#include "hmap.h"
+
+/*
+ * Concurrent hash map made of lock striped x_hmap shards. Writers take the
+ * shard mutex, readers walk the shard optimistically under its sequence
+ * counter and fall back to the mutex only after repeated conflicts.
+ *
+ * Nodes unlinked by remove/replace may still be seen by concurrent readers,
+ * call x_chmap_synchronize() before freeing or reusing them. A node returned
+ * by x_chmap_find() stays valid until the caller leaves an enclosing
+ * x_chmap_read_enter()/x_chmap_read_leave() section.
+ */
+
+struct x_chmap_st {
+	struct x_chmap_shard_st *shards;
+	size_t shard_mask;
+	x_hmap_hash_fn *hash;
+	x_hmap_equal_fn *equal;
+};
+
+int x_chmap_init(x_chmap *cm, size_t shard_cnt, float load_factor, x_hmap_hash_fn *hash_fn, x_hmap_equal_fn *equal_fn);
+x_link *x_chmap_find(x_chmap *cm, const x_link *link);
+x_link *x_chmap_find_or_insert(x_chmap *cm, x_link *link);
+x_link *x_chmap_replace_or_insert(x_chmap *cm, x_link *link);
+x_link *x_chmap_find_and_remove(x_chmap *cm, const x_link *link);
+void x_chmap_remove(x_chmap *cm, x_link *link);
+size_t x_chmap_count(x_chmap *cm);
+void x_chmap_free(x_chmap *cm);
+
+void x_chmap_read_enter(void);
+void x_chmap_read_leave(void);
+void x_chmap_synchronize(void);
+
+#endif
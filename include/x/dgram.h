@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_DGRAM_H
+#define X_DGRAM_H
+
+#include "types.h"
+#include "socket.h"
+#include <stdint.h>
+#ifndef X_OS_WIN32
+#include <sys/uio.h>
+#endif
+
+/*
+ * Batched datagram I/O. x_dgram_recv and x_dgram_send move up to cnt
+ * messages per system call with recvmmsg / sendmmsg, one recvmsg / sendmsg
+ * each where those are missing. Each message scatters into or gathers from
+ * caller provided buffers.
+ *
+ * On the read readiness of an x_evsocket call x_dgram_recv until it returns
+ * fewer than cnt messages, or -1 with EAGAIN. A send that returns fewer
+ * than cnt means the socket buffer is full, the rest goes out on the next
+ * write readiness.
+ *
+ * UDP segmentation offload: a message sent with a non-zero segment is cut
+ * by the kernel (or NIC) into datagrams of that size, one syscall and one
+ * trip through the stack for all of them. With x_dgram_set_gro a receive
+ * may likewise return several datagrams of the same flow as one message,
+ * segment then tells their size, all but the last one are that long.
+ */
+
+#ifdef X_OS_WIN32
+typedef WSABUF x_dgram_iov;
+#define x_dgram_iov_set(v, p, n) ((v)->buf = (CHAR *)(p), (v)->len = (ULONG)(n))
+#else
+typedef struct iovec x_dgram_iov;
+#define x_dgram_iov_set(v, p, n) ((v)->iov_base = (p), (v)->iov_len = (n))
+#endif
+
+struct x_dgram_msg_st
+{
+	/* Peer address, NULL for a connected socket. addrlen: size in, length out */
+	struct sockaddr *addr;
+	socklen_t addrlen;
+	x_dgram_iov *iov;
+	size_t iovcnt;
+	/* Bytes received or sent */
+	size_t len;
+	/* Segment size to send with, or as coalesced on receive, 0 for none */
+	uint16_t segment;
+	/* The datagram did not fit into iov and was cut */
+	bool truncated;
+};
+
+int x_dgram_recv(x_sock sock, x_dgram_msg *msgs, int cnt);
+int x_dgram_send(x_sock sock, x_dgram_msg *msgs, int cnt);
+int x_dgram_set_gro(x_sock sock, bool enable);
+
+#endif
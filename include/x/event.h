@@ -27,6 +27,8 @@
 #include "time.h"
 #include "list.h"
 #include "heap.h"
+#include "twheel.h"
+#include "mpsc.h"
 #include <stdint.h>
 
 #define X_EV_REACTING (1 << 0)
@@ -36,6 +38,21 @@
 #define X_EV_WRITE    (1 << 4)
 #define X_EV_ACCURATE (1 << 5)
 
+/*
+ * Sockets are level triggered by default: a readable socket is reported on
+ * every x_reactor_wait until it has been drained. With X_EV_EDGE it is only
+ * reported when new data arrives (or it becomes writable again), so the
+ * handler must read / write until EAGAIN, otherwise data already buffered
+ * is not reported again.
+ *
+ * X_EV_EXCLUSIVE is for a listening socket shared by several reactors: a
+ * new connection wakes only one of the reactors waiting on it instead of
+ * all of them. It cannot be combined with X_EV_ONCE. Backends without such
+ * a mode ignore it.
+ */
+#define X_EV_EDGE      (1 << 6)
+#define X_EV_EXCLUSIVE (1 << 7)
+
 enum {
 	X_EVENT_SOCKET,
 	X_EVENT_TIMER,
@@ -51,6 +68,8 @@ struct x_event_st
 	x_link pending_link;
 	x_reactor *reactor;
 	void *data;
+	x_mpsc_node cmd_node;
+	int cmd;
 };
 
 struct x_evsocket_st
@@ -64,16 +83,24 @@ struct x_evtimer_st
 {
 	x_event base;
 	x_ranode node;
+	x_twnode wheel_node;
 	struct timeval expiration;
 	size_t interval;
 	size_t index;
 };
 
+/*
+ * An object is reported while its res_flags are non-zero. Raise it with
+ * x_reactor_raise, from any thread, and clear res_flags in the handler
+ * once it has been served.
+ */
 struct x_evobject_st
 {
 	x_event base;
 	x_link link;
 	size_t index;
+	x_evobject *ready_next;
+	int queued;
 };
 
 void x_evsocket_init(x_evsocket *event, x_sock sock, short flags, void *data);
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_FIBER_H
+#define X_FIBER_H
+
+#include "types.h"
+#include "reactor.h"
+#include "socket.h"
+
+/*
+ * Stackful coroutines on one thread, driven by a reactor. A fiber runs until
+ * it waits: x_fiber_recv and the like try the socket first and only when it
+ * would block register it with the reactor and switch back to the scheduler,
+ * which resumes the fiber once the socket is ready or the timeout expired.
+ * msec bounds every single wait, -1 waits for good.
+ *
+ * Stacks are mapped with a guard page below them, so an overflow faults
+ * instead of corrupting a neighbour, and only the pages a fiber touches are
+ * backed by memory. Finished fibers are kept for reuse, with their stacks.
+ * Each stack is two mappings, on Linux more than about 32k fibers need a
+ * higher vm.max_map_count.
+ *
+ * x_fiber_sched_run owns the reactor: every event on it must belong to a
+ * fiber, and it returns once no fiber is left or after x_reactor_break,
+ * x_fiber_sched_free drops the fibers that are still suspended then. A
+ * fiber keeps the last socket it waited on registered, so it has to close
+ * such sockets with x_fiber_close, and only one fiber may wait on a socket
+ * at a time.
+ */
+
+#define X_FIBER_STACK_SIZE (64 * 1024)
+
+typedef void x_fiber_fn(x_fiber *self, void *arg);
+
+struct x_fiber_sched_st
+{
+	x_reactor *reactor;
+	x_fiber *main;
+	x_fiber *current;
+	x_list fibers;
+	x_list ready;
+	x_list cache;
+	size_t cache_cnt;
+	size_t fiber_cnt;
+	size_t stack_size;
+	x_evobject kick;
+};
+
+int x_fiber_sched_init(x_fiber_sched *s, x_reactor *r, size_t stack_size);
+void x_fiber_sched_free(x_fiber_sched *s);
+int x_fiber_sched_run(x_fiber_sched *s);
+
+x_fiber *x_fiber_spawn(x_fiber_sched *s, x_fiber_fn *fn, void *arg);
+x_fiber_sched *x_fiber_sched_of(const x_fiber *f);
+void x_fiber_yield(x_fiber *self);
+int x_fiber_sleep(x_fiber *self, int msec);
+int x_fiber_wait(x_fiber *self, x_sock sock, short flags, int msec);
+
+x_sock x_fiber_accept(x_fiber *self, x_sock sock, struct sockaddr *addr, socklen_t *addrlen, int msec);
+int x_fiber_connect(x_fiber *self, x_sock sock, const struct sockaddr *addr, socklen_t addrlen, int msec);
+int x_fiber_recv(x_fiber *self, x_sock sock, void *buf, size_t len, int msec);
+int x_fiber_send(x_fiber *self, x_sock sock, const void *data, size_t len, int msec);
+int x_fiber_close(x_fiber *self, x_sock sock);
+
+#endif
@@ -25,6 +25,7 @@
 #define X_HEAP_H
 
 #include "types.h"
+#include <stdint.h>
 
 struct x_ranode_st
 {
@@ -40,9 +41,11 @@ struct x_heap_st
 	size_t min_page_cnt;
 	size_t page_cnt;
 	x_ranode **table;
+	bool hugepage;
 };
 
 void x_heap_init(x_heap *h, x_heap_ordered_fn *cmp);
+void x_heap_set_hugepage(x_heap *h, bool hugepage);
 void x_heap_free(x_heap *h);
 void x_heap_push(x_heap *h, x_ranode *n);
 x_ranode *x_heap_top(const x_heap *h);
@@ -54,5 +57,48 @@ static inline size_t x_heap_size(const x_heap* h)
 	return h->entry_cnt;
 }
 
+/*
+ * d-ary min-heap keyed by an inline uint64_t. Each entry keeps the key next
+ * to the node pointer and every group of siblings shares a cache line, so
+ * sifting compares keys in place instead of calling back into the nodes.
+ */
+
+#define X_DHEAP_ARITY 4
+
+struct x_dheap_entry_st
+{
+	uint64_t key;
+	x_ranode *node;
+};
+
+struct x_dheap_st
+{
+	struct x_dheap_entry_st *table;
+	void *mem;
+	size_t entry_cnt;
+	size_t capacity;
+	bool hugepage;
+};
+
+void x_dheap_init(x_dheap *h);
+void x_dheap_set_hugepage(x_dheap *h, bool hugepage);
+void x_dheap_free(x_dheap *h);
+void x_dheap_push(x_dheap *h, x_ranode *n, uint64_t key);
+void x_dheap_build(x_dheap *h, x_ranode *const *nodes, const uint64_t *keys, size_t cnt);
+x_ranode *x_dheap_top(const x_dheap *h, uint64_t *key);
+x_ranode *x_dheap_pop(x_dheap *h, uint64_t *key);
+void x_dheap_remove(x_dheap *h, x_ranode *n);
+void x_dheap_update(x_dheap *h, x_ranode *n, uint64_t key);
+
+static inline size_t x_dheap_size(const x_dheap *h)
+{
+	return h->entry_cnt;
+}
+
+static inline uint64_t x_dheap_key(const x_dheap *h, const x_ranode *n)
+{
+	return h->table[n->index].key;
+}
+
 #endif
 
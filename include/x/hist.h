@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_HIST_H
+#define X_HIST_H
+
+#include "types.h"
+#include <stdint.h>
+
+/*
+ * Log-linear histogram of uint64 samples. Values below 2^X_HIST_SUB_BITS
+ * get a bucket each, every power of two above is split into
+ * 2^X_HIST_SUB_BITS equal buckets, so a reported percentile is within 25%
+ * of the real value. Adding a sample is a handful of instructions and
+ * never allocates.
+ */
+
+#define X_HIST_SUB_BITS 2
+#define X_HIST_BUCKETS ((64 - X_HIST_SUB_BITS + 1) << X_HIST_SUB_BITS)
+
+struct x_hist_st
+{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint64_t buckets[X_HIST_BUCKETS];
+};
+
+void x_hist_init(x_hist *h);
+void x_hist_merge(x_hist *dst, const x_hist *src);
+uint64_t x_hist_percentile(const x_hist *h, double p);
+uint64_t x_hist_bucket_max(unsigned index);
+
+inline static unsigned x_hist_log2(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return 63 - __builtin_clzll(value);
+#else
+	unsigned n = 0;
+	while (value >>= 1)
+		n++;
+	return n;
+#endif
+}
+
+inline static unsigned x_hist_index(uint64_t value)
+{
+	if (value < (1u << X_HIST_SUB_BITS))
+		return (unsigned)value;
+	unsigned exp = x_hist_log2(value);
+	unsigned sub = (unsigned)(value >> (exp - X_HIST_SUB_BITS)) & ((1u << X_HIST_SUB_BITS) - 1);
+	return ((exp - X_HIST_SUB_BITS + 1) << X_HIST_SUB_BITS) | sub;
+}
+
+inline static void x_hist_add(x_hist *h, uint64_t value)
+{
+	h->buckets[x_hist_index(value)]++;
+	h->count++;
+	h->sum += value;
+	if (value < h->min)
+		h->min = value;
+	if (value > h->max)
+		h->max = value;
+}
+
+#endif
@@ -29,22 +29,34 @@
 typedef size_t x_hmap_hash_fn(const x_link *node);
 typedef bool x_hmap_equal_fn(const x_link *node1, const x_link *node2);
 
+#define X_HMAP_MIGRATE_STEP 8
+
 struct x_hmap_st {
 	x_list *table;
+	x_list *old_table;
 	size_t load_limit;
 	size_t elem_cnt;
 	size_t slot_cnt;
+	size_t old_slot_cnt;
+	size_t migrate_idx;
 	float load_factor;
 	uint8_t prime_idx;
+	bool incremental;
+	bool hugepage;
 	x_hmap_hash_fn *hash;
 	x_hmap_equal_fn *equal;
 };
 
 uint32_t x_hmap_hash(unsigned key);
+size_t x_hmap_memhash(const void *p, size_t size);
+size_t x_hmap_strhash(const char *s);
 void x_hmap_init(x_hmap *ht, float load_factor, x_hmap_hash_fn *hash_fn, x_hmap_equal_fn *equal_fn);
+void x_hmap_set_incremental(x_hmap *ht, bool incremental);
+void x_hmap_set_hugepage(x_hmap *ht, bool hugepage);
+void x_hmap_reserve(x_hmap *ht, size_t elem_cnt);
 x_link *x_hmap_find(x_hmap *ht, const x_link *node);
 x_link *x_hmap_find_or_insert(x_hmap *ht, x_link *node);
-x_link *x_hmap_insert_or_replace(x_hmap *ht, x_link *node);
+x_link *x_hmap_replace_or_insert(x_hmap *ht, x_link *node);
 x_link *x_hmap_find_and_remove(x_hmap *ht, const x_link *link);
 void x_hmap_remove(x_hmap *ht, x_link *link);
 void x_hmap_free(x_hmap *ht);
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_LISTENER_H
+#define X_LISTENER_H
+
+#include "types.h"
+#include "event.h"
+
+/*
+ * A listening socket on a reactor that accepts in batches. The owner pops
+ * its events as usual and passes them to x_listener_dispatch, which accepts
+ * until the backlog is empty or budget connections were taken, so one busy
+ * listener cannot starve the other events of the loop. Whatever is left is
+ * reported on the next turn, an edge triggered listener is re-armed for it.
+ *
+ * New sockets are non-blocking and close-on-exec, set atomically by accept4
+ * where available, and handed to on_accept, which owns them from then on,
+ * e.g. to pass them to another reactor of a group.
+ */
+
+#define X_LISTENER_BUDGET 64
+
+typedef void x_listener_fn(x_listener *ln, x_sock sock, void *arg);
+
+struct x_listener_st
+{
+	x_evsocket ev;
+	x_reactor *reactor;
+	int budget;
+	x_listener_fn *on_accept;
+	void *arg;
+};
+
+int x_listener_init(x_listener *ln, x_reactor *r, x_sock sock, short flags,
+		x_listener_fn *on_accept, void *arg);
+void x_listener_free(x_listener *ln);
+int x_listener_dispatch(x_event *e);
+
+#endif
@@ -24,27 +24,92 @@
 #define X_MEMORY_H
 
 #include "types.h"
+#include "assert.h"
 #include "list.h"
 #include "mutex.h"
+#include "tss.h"
 #include <stddef.h>
 #include <stdint.h>
 
+#define X_MSET_ARENA 0x01
+#define X_MSET_STATS 0x02
+
+#define X_MSET_SITE_MAX 1024
+
+/*
+ * Blocks from the mmap threshold on are mapped, and grown by remapping on
+ * Linux. As in glibc the threshold starts at X_MSET_MMAP_THRESHOLD and rises
+ * to the size of each mapped block freed, up to X_MSET_MMAP_THRESHOLD_MAX,
+ * so buffers allocated and freed over and over stop costing an mmap and a
+ * munmap each. x_mset_set_mmap_threshold pins it instead.
+ */
+#define X_MSET_MMAP_THRESHOLD (256 * 1024)
+#define X_MSET_MMAP_THRESHOLD_MAX (32 * 1024 * 1024)
+
+#define X_MSET_ARENA_CHUNK_SIZE (64 * 1024)
+
+#define X_MPOOL_MAGAZINE_SIZE 32
+#define X_MPOOL_SLAB_SIZE (64 * 1024)
+
+/* size and mset must stay right before data, arena blocks share them */
 struct x_mblock_st
 {
-	x_mset *mset;
 	x_link link;
+	size_t size;
+	x_mset *mset;
 	char data[];
 };
 
+struct x_mset_stats_st
+{
+	size_t live_bytes;
+	size_t live_blocks;
+	size_t peak_bytes;
+	uint64_t alloc_cnt;
+	uint64_t free_cnt;
+	uint64_t since;
+};
+
+struct x_mset_site_table_st;
+
 struct x_mset_st
 {
 	x_list list;
 	x_mutex lock;
+	int flags;
+	size_t chunk_size;
+	uint8_t *cur, *end;
+	x_mset_stats stats;
+	struct x_mset_site_table_st *sites;
+};
+
+struct x_mpool_magazine_st;
+
+struct x_mpool_st
+{
+	size_t obj_size;
+	size_t slab_size;
+	x_mutex lock;
+	x_list slab_list;
+	x_list cache_list;
+	struct x_mpool_magazine_st *full, *empty;
+	uint8_t *cur, *end;
+	x_tss cache;
 };
 
 void x_mset_init(x_mset *mset);
+
+/*
+ * Arena mset: blocks are bump-allocated from chunks of chunk_size bytes
+ * (0 for X_MSET_ARENA_CHUNK_SIZE) without lock and list bookkeeping.
+ * An arena is owned by one thread at a time, x_free only gives back the
+ * most recent block, the rest is released by x_mset_clear/x_mset_free.
+ * Arena blocks can not be detached or attached.
+ */
+void x_mset_init_arena(x_mset *mset, size_t chunk_size);
 void x_mset_clear(x_mset *mset);
 void x_mset_free(x_mset *mset);
+void x_mset_set_mmap_threshold(size_t size);
 void *x_calloc(x_mset *mset, size_t nmemb, size_t size);
 void *x_malloc(x_mset *mset, size_t size);
 void *x_mcopy(x_mset *mset, const void *ptr, size_t size);
@@ -54,5 +119,43 @@ void x_free(void *ptr);
 void x_mdetach(void *ptr);
 void x_mattach(x_mset *mset, void *ptr);
 
+/* Advise transparent huge pages for a mapped block of 2MB or more, the
+ * containers only do so when their hugepage flag is set */
+int x_mhuge(void *ptr);
+
+/*
+ * Allocation accounting, counters are updated while the mset lock is
+ * already held. Blocks allocated before stats were enabled are left out
+ * of the counters, freeing or resizing them later changes nothing. With
+ * sites enabled, allocations made from code built with X_MSET_TRACE are
+ * also counted by call site (file:line). Site counts and bytes are
+ * cumulative since enabling, frees are not subtracted from them.
+ */
+int x_mset_stats_enable(x_mset *mset, bool sites);
+void x_mset_stats_get(x_mset *mset, x_mset_stats *stats);
+x_dump *x_mset_stats_dump(x_mset *mset);
+
+void *__x_malloc_at(const x_location *loc, x_mset *mset, size_t size);
+void *__x_zalloc_at(const x_location *loc, x_mset *mset, size_t size);
+void *__x_calloc_at(const x_location *loc, x_mset *mset, size_t nmemb, size_t size);
+void *__x_mcopy_at(const x_location *loc, x_mset *mset, const void *ptr, size_t size);
+
+#ifdef X_MSET_TRACE
+#define x_malloc(mset, size) __x_malloc_at(X_WHERE, (mset), (size))
+#define x_zalloc(mset, size) __x_zalloc_at(X_WHERE, (mset), (size))
+#define x_calloc(mset, nmemb, size) __x_calloc_at(X_WHERE, (mset), (nmemb), (size))
+#define x_mcopy(mset, ptr, size) __x_mcopy_at(X_WHERE, (mset), (ptr), (size))
+#endif
+
+/*
+ * Fixed-size object pool: every thread keeps two magazines of cached
+ * objects and only goes to the locked depot when both are empty/full.
+ * Objects have no header and may be put back from any thread.
+ */
+int x_mpool_init(x_mpool *pool, size_t obj_size);
+void x_mpool_free(x_mpool *pool);
+void *x_mpool_get(x_mpool *pool);
+void x_mpool_put(x_mpool *pool, void *obj);
+
 #endif
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_MPSC_H
+#define X_MPSC_H
+
+#include "types.h"
+#include "atomic.h"
+#include <stddef.h>
+
+/*
+ * Intrusive multi-producer single-consumer queue (Vyukov). x_mpsc_push is
+ * wait-free and may be called from any thread, x_mpsc_pop only from one
+ * consumer at a time. While a producer is between its two steps the nodes
+ * behind it are not visible yet and x_mpsc_pop returns NULL, so producers
+ * are expected to wake the consumer after pushing.
+ */
+
+struct x_mpsc_node_st
+{
+	x_mpsc_node *next;
+};
+
+struct x_mpsc_st
+{
+	x_mpsc_node *head;
+	char pad[X_CACHE_LINE_SIZE - sizeof(x_mpsc_node *)];
+	x_mpsc_node *tail;
+	x_mpsc_node stub;
+};
+
+inline static void x_mpsc_init(x_mpsc *q)
+{
+	q->stub.next = NULL;
+	q->head = q->tail = &q->stub;
+}
+
+inline static void x_mpsc_push(x_mpsc *q, x_mpsc_node *n)
+{
+	x_atomic_store(&n->next, NULL, X_ATOMIC_RELAXED);
+	x_mpsc_node *prev = x_atomic_exchange(&q->head, n, X_ATOMIC_ACQ_REL);
+	x_atomic_store(&prev->next, n, X_ATOMIC_RELEASE);
+}
+
+/* Consumer side, a push still in progress counts as not empty */
+inline static bool x_mpsc_is_empty(x_mpsc *q)
+{
+	return q->tail == &q->stub && x_atomic_load(&q->head, X_ATOMIC_ACQUIRE) == &q->stub;
+}
+
+inline static x_mpsc_node *x_mpsc_pop(x_mpsc *q)
+{
+	x_mpsc_node *tail = q->tail;
+	x_mpsc_node *next = x_atomic_load(&tail->next, X_ATOMIC_ACQUIRE);
+	if (tail == &q->stub) {
+		if (!next)
+			return NULL;
+		q->tail = tail = next;
+		next = x_atomic_load(&next->next, X_ATOMIC_ACQUIRE);
+	}
+	if (next) {
+		q->tail = next;
+		return tail;
+	}
+	if (tail != x_atomic_load(&q->head, X_ATOMIC_ACQUIRE))
+		return NULL;
+	/* tail is the last node, put the stub behind it before handing it out */
+	x_mpsc_push(q, &q->stub);
+	next = x_atomic_load(&tail->next, X_ATOMIC_ACQUIRE);
+	if (!next)
+		return NULL;
+	q->tail = next;
+	return tail;
+}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_OHMAP_H
+#define X_OHMAP_H
+
+#include "types.h"
+#include "hmap.h"
+#include <stdint.h>
+
+/*
+ * Open addressing hash table. Each slot has a one byte control word holding
+ * 7 bits of the hash, a group of control words is compared at once (SSE2,
+ * NEON or SWAR), so the elements themselves are touched only on likely hits.
+ * Nodes are not linked into the table, the x_link is only used as a handle
+ * for the hash and equal callbacks.
+ */
+
+struct x_ohmap_st {
+	x_link **slots;
+	uint8_t *ctrl;
+	size_t mask;
+	size_t elem_cnt;
+	size_t growth_left;
+	bool hugepage;
+	x_hmap_hash_fn *hash;
+	x_hmap_equal_fn *equal;
+};
+
+void x_ohmap_init(x_ohmap *om, x_hmap_hash_fn *hash_fn, x_hmap_equal_fn *equal_fn);
+void x_ohmap_set_hugepage(x_ohmap *om, bool hugepage);
+void x_ohmap_reserve(x_ohmap *om, size_t elem_cnt);
+x_link *x_ohmap_find(x_ohmap *om, const x_link *link);
+x_link *x_ohmap_find_or_insert(x_ohmap *om, x_link *link);
+x_link *x_ohmap_replace_or_insert(x_ohmap *om, x_link *link);
+x_link *x_ohmap_find_and_remove(x_ohmap *om, const x_link *link);
+void x_ohmap_remove(x_ohmap *om, x_link *link);
+x_link *x_ohmap_next(const x_ohmap *om, size_t *iter);
+void x_ohmap_free(x_ohmap *om);
+
+#endif
@@ -27,38 +27,97 @@
 #include "event.h"
 #include "list.h"
 #include "heap.h"
+#include "twheel.h"
 #include "hmap.h"
 #include "mutex.h"
+#include "mpsc.h"
+#include "hist.h"
 #include "socket.h"
 #include "event.h"
 
+enum {
+	X_REACTOR_TIMER_HEAP,
+	X_REACTOR_TIMER_WHEEL,
+};
+
 struct x_reactor_st
 {
 	x_list pending_list;
 	x_mutex lock;
 	x_evsocket io_event;
 	x_sock io_pipe1;
+	int io_signaled;
 	bool breaking;
 
+	/* Adds and modifications posted by threads other than the loop */
+	x_mpsc cmd_queue;
+	uint32_t owner;
+
 	const struct x_sockmux_ops_st *mux_ops;
 	x_sockmux *mux;
 	x_hmap sock_ht;
+	bool polling;
+	x_evsocket **stale;
+	size_t stale_cnt;
+	size_t stale_cap;
 
-	x_heap timer_heap;
+	int timer_store;
+	x_dheap timer_heap;
+	x_twheel timer_wheel;
 	struct timeval last_wait;
 
+	/*
+	 * Raised objects are pushed onto obj_stack by any thread, the loop
+	 * moves them to obj_ready and keeps them there while their res_flags
+	 * are set, so a wait only looks at objects that fired.
+	 */
+	x_evobject *obj_stack;
+	x_list obj_ready;
+
+	/* Every added object, linked through event_link */
 	x_list obj_list;
+
+	/* NULL unless x_reactor_enable_stats was called */
+	x_reactor_stats *stats;
+
+	/* Spin with zero timeout polls this long before blocking, 0 never */
+	uint32_t busy_poll_usec;
+};
+
+/*
+ * Loop instrumentation. Durations are sampled with x_time_nsec only when
+ * stats are enabled, a disabled reactor pays one pointer test per wait
+ * and per pop.
+ */
+struct x_reactor_stats_st
+{
+	uint64_t iterations;     /* times m_poll was entered */
+	x_hist events;           /* events pended per iteration */
+	x_hist poll_ns;          /* time blocked in m_poll */
+	x_hist dispatch_ns;      /* time from one pop to the next */
+	x_hist timer_late_us;    /* how late timers were pended */
+	x_hist pending_depth;    /* pending list length when wait returns */
+	uint64_t last_pop;
 };
 
 int x_reactor_init(x_reactor *r);
+int x_reactor_init_mux(x_reactor *r, const struct x_sockmux_ops_st *mux_ops);
 void x_reactor_clear(x_reactor *r);
 void x_reactor_free(x_reactor *r);
+int x_reactor_set_timer_store(x_reactor *r, int store);
+void x_reactor_set_busy_poll(x_reactor *r, uint32_t usec);
 int x_reactor_add(x_reactor *r, x_event *e);
+int x_reactor_modify(x_event *e);
 void x_reactor_pend(x_reactor *r, x_event *e, short res_flags);
 void x_reactor_remove(x_reactor *r, x_event *e);
 int x_reactor_wait(x_reactor *r);
 void x_reactor_signal(x_reactor *r);
+void x_reactor_raise(x_evobject *e, short res_flags);
 void x_reactor_break(x_reactor *r);
 x_event *x_reactor_pop_event(x_reactor *r);
+void x_reactor_enable_stats(x_reactor *r, bool enable);
+void x_reactor_reset_stats(x_reactor *r);
+const x_reactor_stats *x_reactor_get_stats(const x_reactor *r);
+x_json *x_reactor_stats_json(const x_reactor_stats *stats);
 
 #endif
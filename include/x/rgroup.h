@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_RGROUP_H
+#define X_RGROUP_H
+
+#include "types.h"
+#include "reactor.h"
+#include "listener.h"
+#include "thread.h"
+#include "mpsc.h"
+
+/*
+ * A group of reactors, each run by its own worker thread. Events of a loop
+ * are handed to on_event on that loop's thread, as the owner of the
+ * reactor it can add, modify and remove them without contention.
+ *
+ * Incoming connections are spread over the loops either round robin, where
+ * the first loop accepts and hands sockets to the others, or by giving every
+ * loop its own SO_REUSEPORT listener and letting the kernel balance them.
+ * Either way on_accept runs on the loop the socket belongs to. The
+ * listeners are x_listener, accepting up to their budget per turn.
+ */
+
+#define X_RGROUP_PIN 0x1 /* bind worker i to CPU i modulo the CPU count */
+
+enum {
+	X_RGROUP_ROUND_ROBIN,
+	X_RGROUP_REUSEPORT,
+};
+
+typedef void x_rgroup_event_fn(x_rgroup_loop *loop, x_event *e);
+typedef void x_rgroup_accept_fn(x_rgroup_loop *loop, x_sock sock);
+typedef void x_rgroup_msg_fn(x_rgroup_loop *loop, x_rgroup_msg *msg);
+
+/*
+ * Embedded by the sender, the channel never allocates. The message belongs
+ * to the receiving loop from x_rgroup_send until fn has been called.
+ */
+struct x_rgroup_msg_st
+{
+	x_mpsc_node node;
+	x_rgroup_msg_fn *fn;
+};
+
+struct x_rgroup_loop_st
+{
+	x_reactor reactor;
+	x_rgroup *group;
+	x_thread *thread;
+	int index;
+	void *data;
+
+	x_mpsc inbox;
+	x_evobject doorbell;
+	x_listener listener;
+
+	/* Sockets accepted by the first loop for this one, single producer */
+	x_sock *accepted;
+	unsigned accepted_head;
+	unsigned accepted_tail;
+};
+
+struct x_rgroup_st
+{
+	x_rgroup_loop *loops;
+	int loop_cnt;
+	int flags;
+	int dispatch;
+	unsigned next_loop;
+	bool running;
+	bool stopping;
+	x_rgroup_event_fn *on_event;
+	x_rgroup_accept_fn *on_accept;
+	void *arg;
+};
+
+int x_rgroup_init(x_rgroup *g, int nloops, int flags, x_rgroup_event_fn *on_event, void *arg);
+void x_rgroup_free(x_rgroup *g);
+int x_rgroup_listen(x_rgroup *g, const struct sockaddr *addr, socklen_t addrlen,
+		int dispatch, x_rgroup_accept_fn *on_accept);
+int x_rgroup_start(x_rgroup *g);
+void x_rgroup_stop(x_rgroup *g);
+void x_rgroup_send(x_rgroup_loop *to, x_rgroup_msg *msg);
+
+inline static x_rgroup_loop *x_rgroup_loop_at(x_rgroup *g, int index)
+{
+	return &g->loops[index];
+}
+
+#endif
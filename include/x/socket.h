@@ -62,7 +62,9 @@ int x_sock_close(x_sock fd);
 
 int x_sock_pair(int family, int type, int protocol, x_sock fd[2]);
 int x_sock_set_nonblocking(x_sock fd);
+x_sock x_sock_accept(x_sock sock, struct sockaddr *addr, socklen_t *addrlen);
 int x_sock_set_keepalive(x_sock sock, uint32_t idle_sec, uint32_t interval_sec);
+int x_sock_set_busy_poll(x_sock sock, uint32_t usec);
 
 int x_sock_sendall(x_sock sock, const void *data, size_t len);
 int x_sock_recvall(x_sock sock, void *buf, size_t len);
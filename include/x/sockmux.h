@@ -29,16 +29,22 @@
 
 struct x_sockmux_st;
 
+/*
+ * The ptr given to m_add / m_mod is stored in the backend (epoll data.ptr)
+ * and handed back by m_next for each ready socket, NULL ends the batch.
+ */
 struct x_sockmux_ops_st {
 	x_sockmux *(*m_create)(void);
-	int (*m_add)(x_sockmux *mux, x_sock fd, short flags);
-	int (*m_mod)(x_sockmux *mux, x_sock fd, short flags);
+	int (*m_add)(x_sockmux *mux, x_sock fd, short flags, void *ptr);
+	int (*m_mod)(x_sockmux *mux, x_sock fd, short flags, void *ptr);
 	void (*m_del)(x_sockmux *mux, x_sock fd, short flags);
 	int (*m_poll)(x_sockmux *mux, struct timeval * timeout);
 	void (*m_free)(x_sockmux *mux);
-	x_sock (*m_next)(x_sockmux *mux, short *res_flags);
+	void *(*m_next)(x_sockmux *mux, short *res_flags);
 };
 
 extern const struct x_sockmux_ops_st x_sockmux_epoll;
+/* m_create returns NULL when the kernel or build lacks io_uring */
+extern const struct x_sockmux_ops_st x_sockmux_uring;
 
 #endif
@@ -99,6 +99,8 @@ void *x_memdup(const void *p, size_t size);
 size_t x_strhash(const char *s);
 size_t x_wcshash(const wchar_t *s);
 size_t x_memhash(const void *p, size_t size);
+uint64_t x_memhash64(const void *p, size_t size, uint64_t seed);
+uint64_t x_strhash64(const char *s, uint64_t seed);
 size_t x_strnihash(const char *s, size_t len);
 size_t x_strihash(const char *s);
 char *x_strsplit(char **s, char ch);
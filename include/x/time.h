@@ -78,6 +78,7 @@
 int x_time_now(struct timeval *tv);
 int x_time_from_iso8601(const char *datetime, struct timeval *tv);
 uint64_t x_time_tick(void);
+uint64_t x_time_nsec(void);
 
 #endif
 
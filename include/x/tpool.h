@@ -30,6 +30,21 @@
 
 typedef void x_tpool_worker_f(void *arg);
 
+/*
+ * X_TPOOL_SHARED workers take work from one queue under work_mutex.
+ *
+ * X_TPOOL_STEALING gives every worker a Chase-Lev deque. Work added from a
+ * worker goes to its own deque, where it is taken LIFO by the owner and
+ * FIFO by idle workers stealing it, both without a lock. Work added from
+ * other threads goes to the shared queue, from which a worker takes a
+ * batch at a time. Only one sleeping worker is woken per addition, and
+ * only if there is one.
+ */
+enum {
+	X_TPOOL_SHARED,
+	X_TPOOL_STEALING,
+};
+
 struct x_tpool_st
 {
 	x_tpool_work *work_first, *work_last;
@@ -38,6 +53,12 @@ struct x_tpool_st
 	x_mutex work_mutex;
 	x_thread **thread_list;
 	bool stop;
+
+	int mode;
+	size_t work_cnt;
+	size_t idle_cnt;
+	struct x_tpool_worker_st *workers;
+	size_t worker_cnt;
 };
 
 struct x_tpool_work_st
@@ -50,6 +71,7 @@ struct x_tpool_work_st
 x_tpool_work *x_tpool_work_create(x_tpool_worker_f *func, void *arg);
 void x_tpool_work_free(x_tpool_work *work);
 int x_tpool_init(x_tpool *p, size_t num);
+int x_tpool_init_mode(x_tpool *p, size_t num, int mode);
 void x_tpool_destroy(x_tpool *tpool);
 void x_tpool_add_work(x_tpool *tpool, x_tpool_work *work);
 void x_tpool_wait(x_tpool *tpool);
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef X_TWHEEL_H
+#define X_TWHEEL_H
+
+#include "types.h"
+#include "list.h"
+#include <stdint.h>
+
+/*
+ * Hierarchical timing wheel. Level 0 has one slot per tick, every further
+ * level covers X_TWHEEL_SLOTS times the span of the one below it. Timers
+ * further out sit in coarse slots and are cascaded down as the wheel turns,
+ * so add, remove and expire are O(1) regardless of how many timers are
+ * pending. Ticks are caller defined (the reactor uses milliseconds);
+ * expirations beyond the span of the top level are clamped to it.
+ */
+
+#define X_TWHEEL_BITS   6
+#define X_TWHEEL_SLOTS  (1 << X_TWHEEL_BITS)
+#define X_TWHEEL_LEVELS 6
+
+struct x_twnode_st
+{
+	x_link link;
+	uint64_t expire;
+	uint32_t slot;
+};
+
+struct x_twheel_st
+{
+	uint64_t current;
+	size_t entry_cnt;
+	uint64_t occupied[X_TWHEEL_LEVELS];
+	x_list *slots;
+};
+
+void x_twheel_init(x_twheel *w, uint64_t now);
+void x_twheel_free(x_twheel *w);
+void x_twheel_add(x_twheel *w, x_twnode *n, uint64_t expire);
+void x_twheel_remove(x_twheel *w, x_twnode *n);
+size_t x_twheel_advance(x_twheel *w, uint64_t now, x_list *expired);
+uint64_t x_twheel_next(const x_twheel *w);
+
+static inline size_t x_twheel_size(const x_twheel *w)
+{
+	return w->entry_cnt;
+}
+
+static inline bool x_twnode_pending(const x_twnode *n)
+{
+	return n->link.next != NULL;
+}
+
+#endif
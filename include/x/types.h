@@ -96,6 +96,16 @@ typedef struct x_once_st x_once;
 typedef struct x_mset_st x_mset;
 #endif
 
+#ifndef X_MSET_STATS_DEFINED
+#define X_MSET_STATS_DEFINED
+typedef struct x_mset_stats_st x_mset_stats;
+#endif
+
+#ifndef X_MPOOL_DEFINED
+#define X_MPOOL_DEFINED
+typedef struct x_mpool_st x_mpool;
+#endif
+
 #ifndef X_MBLOCK_DEFINED
 #define X_MBLOCK_DEFINED
 typedef struct x_mblock_st x_mblock;
@@ -131,6 +141,81 @@ typedef struct x_ini_option_st x_ini_option;
 typedef struct x_heap_st x_heap;
 #endif
 
+#ifndef X_DHEAP_DEFINED
+#define X_DHEAP_DEFINED
+typedef struct x_dheap_st x_dheap;
+#endif
+
+#ifndef X_TWHEEL_DEFINED
+#define X_TWHEEL_DEFINED
+typedef struct x_twheel_st x_twheel;
+#endif
+
+#ifndef X_TWNODE_DEFINED
+#define X_TWNODE_DEFINED
+typedef struct x_twnode_st x_twnode;
+#endif
+
+#ifndef X_MPSC_DEFINED
+#define X_MPSC_DEFINED
+typedef struct x_mpsc_st x_mpsc;
+#endif
+
+#ifndef X_MPSC_NODE_DEFINED
+#define X_MPSC_NODE_DEFINED
+typedef struct x_mpsc_node_st x_mpsc_node;
+#endif
+
+#ifndef X_RGROUP_DEFINED
+#define X_RGROUP_DEFINED
+typedef struct x_rgroup_st x_rgroup;
+#endif
+
+#ifndef X_RGROUP_LOOP_DEFINED
+#define X_RGROUP_LOOP_DEFINED
+typedef struct x_rgroup_loop_st x_rgroup_loop;
+#endif
+
+#ifndef X_RGROUP_MSG_DEFINED
+#define X_RGROUP_MSG_DEFINED
+typedef struct x_rgroup_msg_st x_rgroup_msg;
+#endif
+
+#ifndef X_BUFEV_DEFINED
+#define X_BUFEV_DEFINED
+typedef struct x_bufev_st x_bufev;
+#endif
+
+#ifndef X_FIBER_DEFINED
+#define X_FIBER_DEFINED
+typedef struct x_fiber_st x_fiber;
+#endif
+
+#ifndef X_FIBER_SCHED_DEFINED
+#define X_FIBER_SCHED_DEFINED
+typedef struct x_fiber_sched_st x_fiber_sched;
+#endif
+
+#ifndef X_LISTENER_DEFINED
+#define X_LISTENER_DEFINED
+typedef struct x_listener_st x_listener;
+#endif
+
+#ifndef X_DGRAM_MSG_DEFINED
+#define X_DGRAM_MSG_DEFINED
+typedef struct x_dgram_msg_st x_dgram_msg;
+#endif
+
+#ifndef X_HIST_DEFINED
+#define X_HIST_DEFINED
+typedef struct x_hist_st x_hist;
+#endif
+
+#ifndef X_REACTOR_STATS_DEFINED
+#define X_REACTOR_STATS_DEFINED
+typedef struct x_reactor_stats_st x_reactor_stats;
+#endif
+
 #ifndef X_DUMP_DEFINED
 #define X_DUMP_DEFINED
 typedef struct x_dump_st x_dump;
@@ -211,6 +296,16 @@ typedef struct x_file_st x_file;
 typedef struct x_hmap_st x_hmap;
 #endif
 
+#ifndef X_CHMAP_DEFINED
+#define X_CHMAP_DEFINED
+typedef struct x_chmap_st x_chmap;
+#endif
+
+#ifndef X_OHMAP_DEFINED
+#define X_OHMAP_DEFINED
+typedef struct x_ohmap_st x_ohmap;
+#endif
+
 #ifndef X_RANODE_DEFINED
 #define X_RANODE_DEFINED
 typedef struct x_ranode_st x_ranode;
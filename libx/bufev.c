@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "x/bufev.h"
+#include "x/reactor.h"
+#include "x/socket.h"
+#include "x/memory.h"
+#include "x/macros.h"
+#include "x/errno.h"
+#ifdef X_OS_WIN32
+#include <winsock2.h>
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef X_OS_LINUX
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#endif
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+/* sendfile moves at most 0x7ffff000 bytes per call */
+#define XFER_CHUNK ((size_t)1 << 30)
+#define XFER_COPY_SIZE 16384
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifdef X_OS_WIN32
+typedef WSABUF bufev_iov;
+#define IOV_SET(v, p, n) ((v).buf = (CHAR *)(p), (v).len = (ULONG)(n))
+
+static long sock_readv(x_sock sock, bufev_iov *iov, int cnt)
+{
+	DWORD n, flags = 0;
+	if (WSARecv(sock, iov, cnt, &n, &flags, NULL, NULL))
+		return -1;
+	return (long)n;
+}
+
+static long sock_writev(x_sock sock, bufev_iov *iov, int cnt)
+{
+	DWORD n;
+	if (WSASend(sock, iov, cnt, &n, 0, NULL, NULL))
+		return -1;
+	return (long)n;
+}
+#else
+typedef struct iovec bufev_iov;
+#define IOV_SET(v, p, n) ((v).iov_base = (p), (v).iov_len = (n))
+
+static long sock_readv(x_sock sock, bufev_iov *iov, int cnt)
+{
+	return readv(sock, iov, cnt);
+}
+
+static long sock_writev(x_sock sock, bufev_iov *iov, int cnt)
+{
+	/* sendmsg rather than writev, a closed peer must not raise SIGPIPE */
+	struct msghdr msg;
+	memset(&msg, 0, sizeof msg);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = cnt;
+	return sendmsg(sock, &msg, MSG_NOSIGNAL);
+}
+#endif
+
+static bool sock_would_block(void)
+{
+	int err = x_sock_errno();
+	return err == X_SOCK_ERR(EWOULDBLOCK) || err == EAGAIN;
+}
+
+/*
+ * The free space of a ring as up to two regions in the order they fill:
+ * from rear to the end of the buffer, then from its start up to front.
+ */
+static int pipe_space_iov(x_pipe *p, bufev_iov iov[2], size_t limit)
+{
+	size_t size1 = x_min(x_pipe_zwrite_size(p), limit);
+	size_t size2 = (p->rear >= p->front && p->front > 0) ? p->front - 1 : 0;
+	size2 = x_min(size2, limit - size1);
+	IOV_SET(iov[0], x_pipe_zwrite(p), size1);
+	IOV_SET(iov[1], p->buf, size2);
+	return size2 ? 2 : 1;
+}
+
+static void pipe_space_commit(x_pipe *p, size_t size)
+{
+	size_t size1 = x_min(size, x_pipe_zwrite_size(p));
+	x_pipe_zwrite_commit(p, size1);
+	if (size > size1)
+		x_pipe_zwrite_commit(p, size - size1);
+}
+
+/* Likewise the data of a ring, from front, then wrapped around up to rear */
+static int pipe_data_iov(x_pipe *p, bufev_iov iov[2], size_t limit)
+{
+	size_t size1 = x_min(x_pipe_zread_size(p), limit);
+	size_t size2 = p->rear < p->front ? p->rear : 0;
+	size2 = x_min(size2, limit - size1);
+	IOV_SET(iov[0], x_pipe_zread(p), size1);
+	IOV_SET(iov[1], p->buf, size2);
+	return size2 ? 2 : 1;
+}
+
+static void pipe_data_commit(x_pipe *p, size_t size)
+{
+	size_t size1 = x_min(size, x_pipe_zread_size(p));
+	x_pipe_zread_commit(p, size1);
+	if (size > size1)
+		x_pipe_zread_commit(p, size - size1);
+}
+
+static size_t bufev_room(x_bufev *bev)
+{
+	size_t room = x_pipe_buffer_size(&bev->input);
+	if (bev->read_high) {
+		size_t data = x_pipe_data_size(&bev->input);
+		room = x_min(room, bev->read_high > data ? bev->read_high - data : 0);
+	}
+	return room;
+}
+
+/* Ask the reactor for exactly what the rings need, only if that changed */
+static void bufev_update(x_bufev *bev)
+{
+	short flags = bev->ev.base.ev_flags & ~(X_EV_READ | X_EV_WRITE);
+	if (!bev->paused && !bev->eof)
+		flags |= X_EV_READ;
+	/*
+	 * During a transfer only the output ahead of the file and the file
+	 * itself can go out, the latter unless it waits for a pipe. A finished
+	 * transfer is reported from the next write readiness.
+	 */
+	if (bev->xfer_fd != -1) {
+		if (bev->xfer_skip || !bev->xfer_wait_src)
+			flags |= X_EV_WRITE;
+	}
+	else if (!x_pipe_is_empty(&bev->output) || bev->xfer_done)
+		flags |= X_EV_WRITE;
+	if (flags == bev->ev.base.ev_flags)
+		return;
+	bev->ev.base.ev_flags = flags;
+	(void)x_reactor_modify(&bev->ev.base);
+}
+
+/*
+ * A level triggered socket is read once per wakeup, a short read means the
+ * socket is empty and asking again would only return EAGAIN. An edge
+ * triggered one is read until EAGAIN as it is not reported again.
+ */
+static short bufev_fill(x_bufev *bev)
+{
+	bufev_iov iov[2];
+	size_t room;
+	while ((room = bufev_room(bev))) {
+		int cnt = pipe_space_iov(&bev->input, iov, room);
+		long n = sock_readv(bev->ev.sock, iov, cnt);
+		if (n > 0) {
+			pipe_space_commit(&bev->input, n);
+			if ((size_t)n < room && !(bev->ev.base.ev_flags & X_EV_EDGE))
+				break;
+			continue;
+		}
+		if (n == 0) {
+			bev->eof = true;
+			return X_BUFEV_EOF;
+		}
+		if (sock_would_block())
+			break;
+		if (x_sock_errno() == X_SOCK_ERR(EINTR))
+			continue;
+		return X_BUFEV_ERROR;
+	}
+	bev->paused = bufev_room(bev) == 0;
+	return 0;
+}
+
+int x_bufev_init(x_bufev *bev, x_reactor *r, x_sock sock, size_t in_size, size_t out_size)
+{
+	assert(bev != NULL && r != NULL);
+	assert(in_size > 0 && out_size > 0);
+	memset(bev, 0, sizeof *bev);
+	/* A ring of n bytes holds n - 1 */
+	x_pipe_init(&bev->input, x_malloc(NULL, in_size + 1), in_size + 1);
+	x_pipe_init(&bev->output, x_malloc(NULL, out_size + 1), out_size + 1);
+	bev->reactor = r;
+	bev->xfer_fd = -1;
+	x_evsocket_init(&bev->ev, sock, X_EV_READ, bev);
+	if (x_reactor_add(r, &bev->ev.base)) {
+		x_free(bev->input.buf);
+		x_free(bev->output.buf);
+		return -1;
+	}
+	return 0;
+}
+
+void x_bufev_free(x_bufev *bev)
+{
+	if (!bev)
+		return;
+	if (bev->ev.base.ev_flags & X_EV_REACTING)
+		x_reactor_remove(bev->reactor, &bev->ev.base);
+	if (bev->xfer_src.base.ev_flags & X_EV_REACTING)
+		x_reactor_remove(bev->reactor, &bev->xfer_src.base);
+	x_free(bev->input.buf);
+	x_free(bev->output.buf);
+	bev->input.buf = bev->output.buf = NULL;
+}
+
+void x_bufev_set_callbacks(x_bufev *bev, x_bufev_fn *on_read, x_bufev_fn *on_write,
+		x_bufev_event_fn *on_event, void *arg)
+{
+	assert(bev != NULL);
+	bev->on_read = on_read;
+	bev->on_write = on_write;
+	bev->on_event = on_event;
+	bev->arg = arg;
+}
+
+void x_bufev_set_watermark(x_bufev *bev, short what, size_t low, size_t high)
+{
+	assert(bev != NULL);
+	if (what & X_EV_READ) {
+		bev->read_low = low;
+		bev->read_high = high;
+		bev->paused = bufev_room(bev) == 0;
+	}
+	if (what & X_EV_WRITE)
+		bev->write_low = low;
+	if (!bev->dispatching)
+		bufev_update(bev);
+}
+
+/* Sends up to limit bytes of the output ring, returns how many went out */
+static long bufev_send_ring(x_bufev *bev, size_t limit)
+{
+	bufev_iov iov[2];
+	size_t sent = 0;
+	while (sent < limit && !x_pipe_is_empty(&bev->output)) {
+		size_t size = x_min(x_pipe_data_size(&bev->output), limit - sent);
+		int cnt = pipe_data_iov(&bev->output, iov, size);
+		long n = sock_writev(bev->ev.sock, iov, cnt);
+		if (n > 0) {
+			pipe_data_commit(&bev->output, n);
+			sent += n;
+			/* The socket buffer is full, don't ask just to get EAGAIN */
+			if ((size_t)n < size)
+				break;
+			continue;
+		}
+		if (n < 0 && sock_would_block())
+			break;
+		if (n < 0 && x_sock_errno() == X_SOCK_ERR(EINTR))
+			continue;
+		return -1;
+	}
+	return (long)sent;
+}
+
+static long file_pread(int fd, void *buf, size_t size, uint64_t offset)
+{
+#ifdef X_OS_WIN32
+	if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0)
+		return -1;
+	return _read(fd, buf, (unsigned)size);
+#else
+	return pread(fd, buf, size, (off_t)offset);
+#endif
+}
+
+/* Read and send, what the socket did not take is read again next time */
+static long xfer_copy(x_bufev *bev, size_t size)
+{
+	char buf[XFER_COPY_SIZE];
+	bufev_iov iov;
+	long n = file_pread(bev->xfer_fd, buf, x_min(size, sizeof buf), bev->xfer_off);
+	if (n <= 0)
+		return n;
+	IOV_SET(iov, buf, n);
+	return sock_writev(bev->ev.sock, &iov, 1);
+}
+
+#ifdef X_OS_LINUX
+static long xfer_zero_copy(x_bufev *bev, size_t size)
+{
+	if (bev->xfer_pipe)
+		return splice(bev->xfer_fd, NULL, bev->ev.sock, NULL, size,
+				SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+	off_t offset = (off_t)bev->xfer_off;
+	return sendfile(bev->ev.sock, bev->xfer_fd, &offset, size);
+}
+
+static int bufev_wait_src(x_bufev *bev)
+{
+	x_evsocket_init(&bev->xfer_src, bev->xfer_fd, X_EV_READ, bev);
+	if (x_reactor_add(bev->reactor, &bev->xfer_src.base))
+		return -1;
+	bev->xfer_wait_src = true;
+	return 0;
+}
+#endif
+
+static int bufev_send_file(x_bufev *bev)
+{
+	while (bev->xfer_left) {
+		size_t size = bev->xfer_left > XFER_CHUNK ? XFER_CHUNK : (size_t)bev->xfer_left;
+#ifdef X_OS_LINUX
+		long n = bev->xfer_copy ? xfer_copy(bev, size) : xfer_zero_copy(bev, size);
+#else
+		long n = xfer_copy(bev, size);
+#endif
+		if (n > 0) {
+			bev->xfer_off += n;
+			bev->xfer_left -= n;
+			/* A pipe may just have had less, only a file says the socket is full */
+			if ((size_t)n < size && !bev->xfer_pipe)
+				break;
+			continue;
+		}
+		/* The source ended early */
+		if (n == 0) {
+			bev->xfer_left = 0;
+			break;
+		}
+		if (x_sock_errno() == X_SOCK_ERR(EINTR))
+			continue;
+#ifdef X_OS_LINUX
+		/*
+		 * Either end of a splice may be the one that is not ready, wait for
+		 * the one that did not just wake us up. That costs one extra wakeup
+		 * at worst and never spins on a writable socket with an empty pipe.
+		 */
+		if (bev->xfer_pipe && sock_would_block())
+			return bev->xfer_from_src ? 0 : bufev_wait_src(bev);
+		/* Not a file sendfile can read from, copy it instead */
+		if (!bev->xfer_copy && !bev->xfer_pipe && (errno == EINVAL || errno == ENOSYS)) {
+			bev->xfer_copy = true;
+			continue;
+		}
+#endif
+		if (sock_would_block())
+			break;
+		return -1;
+	}
+	if (!bev->xfer_left) {
+		bev->xfer_fd = -1;
+		bev->xfer_done = true;
+	}
+	return 0;
+}
+
+int x_bufev_flush(x_bufev *bev)
+{
+	int retval = 0;
+	assert(bev != NULL);
+	/* The output written before the file, the file, then the output after it */
+	if (bev->xfer_fd != -1 && !bev->xfer_wait_src) {
+		long n = bufev_send_ring(bev, bev->xfer_skip);
+		if (n < 0)
+			retval = -1;
+		else if (!(bev->xfer_skip -= n))
+			retval = bufev_send_file(bev);
+	}
+	if (retval == 0 && bev->xfer_fd == -1 && bufev_send_ring(bev, SIZE_MAX) < 0)
+		retval = -1;
+	if (!bev->dispatching)
+		bufev_update(bev);
+	return retval;
+}
+
+int x_bufev_sendfile(x_bufev *bev, int fd, uint64_t offset, uint64_t length)
+{
+	bool is_pipe = false;
+	assert(bev != NULL && fd >= 0);
+	if (bev->xfer_fd != -1 || bev->xfer_done) {
+		errno = X_EBUSY;
+		return -1;
+	}
+#ifndef X_OS_WIN32
+	struct stat st;
+	if (fstat(fd, &st))
+		return -1;
+	is_pipe = S_ISFIFO(st.st_mode);
+#endif
+#ifndef X_OS_LINUX
+	/* Nothing but splice can send from a pipe without reading it first */
+	if (is_pipe) {
+		errno = X_EINVAL;
+		return -1;
+	}
+	bev->xfer_copy = true;
+#else
+	bev->xfer_copy = false;
+#endif
+	bev->xfer_fd = fd;
+	bev->xfer_off = offset;
+	bev->xfer_left = length;
+	bev->xfer_skip = x_pipe_data_size(&bev->output);
+	bev->xfer_pipe = is_pipe;
+	bev->xfer_wait_src = false;
+	bev->xfer_from_src = false;
+	if (bev->dispatching)
+		return 0;
+	return x_bufev_flush(bev);
+}
+
+size_t x_bufev_write(x_bufev *bev, const void *data, size_t size)
+{
+	assert(bev != NULL && data != NULL);
+	size_t written = x_pipe_write(&bev->output, (void *)data, size);
+	if (!bev->dispatching)
+		(void)x_bufev_flush(bev);
+	return written;
+}
+
+static void bufev_consumed(x_bufev *bev)
+{
+	if (bev->paused && bufev_room(bev)) {
+		bev->paused = false;
+		if (!bev->dispatching)
+			bufev_update(bev);
+	}
+}
+
+size_t x_bufev_read(x_bufev *bev, void *buf, size_t size)
+{
+	assert(bev != NULL && buf != NULL);
+	size_t n = x_pipe_read(&bev->input, buf, size);
+	bufev_consumed(bev);
+	return n;
+}
+
+size_t x_bufev_drain(x_bufev *bev, size_t size)
+{
+	assert(bev != NULL);
+	size_t n = x_pipe_read(&bev->input, NULL, size);
+	bufev_consumed(bev);
+	return n;
+}
+
+void x_bufev_dispatch(x_event *e)
+{
+	assert(e != NULL && e->type == X_EVENT_SOCKET);
+	/* Both the socket and the pipe a transfer waits for point to bev */
+	x_bufev *bev = e->data;
+	short what = 0;
+	bev->dispatching = true;
+	if (e == &bev->xfer_src.base) {
+		x_reactor_remove(bev->reactor, e);
+		bev->xfer_wait_src = false;
+		bev->xfer_from_src = true;
+		if (x_bufev_flush(bev))
+			what |= X_BUFEV_ERROR;
+		bev->xfer_from_src = false;
+	}
+	else if (e->res_flags & X_EV_WRITE) {
+		if (x_bufev_flush(bev))
+			what |= X_BUFEV_ERROR;
+		else if (bev->on_write && bev->xfer_fd == -1
+				&& x_pipe_data_size(&bev->output) <= bev->write_low)
+			bev->on_write(bev, bev->arg);
+	}
+	if (e == &bev->ev.base && (e->res_flags & (X_EV_READ | X_EV_ERROR)) && !bev->eof) {
+		what |= bufev_fill(bev);
+		if (bev->on_read && !x_pipe_is_empty(&bev->input)
+				&& x_pipe_data_size(&bev->input) >= bev->read_low)
+			bev->on_read(bev, bev->arg);
+	}
+	bev->dispatching = false;
+	/* Whatever the callbacks wrote goes out in one go */
+	if (!(what & X_BUFEV_ERROR) && !x_pipe_is_empty(&bev->output) && x_bufev_flush(bev))
+		what |= X_BUFEV_ERROR;
+	if (bev->xfer_done) {
+		bev->xfer_done = false;
+		what |= X_BUFEV_SENDFILE;
+	}
+	bufev_update(bev);
+	if (what && bev->on_event)
+		bev->on_event(bev, what, bev->arg);
+}
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/chmap.h"
+#include "x/hmap.h"
+#include "x/list.h"
+#include "x/mutex.h"
+#include "x/once.h"
+#include "x/tss.h"
+#include "x/thread.h"
+#include "x/memory.h"
+#include "x/atomic.h"
+#include "x/sys.h"
+#include <assert.h>
+
+#define READ_RETRIES 4
+#define SPINS_BEFORE_YIELD 64
+
+struct table
+{
+	x_link retire;
+	x_hmap ht;
+};
+
+struct x_chmap_shard_st
+{
+	x_mutex lock;
+	uint32_t seq;
+	float load_factor;
+	struct table *table;
+	struct table *growing;
+	char pad[X_CACHE_LINE_SIZE];
+};
+
+struct reader
+{
+	x_link link;
+	uint64_t epoch;
+	unsigned depth;
+	char pad[X_CACHE_LINE_SIZE];
+};
+
+static x_once s_once = X_ONCE_INIT;
+static x_tss s_reader_key;
+static x_mutex s_readers_lock;
+static x_list s_readers;
+static x_mutex s_retired_lock;
+static x_list s_retired;
+static uint64_t s_epoch = 1;
+
+static void reader_free(void *ptr)
+{
+	struct reader *r = ptr;
+	x_mutex_lock(&s_readers_lock);
+	x_list_del(&r->link);
+	x_mutex_unlock(&s_readers_lock);
+	x_free(r);
+}
+
+static void global_init(void)
+{
+	x_mutex_init(&s_readers_lock);
+	x_mutex_init(&s_retired_lock);
+	x_list_init(&s_readers);
+	x_list_init(&s_retired);
+	x_tss_init(&s_reader_key, reader_free);
+}
+
+static struct reader *reader_get(void)
+{
+	x_once_init(&s_once, global_init);
+	struct reader *r = x_tss_get(&s_reader_key);
+	if (!r) {
+		r = x_zalloc(NULL, sizeof *r);
+		x_mutex_lock(&s_readers_lock);
+		x_list_add_back(&s_readers, &r->link);
+		x_mutex_unlock(&s_readers_lock);
+		x_tss_set(&s_reader_key, r);
+	}
+	return r;
+}
+
+void x_chmap_read_enter(void)
+{
+	struct reader *r = reader_get();
+	if (r->depth++ == 0) {
+		/* A full barrier pairing with x_chmap_synchronize(), either the
+		 * writer sees this epoch or the reader sees the unlinked state.
+		 * A locked exchange is cheaper than store + mfence on x86 */
+		(void)x_atomic_exchange(&r->epoch, x_atomic_load(&s_epoch, X_ATOMIC_RELAXED), X_ATOMIC_SEQ_CST);
+	}
+}
+
+void x_chmap_read_leave(void)
+{
+	struct reader *r = x_tss_get(&s_reader_key);
+	assert(r && r->depth);
+	if (--r->depth == 0)
+		x_atomic_store(&r->epoch, 0, X_ATOMIC_RELEASE);
+}
+
+static bool in_read_section(void)
+{
+	struct reader *r = x_tss_get(&s_reader_key);
+	return r && r->depth;
+}
+
+void x_chmap_synchronize(void)
+{
+	x_once_init(&s_once, global_init);
+	assert(!in_read_section());
+
+	x_list retired;
+	x_list_init(&retired);
+	x_mutex_lock(&s_retired_lock);
+	x_list_popeach(cur, &s_retired)
+		x_list_add_back(&retired, cur);
+	x_mutex_unlock(&s_retired_lock);
+
+	x_atomic_fence(X_ATOMIC_SEQ_CST);
+	uint64_t target = x_atomic_fetch_add(&s_epoch, 1, X_ATOMIC_SEQ_CST) + 1;
+
+	x_mutex_lock(&s_readers_lock);
+	x_list_foreach(cur, &s_readers) {
+		struct reader *r = x_container_of(cur, struct reader, link);
+		uint64_t epoch;
+		int spins = 0;
+		while ((epoch = x_atomic_load(&r->epoch, X_ATOMIC_ACQUIRE)) && epoch < target) {
+			if (++spins < SPINS_BEFORE_YIELD)
+				x_cpu_relax();
+			else
+				x_thread_yield();
+		}
+	}
+	x_mutex_unlock(&s_readers_lock);
+
+	x_list_popeach(cur, &retired) {
+		struct table *t = x_container_of(cur, struct table, retire);
+		x_hmap_free(&t->ht);
+		x_free(t);
+	}
+}
+
+static void retire(struct table *t)
+{
+	x_mutex_lock(&s_retired_lock);
+	x_list_add_back(&s_retired, &t->retire);
+	x_mutex_unlock(&s_retired_lock);
+	/* A thread inside a read section would wait for itself, the table is
+	 * released by the next synchronize call instead */
+	if (!in_read_section())
+		x_chmap_synchronize();
+}
+
+static struct table *table_new(x_chmap *cm, float load_factor, size_t elem_cnt)
+{
+	struct table *t = x_malloc(NULL, sizeof *t);
+	x_link_init(&t->retire);
+	x_hmap_init(&t->ht, load_factor, cm->hash, cm->equal);
+	if (elem_cnt)
+		x_hmap_reserve(&t->ht, elem_cnt);
+	return t;
+}
+
+static inline void seq_begin(struct x_chmap_shard_st *sh)
+{
+	x_atomic_store(&sh->seq, sh->seq + 1, X_ATOMIC_RELAXED);
+	x_atomic_fence(X_ATOMIC_RELEASE);
+}
+
+static inline void seq_end(struct x_chmap_shard_st *sh)
+{
+	x_atomic_store(&sh->seq, sh->seq + 1, X_ATOMIC_RELEASE);
+}
+
+static inline struct x_chmap_shard_st *shard_of(x_chmap *cm, size_t hash)
+{
+	uint64_t h = (uint64_t)hash * 0x9E3779B97F4A7C15ULL;
+	return cm->shards + ((h >> 32) & cm->shard_mask);
+}
+
+/*
+ * Called with the shard locked. The shard table is not grown in place by
+ * x_hmap, instead the nodes are moved into a new table which is published
+ * once complete; readers never see a freed bucket array.
+ */
+static struct table *shard_grow(x_chmap *cm, struct x_chmap_shard_st *sh)
+{
+	struct table *old = sh->table;
+	struct table *t = table_new(cm, sh->load_factor, old->ht.elem_cnt * 2);
+	x_atomic_store(&sh->growing, t, X_ATOMIC_RELEASE);
+	seq_begin(sh);
+	for (size_t i = 0; i < old->ht.slot_cnt; i++) {
+		x_list *list = old->ht.table + i;
+		if (!list->head.next)
+			continue;
+		while (!x_list_is_empty(list)) {
+			x_link *cur = list->head.next;
+			x_list_del(cur);
+			x_hmap_find_or_insert(&t->ht, cur);
+		}
+	}
+	old->ht.elem_cnt = 0;
+	x_atomic_store(&sh->table, t, X_ATOMIC_RELEASE);
+	seq_end(sh);
+	x_atomic_store(&sh->growing, NULL, X_ATOMIC_RELEASE);
+	return old;
+}
+
+static inline bool is_bucket_head(const x_hmap *ht, const x_link *link)
+{
+	const char *p = (const char *)link, *base = (const char *)ht->table;
+	return p >= base && p < base + ht->slot_cnt * sizeof(x_list);
+}
+
+/*
+ * Optimistic lookup, must run inside a read section. The chain is walked
+ * with plain loads while writers may be relinking it: every pointer seen
+ * is either NULL (unlinked), a live or retired node, or a bucket head of
+ * the current or growing table, and the walk stops at anything but a node.
+ * The result is only trusted if the sequence counter did not move.
+ */
+static x_link *shard_lookup(x_chmap *cm, struct x_chmap_shard_st *sh, const x_link *link, size_t hash)
+{
+	for (int attempt = 0; attempt < READ_RETRIES; attempt++) {
+		uint32_t seq = x_atomic_load(&sh->seq, X_ATOMIC_ACQUIRE);
+		if (seq & 1) {
+			x_cpu_relax();
+			continue;
+		}
+		struct table *t = x_atomic_load(&sh->table, X_ATOMIC_ACQUIRE);
+		struct table *g = x_atomic_load(&sh->growing, X_ATOMIC_ACQUIRE);
+		size_t limit = x_atomic_load(&t->ht.elem_cnt, X_ATOMIC_RELAXED) + 1;
+		x_list *list = t->ht.table + hash % t->ht.slot_cnt;
+		x_link *cur = x_atomic_load(&list->head.next, X_ATOMIC_RELAXED), *found = NULL;
+		while (cur && limit-- && !is_bucket_head(&t->ht, cur) && !(g && is_bucket_head(&g->ht, cur))) {
+			if (cm->equal(link, cur)) {
+				found = cur;
+				break;
+			}
+			cur = x_atomic_load(&cur->next, X_ATOMIC_RELAXED);
+		}
+		x_atomic_fence(X_ATOMIC_ACQUIRE);
+		if (x_atomic_load(&sh->seq, X_ATOMIC_RELAXED) == seq)
+			return found;
+	}
+	x_mutex_lock(&sh->lock);
+	x_link *found = x_hmap_find(&sh->table->ht, link);
+	x_mutex_unlock(&sh->lock);
+	return found;
+}
+
+int x_chmap_init(x_chmap *cm, size_t shard_cnt, float load_factor, x_hmap_hash_fn *hash_fn, x_hmap_equal_fn *equal_fn)
+{
+	x_once_init(&s_once, global_init);
+	if (!shard_cnt)
+		shard_cnt = x_sys_nprocs() * 4;
+	size_t cnt = 1;
+	while (cnt < shard_cnt)
+		cnt <<= 1;
+	cm->hash = hash_fn;
+	cm->equal = equal_fn;
+	cm->shard_mask = cnt - 1;
+	cm->shards = x_malloc(NULL, cnt * sizeof *cm->shards);
+	for (size_t i = 0; i < cnt; i++) {
+		struct x_chmap_shard_st *sh = cm->shards + i;
+		x_mutex_init(&sh->lock);
+		sh->seq = 0;
+		sh->load_factor = load_factor;
+		sh->table = table_new(cm, load_factor, 0);
+		sh->growing = NULL;
+	}
+	return 0;
+}
+
+x_link *x_chmap_find(x_chmap *cm, const x_link *link)
+{
+	size_t hash = cm->hash(link);
+	x_chmap_read_enter();
+	x_link *found = shard_lookup(cm, shard_of(cm, hash), link, hash);
+	x_chmap_read_leave();
+	return found;
+}
+
+static inline void link_publish_init(x_link *link)
+{
+	/* A reader reaching the new node before its links are stored must see
+	 * NULL rather than stale memory */
+	x_atomic_store(&link->next, NULL, X_ATOMIC_RELAXED);
+	x_atomic_store(&link->prev, NULL, X_ATOMIC_RELAXED);
+	x_atomic_fence(X_ATOMIC_RELEASE);
+}
+
+x_link *x_chmap_find_or_insert(x_chmap *cm, x_link *link)
+{
+	struct x_chmap_shard_st *sh = shard_of(cm, cm->hash(link));
+	struct table *old = NULL;
+	x_mutex_lock(&sh->lock);
+	x_link *found = x_hmap_find(&sh->table->ht, link);
+	if (!found) {
+		if (sh->table->ht.elem_cnt >= sh->table->ht.load_limit)
+			old = shard_grow(cm, sh);
+		link_publish_init(link);
+		seq_begin(sh);
+		x_hmap_find_or_insert(&sh->table->ht, link);
+		seq_end(sh);
+	}
+	x_mutex_unlock(&sh->lock);
+	if (old)
+		retire(old);
+	return found;
+}
+
+x_link *x_chmap_replace_or_insert(x_chmap *cm, x_link *link)
+{
+	struct x_chmap_shard_st *sh = shard_of(cm, cm->hash(link));
+	struct table *old = NULL;
+	x_mutex_lock(&sh->lock);
+	if (sh->table->ht.elem_cnt >= sh->table->ht.load_limit)
+		old = shard_grow(cm, sh);
+	link_publish_init(link);
+	seq_begin(sh);
+	x_link *found = x_hmap_replace_or_insert(&sh->table->ht, link);
+	seq_end(sh);
+	x_mutex_unlock(&sh->lock);
+	if (old)
+		retire(old);
+	return found;
+}
+
+x_link *x_chmap_find_and_remove(x_chmap *cm, const x_link *link)
+{
+	struct x_chmap_shard_st *sh = shard_of(cm, cm->hash(link));
+	x_mutex_lock(&sh->lock);
+	seq_begin(sh);
+	x_link *found = x_hmap_find_and_remove(&sh->table->ht, link);
+	seq_end(sh);
+	x_mutex_unlock(&sh->lock);
+	return found;
+}
+
+void x_chmap_remove(x_chmap *cm, x_link *link)
+{
+	struct x_chmap_shard_st *sh = shard_of(cm, cm->hash(link));
+	x_mutex_lock(&sh->lock);
+	seq_begin(sh);
+	x_hmap_remove(&sh->table->ht, link);
+	seq_end(sh);
+	x_mutex_unlock(&sh->lock);
+}
+
+size_t x_chmap_count(x_chmap *cm)
+{
+	size_t cnt = 0;
+	for (size_t i = 0; i <= cm->shard_mask; i++) {
+		struct table *t = x_atomic_load(&cm->shards[i].table, X_ATOMIC_ACQUIRE);
+		cnt += x_atomic_load(&t->ht.elem_cnt, X_ATOMIC_RELAXED);
+	}
+	return cnt;
+}
+
+void x_chmap_free(x_chmap *cm)
+{
+	for (size_t i = 0; i <= cm->shard_mask; i++) {
+		struct x_chmap_shard_st *sh = cm->shards + i;
+		x_hmap_free(&sh->table->ht);
+		x_free(sh->table);
+		x_mutex_destroy(&sh->lock);
+	}
+	x_free(cm->shards);
+	x_chmap_synchronize();
+}
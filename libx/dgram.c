@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "x/dgram.h"
+#include "x/errno.h"
+#include "x/macros.h"
+#ifndef X_OS_WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#ifdef X_OS_LINUX
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
+/* Messages per system call, their headers live on the stack */
+#define DGRAM_BATCH 64
+
+#ifdef X_OS_WIN32
+
+static int dgram_recv_one(x_sock sock, x_dgram_msg *m, bool wait)
+{
+	DWORD n, flags = 0;
+	INT addrlen = m->addr ? (INT)m->addrlen : 0;
+	(void)wait;
+	if (WSARecvFrom(sock, m->iov, (DWORD)m->iovcnt, &n, &flags, m->addr,
+				m->addr ? &addrlen : NULL, NULL, NULL)) {
+		if (WSAGetLastError() != WSAEMSGSIZE)
+			return -1;
+		flags |= MSG_PARTIAL;
+	}
+	m->len = n;
+	m->addrlen = addrlen;
+	m->segment = 0;
+	m->truncated = (flags & MSG_PARTIAL) != 0;
+	return 0;
+}
+
+static int dgram_send_one(x_sock sock, x_dgram_msg *m)
+{
+	DWORD n;
+	if (m->segment) {
+		WSASetLastError(WSAEOPNOTSUPP);
+		return -1;
+	}
+	if (WSASendTo(sock, m->iov, (DWORD)m->iovcnt, &n, 0, m->addr,
+				m->addr ? (int)m->addrlen : 0, NULL, NULL))
+		return -1;
+	m->len = n;
+	return 0;
+}
+
+#else
+
+union dgram_cmsg
+{
+	char buf[CMSG_SPACE(sizeof(int))];
+	size_t align; /* of struct cmsghdr */
+};
+
+static void dgram_to_hdr(x_dgram_msg *m, struct msghdr *h, union dgram_cmsg *cmsg, bool sending)
+{
+	memset(h, 0, sizeof *h);
+	h->msg_name = m->addr;
+	h->msg_namelen = m->addr ? m->addrlen : 0;
+	h->msg_iov = m->iov;
+	h->msg_iovlen = m->iovcnt;
+#ifdef X_OS_LINUX
+	if (!sending) {
+		h->msg_control = cmsg->buf;
+		h->msg_controllen = sizeof cmsg->buf;
+	}
+	else if (m->segment) {
+		h->msg_control = cmsg->buf;
+		h->msg_controllen = CMSG_SPACE(sizeof m->segment);
+		struct cmsghdr *c = CMSG_FIRSTHDR(h);
+		c->cmsg_level = SOL_UDP;
+		c->cmsg_type = UDP_SEGMENT;
+		c->cmsg_len = CMSG_LEN(sizeof m->segment);
+		memcpy(CMSG_DATA(c), &m->segment, sizeof m->segment);
+	}
+#else
+	(void)cmsg;
+	(void)sending;
+#endif
+}
+
+static void dgram_from_hdr(x_dgram_msg *m, struct msghdr *h, size_t len)
+{
+	m->len = len;
+	if (m->addr)
+		m->addrlen = h->msg_namelen;
+	m->truncated = (h->msg_flags & MSG_TRUNC) != 0;
+	m->segment = 0;
+#ifdef X_OS_LINUX
+	for (struct cmsghdr *c = CMSG_FIRSTHDR(h); c; c = CMSG_NXTHDR(h, c)) {
+		if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO) {
+			int size;
+			memcpy(&size, CMSG_DATA(c), sizeof size);
+			m->segment = (uint16_t)size;
+		}
+	}
+#endif
+}
+
+#ifndef X_OS_LINUX
+static int dgram_recv_one(x_sock sock, x_dgram_msg *m, bool wait)
+{
+	struct msghdr h;
+	dgram_to_hdr(m, &h, NULL, false);
+	ssize_t n = recvmsg(sock, &h, wait ? 0 : MSG_DONTWAIT);
+	if (n < 0)
+		return -1;
+	dgram_from_hdr(m, &h, n);
+	return 0;
+}
+
+static int dgram_send_one(x_sock sock, x_dgram_msg *m)
+{
+	struct msghdr h;
+	if (m->segment) {
+		errno = X_EOPNOTSUPP;
+		return -1;
+	}
+	dgram_to_hdr(m, &h, NULL, true);
+	ssize_t n = sendmsg(sock, &h, MSG_NOSIGNAL);
+	if (n < 0)
+		return -1;
+	m->len = n;
+	return 0;
+}
+#endif
+
+#endif
+
+/*
+ * Only the first message of a batch may block, and only on a blocking
+ * socket, the rest takes what is already queued.
+ */
+int x_dgram_recv(x_sock sock, x_dgram_msg *msgs, int cnt)
+{
+	int total = 0;
+	assert(msgs != NULL && cnt > 0);
+#ifdef X_OS_LINUX
+	struct mmsghdr hdrs[DGRAM_BATCH];
+	union dgram_cmsg cmsgs[DGRAM_BATCH];
+	while (total < cnt) {
+		int n = x_min(cnt - total, DGRAM_BATCH);
+		for (int i = 0; i < n; i++)
+			dgram_to_hdr(&msgs[total + i], &hdrs[i].msg_hdr, &cmsgs[i], false);
+		int ret = recvmmsg(sock, hdrs, n, total ? MSG_DONTWAIT : MSG_WAITFORONE, NULL);
+		if (ret < 0) {
+			if (errno == X_EINTR)
+				continue;
+			break;
+		}
+		for (int i = 0; i < ret; i++)
+			dgram_from_hdr(&msgs[total + i], &hdrs[i].msg_hdr, hdrs[i].msg_len);
+		total += ret;
+		if (ret < n)
+			break;
+	}
+#else
+	for (; total < cnt; total++) {
+		if (dgram_recv_one(sock, &msgs[total], total == 0))
+			break;
+	}
+#endif
+	return total ? total : -1;
+}
+
+int x_dgram_send(x_sock sock, x_dgram_msg *msgs, int cnt)
+{
+	int total = 0;
+	assert(msgs != NULL && cnt > 0);
+#ifdef X_OS_LINUX
+	struct mmsghdr hdrs[DGRAM_BATCH];
+	union dgram_cmsg cmsgs[DGRAM_BATCH];
+	while (total < cnt) {
+		int n = x_min(cnt - total, DGRAM_BATCH);
+		for (int i = 0; i < n; i++)
+			dgram_to_hdr(&msgs[total + i], &hdrs[i].msg_hdr, &cmsgs[i], true);
+		int ret = sendmmsg(sock, hdrs, n, MSG_NOSIGNAL);
+		if (ret < 0) {
+			if (errno == X_EINTR)
+				continue;
+			break;
+		}
+		for (int i = 0; i < ret; i++)
+			msgs[total + i].len = hdrs[i].msg_len;
+		total += ret;
+		/* The socket buffer is full */
+		if (ret < n)
+			break;
+	}
+#else
+	for (; total < cnt; total++) {
+		if (dgram_send_one(sock, &msgs[total]))
+			break;
+	}
+#endif
+	return total ? total : -1;
+}
+
+int x_dgram_set_gro(x_sock sock, bool enable)
+{
+#ifdef X_OS_LINUX
+	int on = enable;
+	return setsockopt(sock, SOL_UDP, UDP_GRO, &on, sizeof on);
+#else
+	(void)sock;
+	(void)enable;
+	x_sock_set_errno(X_SOCK_ERR(EOPNOTSUPP));
+	return -1;
+#endif
+}
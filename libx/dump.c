@@ -385,7 +385,9 @@ void x_dump_free(x_dump *dmp)
 static int write_file_cb(const x_uchar *buf, size_t len, void *ctx)
 {
 	FILE *fp = ctx;
-	return x_fprintf(fp, x_u("%.*s"), (int)len, buf);
+	if (len == 0)
+		return 0;
+	return x_fprintf(fp, x_u("%.*s"), (int)len, buf) < 0 ? -1 : 0;
 }
 
 static int indent_check_cb(const x_uchar *buf, size_t len, void *ctx)
@@ -463,11 +465,11 @@ static int dump_out_dfs(const x_dump *dmp, int depth, struct search_args *args)
 				return -1;
 			break;
 		case DTYPE_STR:
-			if (args->format->string(value->str.maddr, value->str.size, args->filter_cb, args))
+			if (args->format->string(value->str.data, value->str.size, args->filter_cb, args))
 				return -1;
 			break;
 		case DTYPE_MEM:
-			if (args->format->memory(value->mem.maddr, value->mem.size, args->filter_cb, args))
+			if (args->format->memory((const uint8_t *)value->mem.data, value->mem.size, args->filter_cb, args))
 				return -1;
 			break;
 		case DTYPE_SYM:
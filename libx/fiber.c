@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#elif !defined(_WIN32)
+#define _XOPEN_SOURCE 600 /* ucontext */
+#endif
+
+#include "x/fiber.h"
+#include "x/reactor.h"
+#include "x/socket.h"
+#include "x/memory.h"
+#include "x/errno.h"
+#ifdef X_OS_WIN32
+#include <windows.h>
+#else
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+#define FIBER_CACHE_MAX 256
+
+#define WAIT_IO    0x1
+#define WAIT_TIMER 0x2
+
+struct x_fiber_st
+{
+	x_link link; /* on ready or cache */
+	x_link fiber_link;
+	x_fiber_sched *sched;
+	x_fiber_fn *fn;
+	void *arg;
+	x_evsocket io;
+	x_evtimer timer;
+	int waiting;
+	short res_flags;
+	bool dead;
+#ifdef X_OS_WIN32
+	LPVOID ctx;
+#else
+	char *stack; /* the guard page, the stack is above it */
+	size_t map_size;
+	ucontext_t ctx;
+#endif
+};
+
+static void fiber_switch(x_fiber *from, x_fiber *to)
+{
+#ifdef X_OS_WIN32
+	(void)from;
+	SwitchToFiber(to->ctx);
+#else
+	(void)swapcontext(&from->ctx, &to->ctx);
+#endif
+}
+
+/* Back to the scheduler until the fiber is resumed */
+static void fiber_park(x_fiber *f, int waiting)
+{
+	f->waiting = waiting;
+	fiber_switch(f, f->sched->main);
+	f->waiting = 0;
+}
+
+/* Drops the registrations of a finished fiber, leaving its sockets open */
+static void fiber_release_events(x_fiber *f)
+{
+	x_reactor *r = f->sched->reactor;
+	if (f->io.base.ev_flags & X_EV_REACTING)
+		x_reactor_remove(r, &f->io.base);
+	if (f->timer.base.ev_flags & X_EV_REACTING)
+		x_reactor_remove(r, &f->timer.base);
+}
+
+static void fiber_run(x_fiber *f)
+{
+	/* A cached fiber starts its next function right here */
+	for (;;) {
+		f->fn(f, f->arg);
+		fiber_release_events(f);
+		f->dead = true;
+		fiber_switch(f, f->sched->main);
+	}
+}
+
+#ifdef X_OS_WIN32
+static VOID WINAPI fiber_entry(LPVOID param)
+{
+	fiber_run(param);
+}
+#else
+/* makecontext only passes ints, the pointer comes in two halves */
+static void fiber_entry(unsigned hi, unsigned lo)
+{
+	fiber_run((x_fiber *)(((uintptr_t)hi << 16 << 16) | lo));
+}
+#endif
+
+static x_fiber *fiber_create(x_fiber_sched *s)
+{
+	x_fiber *f = x_malloc(NULL, sizeof *f);
+	memset(f, 0, sizeof *f);
+	f->sched = s;
+	f->io.sock = X_BADSOCK;
+#ifdef X_OS_WIN32
+	f->ctx = CreateFiber(s->stack_size, fiber_entry, f);
+	if (!f->ctx) {
+		x_free(f);
+		errno = X_ENOMEM;
+		return NULL;
+	}
+#else
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	f->map_size = (s->stack_size + page - 1) / page * page + page;
+	f->stack = mmap(NULL, f->map_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (f->stack == MAP_FAILED)
+		goto fail;
+	if (mprotect(f->stack, page, PROT_NONE) || getcontext(&f->ctx)) {
+		munmap(f->stack, f->map_size);
+		goto fail;
+	}
+	f->ctx.uc_stack.ss_sp = f->stack + page;
+	f->ctx.uc_stack.ss_size = f->map_size - page;
+	f->ctx.uc_link = NULL;
+	uintptr_t p = (uintptr_t)f;
+	makecontext(&f->ctx, (void (*)(void))fiber_entry, 2,
+			(unsigned)(p >> 16 >> 16), (unsigned)(p & 0xffffffffu));
+#endif
+	return f;
+#ifndef X_OS_WIN32
+fail:
+	x_free(f);
+	return NULL;
+#endif
+}
+
+static void fiber_destroy(x_fiber *f)
+{
+#ifdef X_OS_WIN32
+	DeleteFiber(f->ctx);
+#else
+	munmap(f->stack, f->map_size);
+#endif
+	x_free(f);
+}
+
+static void sched_resume(x_fiber_sched *s, x_fiber *f)
+{
+	s->current = f;
+	fiber_switch(s->main, f);
+	s->current = NULL;
+	if (!f->dead)
+		return;
+	x_list_del(&f->fiber_link);
+	s->fiber_cnt--;
+	if (s->cache_cnt == FIBER_CACHE_MAX) {
+		fiber_destroy(f);
+		return;
+	}
+	x_list_add_back(&s->cache, &f->link);
+	s->cache_cnt++;
+}
+
+/* Runs the fibers that are ready now, those they make ready wait a turn */
+static void sched_run_ready(x_fiber_sched *s)
+{
+	x_link *last = x_list_last(&s->ready), *link;
+	while ((link = x_list_first(&s->ready))) {
+		bool done = link == last;
+		x_list_del(link);
+		sched_resume(s, x_container_of(link, x_fiber, link));
+		if (done)
+			break;
+	}
+}
+
+int x_fiber_sched_init(x_fiber_sched *s, x_reactor *r, size_t stack_size)
+{
+	assert(s != NULL && r != NULL);
+	memset(s, 0, sizeof *s);
+	s->reactor = r;
+	s->stack_size = stack_size ? stack_size : X_FIBER_STACK_SIZE;
+	x_list_init(&s->ready);
+	x_list_init(&s->cache);
+	x_list_init(&s->fibers);
+	s->main = x_malloc(NULL, sizeof *s->main);
+	memset(s->main, 0, sizeof *s->main);
+#ifdef X_OS_WIN32
+	s->main->ctx = IsThreadAFiber() ? GetCurrentFiber() : ConvertThreadToFiber(NULL);
+	if (!s->main->ctx) {
+		x_free(s->main);
+		errno = X_ENOMEM;
+		return -1;
+	}
+#endif
+	x_evobject_init(&s->kick, 0, s);
+	if (x_reactor_add(r, &s->kick.base)) {
+		x_free(s->main);
+		return -1;
+	}
+	return 0;
+}
+
+/* Fibers that have not finished are dropped, their sockets stay open */
+void x_fiber_sched_free(x_fiber_sched *s)
+{
+	x_link *link;
+	assert(s != NULL && s->current == NULL);
+	while ((link = x_list_first(&s->fibers))) {
+		x_fiber *f = x_container_of(link, x_fiber, fiber_link);
+		x_list_del(link);
+		fiber_release_events(f);
+		fiber_destroy(f);
+	}
+	while ((link = x_list_first(&s->cache))) {
+		x_list_del(link);
+		fiber_destroy(x_container_of(link, x_fiber, link));
+	}
+	x_reactor_remove(s->reactor, &s->kick.base);
+	x_free(s->main);
+	s->main = NULL;
+}
+
+int x_fiber_sched_run(x_fiber_sched *s)
+{
+	x_event *e;
+	assert(s != NULL && s->current == NULL);
+	while (s->fiber_cnt) {
+		sched_run_ready(s);
+		if (!s->fiber_cnt)
+			break;
+		/* Fibers that yielded must not wait for I/O of others */
+		if (!x_list_is_empty(&s->ready))
+			x_reactor_raise(&s->kick, 1);
+		int npendings = x_reactor_wait(s->reactor);
+		if (npendings <= 0)
+			return npendings;
+		while ((e = x_reactor_pop_event(s->reactor))) {
+			if (e == &s->kick.base) {
+				s->kick.base.res_flags = 0;
+				continue;
+			}
+			/* An expired timeout leaves the socket armed, it may still fire */
+			x_fiber *f = e->data;
+			if (e == &f->io.base && (f->waiting & WAIT_IO))
+				f->res_flags = e->res_flags;
+			else if (e == &f->timer.base && (f->waiting & WAIT_TIMER))
+				f->res_flags = 0;
+			else
+				continue;
+			sched_resume(s, f);
+		}
+	}
+	return 0;
+}
+
+x_fiber *x_fiber_spawn(x_fiber_sched *s, x_fiber_fn *fn, void *arg)
+{
+	x_fiber *f;
+	x_link *link;
+	assert(s != NULL && fn != NULL);
+	if ((link = x_list_first(&s->cache))) {
+		x_list_del(link);
+		s->cache_cnt--;
+		f = x_container_of(link, x_fiber, link);
+	}
+	else if (!(f = fiber_create(s)))
+		return NULL;
+	f->fn = fn;
+	f->arg = arg;
+	f->dead = false;
+	x_list_add_back(&s->fibers, &f->fiber_link);
+	x_list_add_back(&s->ready, &f->link);
+	s->fiber_cnt++;
+	return f;
+}
+
+x_fiber_sched *x_fiber_sched_of(const x_fiber *f)
+{
+	assert(f != NULL);
+	return f->sched;
+}
+
+void x_fiber_yield(x_fiber *self)
+{
+	assert(self != NULL && self == self->sched->current);
+	x_list_add_back(&self->sched->ready, &self->link);
+	fiber_park(self, 0);
+}
+
+static int fiber_add_timer(x_fiber *self, int msec)
+{
+	x_evtimer_init(&self->timer, msec, X_EV_ONCE, self);
+	return x_reactor_add(self->sched->reactor, &self->timer.base);
+}
+
+static void fiber_cancel_timer(x_fiber *self)
+{
+	if (self->timer.base.ev_flags & X_EV_REACTING)
+		x_reactor_remove(self->sched->reactor, &self->timer.base);
+}
+
+int x_fiber_sleep(x_fiber *self, int msec)
+{
+	assert(self != NULL && self == self->sched->current);
+	if (fiber_add_timer(self, msec < 0 ? 0 : msec))
+		return -1;
+	fiber_park(self, WAIT_TIMER);
+	return 0;
+}
+
+int x_fiber_wait(x_fiber *self, x_sock sock, short flags, int msec)
+{
+	assert(self != NULL && self == self->sched->current);
+	x_reactor *r = self->sched->reactor;
+	flags = (flags & (X_EV_READ | X_EV_WRITE)) | X_EV_ONCE;
+	/* The same socket again is one re-arm, which is the common case */
+	if ((self->io.base.ev_flags & X_EV_REACTING) && self->io.sock == sock) {
+		self->io.base.ev_flags = flags | X_EV_REACTING;
+		if (x_reactor_modify(&self->io.base))
+			return -1;
+	}
+	else {
+		if (self->io.base.ev_flags & X_EV_REACTING)
+			x_reactor_remove(r, &self->io.base);
+		x_evsocket_init(&self->io, sock, flags, self);
+		if (x_reactor_add(r, &self->io.base))
+			return -1;
+	}
+	int waiting = WAIT_IO;
+	if (msec >= 0) {
+		if (fiber_add_timer(self, msec))
+			return -1;
+		waiting |= WAIT_TIMER;
+	}
+	fiber_park(self, waiting);
+	fiber_cancel_timer(self);
+	if (!self->res_flags) {
+		errno = X_ETIMEDOUT;
+		return -1;
+	}
+	return 0;
+}
+
+static bool sock_would_block(void)
+{
+	int err = x_sock_errno();
+	return err == X_SOCK_ERR(EWOULDBLOCK) || err == EAGAIN;
+}
+
+x_sock x_fiber_accept(x_fiber *self, x_sock sock, struct sockaddr *addr, socklen_t *addrlen, int msec)
+{
+	for (;;) {
+		x_sock fd = x_sock_accept(sock, addr, addrlen);
+		if (fd != X_BADSOCK)
+			return fd;
+		if (x_sock_errno() == X_SOCK_ERR(EINTR) || x_sock_errno() == X_SOCK_ERR(ECONNABORTED))
+			continue;
+		if (!sock_would_block() || x_fiber_wait(self, sock, X_EV_READ, msec))
+			return X_BADSOCK;
+	}
+}
+
+int x_fiber_connect(x_fiber *self, x_sock sock, const struct sockaddr *addr, socklen_t addrlen, int msec)
+{
+	int err = 0;
+	socklen_t len = sizeof err;
+	if (connect(sock, addr, addrlen) == 0)
+		return 0;
+	if (x_sock_errno() != X_SOCK_ERR(EINPROGRESS) && !sock_would_block())
+		return -1;
+	if (x_fiber_wait(self, sock, X_EV_WRITE, msec))
+		return -1;
+	if (getsockopt(sock, SOL_SOCKET, SO_ERROR, (void *)&err, &len))
+		return -1;
+	if (err) {
+		x_sock_set_errno(err);
+		return -1;
+	}
+	return 0;
+}
+
+int x_fiber_recv(x_fiber *self, x_sock sock, void *buf, size_t len, int msec)
+{
+	if (len > INT_MAX)
+		len = INT_MAX;
+	for (;;) {
+		int n = recv(sock, buf, len, 0);
+		if (n >= 0)
+			return n;
+		if (x_sock_errno() == X_SOCK_ERR(EINTR))
+			continue;
+		if (!sock_would_block() || x_fiber_wait(self, sock, X_EV_READ, msec))
+			return -1;
+	}
+}
+
+int x_fiber_send(x_fiber *self, x_sock sock, const void *data, size_t len, int msec)
+{
+	const char *p = data;
+	while (len) {
+		int n = send(sock, p, len > INT_MAX ? INT_MAX : len, MSG_NOSIGNAL);
+		if (n >= 0) {
+			p += n;
+			len -= n;
+			continue;
+		}
+		if (x_sock_errno() == X_SOCK_ERR(EINTR))
+			continue;
+		if (!sock_would_block() || x_fiber_wait(self, sock, X_EV_WRITE, msec))
+			return -1;
+	}
+	return 0;
+}
+
+int x_fiber_close(x_fiber *self, x_sock sock)
+{
+	assert(self != NULL);
+	if ((self->io.base.ev_flags & X_EV_REACTING) && self->io.sock == sock)
+		x_reactor_remove(self->sched->reactor, &self->io.base);
+	return x_sock_close(sock);
+}
@@ -24,6 +24,7 @@
 #include "x/assert.h"
 #include "x/memory.h"
 #include "x/string.h"
+#include "x/macros.h"
 #include <stdlib.h>
 
 #define PAGE_SIZE  4096
@@ -41,6 +42,16 @@ void x_heap_init(x_heap* h, x_heap_ordered_fn *cmp)
 	h->page_cnt = 1;
 	h->min_page_cnt = h->page_cnt;
 	h->table = x_malloc(NULL, h->page_cnt * PAGE_SIZE);
+	h->hugepage = false;
+}
+
+/* Advise huge pages for the entry table from now on, once it spans 2MB */
+void x_heap_set_hugepage(x_heap *h, bool hugepage)
+{
+	assert(h != NULL);
+	h->hugepage = hugepage;
+	if (hugepage)
+		(void)x_mhuge(h->table);
 }
 
 void x_heap_free(x_heap* h)
@@ -66,6 +77,8 @@ void x_heap_push(x_heap* h, x_ranode *p)
 	if (h->entry_cnt + 1 > mx_entries) {
 		int new_size = h->page_cnt * 2;
 		x_ranode **new_table = x_realloc(h->table, new_size * PAGE_SIZE);
+		if (h->hugepage)
+			(void)x_mhuge(new_table);
 		h->table = new_table;
 		h->page_cnt = new_size;
 	}
@@ -108,7 +121,7 @@ x_ranode * x_heap_pop(x_heap* h)
 	int entries = h->entry_cnt;
 	if (h->entry_cnt > 0) {
 		*current = h->table[entries];
-		(*current)->index = entries;
+		(*current)->index = 0;
 		x_ranode **left_child, **right_child;
 		int left_child_index;
 		while (left_child_index = LEFT_CHILD(current_index), left_child_index < entries) {
@@ -190,3 +203,186 @@ void x_heap_remove(x_heap *h, x_ranode *n)
 	heap_shrink(h);
 }
 
+
+#define DHEAP_GROUP  (X_DHEAP_ARITY * sizeof(struct x_dheap_entry_st))
+#define DHEAP_MIN_CAP 64
+#define DHEAP_CHILD(i)  ((i) * X_DHEAP_ARITY + 1)
+#define DHEAP_PARENT(i) (((i) - 1) / X_DHEAP_ARITY)
+
+/*
+ * Children of entry i live at [d*i+1, d*i+d], so the table is offset by one
+ * entry from a group boundary to keep every sibling group in one cache line.
+ */
+static void dheap_resize(x_dheap *h, size_t capacity)
+{
+	void *mem = x_malloc(NULL, capacity * sizeof(struct x_dheap_entry_st) + 2 * DHEAP_GROUP);
+	uintptr_t base = x_align((uintptr_t)mem, DHEAP_GROUP);
+	struct x_dheap_entry_st *table = (struct x_dheap_entry_st *)(base + DHEAP_GROUP) - 1;
+	if (h->entry_cnt)
+		memcpy(table, h->table, h->entry_cnt * sizeof *table);
+	if (h->hugepage)
+		(void)x_mhuge(mem);
+	x_free(h->mem);
+	h->mem = mem;
+	h->table = table;
+	h->capacity = capacity;
+}
+
+static void dheap_sift_up(x_dheap *h, size_t i, struct x_dheap_entry_st e)
+{
+	struct x_dheap_entry_st *t = h->table;
+	while (i > 0) {
+		size_t parent = DHEAP_PARENT(i);
+		if (t[parent].key <= e.key)
+			break;
+		t[i] = t[parent];
+		t[i].node->index = i;
+		i = parent;
+	}
+	t[i] = e;
+	e.node->index = i;
+}
+
+static void dheap_sift_down(x_dheap *h, size_t i, struct x_dheap_entry_st e)
+{
+	struct x_dheap_entry_st *t = h->table;
+	size_t cnt = h->entry_cnt, child;
+	while ((child = DHEAP_CHILD(i)) < cnt) {
+		size_t end = child + X_DHEAP_ARITY, best = child;
+		if (end > cnt)
+			end = cnt;
+		for (size_t c = child + 1; c < end; c++)
+			if (t[c].key < t[best].key)
+				best = c;
+		if (e.key <= t[best].key)
+			break;
+		t[i] = t[best];
+		t[i].node->index = i;
+		i = best;
+	}
+	t[i] = e;
+	e.node->index = i;
+}
+
+void x_dheap_init(x_dheap *h)
+{
+	assert(h != NULL);
+	h->entry_cnt = 0;
+	h->capacity = 0;
+	h->mem = NULL;
+	h->table = NULL;
+	h->hugepage = false;
+	dheap_resize(h, DHEAP_MIN_CAP);
+}
+
+void x_dheap_set_hugepage(x_dheap *h, bool hugepage)
+{
+	assert(h != NULL);
+	h->hugepage = hugepage;
+	if (hugepage && h->mem)
+		(void)x_mhuge(h->mem);
+}
+
+void x_dheap_free(x_dheap *h)
+{
+	if (!h)
+		return;
+	x_free(h->mem);
+	h->mem = NULL;
+	h->table = NULL;
+	h->entry_cnt = h->capacity = 0;
+}
+
+void x_dheap_push(x_dheap *h, x_ranode *n, uint64_t key)
+{
+	assert(h != NULL);
+	assert(n != NULL);
+	if (h->entry_cnt == h->capacity)
+		dheap_resize(h, h->capacity ? h->capacity * 2 : DHEAP_MIN_CAP);
+	dheap_sift_up(h, h->entry_cnt++, (struct x_dheap_entry_st) { key, n });
+}
+
+void x_dheap_build(x_dheap *h, x_ranode *const *nodes, const uint64_t *keys, size_t cnt)
+{
+	assert(h != NULL);
+	assert(cnt == 0 || (nodes != NULL && keys != NULL));
+	size_t total = h->entry_cnt + cnt, cap = h->capacity ? h->capacity : DHEAP_MIN_CAP;
+	while (cap < total)
+		cap *= 2;
+	if (cap != h->capacity)
+		dheap_resize(h, cap);
+	for (size_t i = 0; i < cnt; i++) {
+		h->table[h->entry_cnt + i].key = keys[i];
+		h->table[h->entry_cnt + i].node = nodes[i];
+		nodes[i]->index = h->entry_cnt + i;
+	}
+	h->entry_cnt = total;
+	/* Floyd's bottom-up construction, O(n) */
+	if (total < 2)
+		return;
+	for (size_t i = DHEAP_PARENT(total - 1) + 1; i-- > 0; )
+		dheap_sift_down(h, i, h->table[i]);
+}
+
+x_ranode *x_dheap_top(const x_dheap *h, uint64_t *key)
+{
+	if (h->entry_cnt == 0)
+		return NULL;
+	if (key)
+		*key = h->table[0].key;
+	return h->table[0].node;
+}
+
+static void dheap_shrink(x_dheap *h)
+{
+	if (h->capacity > DHEAP_MIN_CAP && h->entry_cnt < h->capacity / 4)
+		dheap_resize(h, h->capacity / 2);
+}
+
+x_ranode *x_dheap_pop(x_dheap *h, uint64_t *key)
+{
+	assert(h != NULL);
+	if (h->entry_cnt == 0)
+		return NULL;
+	x_ranode *top = h->table[0].node;
+	if (key)
+		*key = h->table[0].key;
+	if (--h->entry_cnt > 0)
+		dheap_sift_down(h, 0, h->table[h->entry_cnt]);
+	top->index = SIZE_MAX;
+	dheap_shrink(h);
+	return top;
+}
+
+void x_dheap_remove(x_dheap *h, x_ranode *n)
+{
+	assert(h != NULL);
+	assert(n != NULL);
+	assert(n->index < h->entry_cnt);
+	assert(h->table[n->index].node == n);
+	size_t i = n->index;
+	struct x_dheap_entry_st last = h->table[--h->entry_cnt];
+	n->index = SIZE_MAX;
+	if (i != h->entry_cnt) {
+		if (i > 0 && last.key < h->table[DHEAP_PARENT(i)].key)
+			dheap_sift_up(h, i, last);
+		else
+			dheap_sift_down(h, i, last);
+	}
+	dheap_shrink(h);
+}
+
+void x_dheap_update(x_dheap *h, x_ranode *n, uint64_t key)
+{
+	assert(h != NULL);
+	assert(n != NULL);
+	assert(n->index < h->entry_cnt);
+	assert(h->table[n->index].node == n);
+	size_t i = n->index;
+	uint64_t old = h->table[i].key;
+	struct x_dheap_entry_st e = { key, n };
+	if (key < old)
+		dheap_sift_up(h, i, e);
+	else
+		dheap_sift_down(h, i, e);
+}
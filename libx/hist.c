@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/hist.h"
+#include <string.h>
+#include <assert.h>
+
+void x_hist_init(x_hist *h)
+{
+	memset(h, 0, sizeof *h);
+	h->min = UINT64_MAX;
+}
+
+void x_hist_merge(x_hist *dst, const x_hist *src)
+{
+	for (unsigned i = 0; i < X_HIST_BUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+	dst->count += src->count;
+	dst->sum += src->sum;
+	if (src->min < dst->min)
+		dst->min = src->min;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+uint64_t x_hist_bucket_max(unsigned index)
+{
+	assert(index < X_HIST_BUCKETS);
+	if (index < (1u << X_HIST_SUB_BITS))
+		return index;
+	unsigned exp = (index >> X_HIST_SUB_BITS) + X_HIST_SUB_BITS - 1;
+	uint64_t width = (uint64_t)1 << (exp - X_HIST_SUB_BITS);
+	uint64_t low = ((uint64_t)1 << exp) | (uint64_t)(index & ((1u << X_HIST_SUB_BITS) - 1)) * width;
+	return low + (width - 1);
+}
+
+/* p in [0, 100], the upper bound of the bucket holding that rank */
+uint64_t x_hist_percentile(const x_hist *h, double p)
+{
+	if (!h->count)
+		return 0;
+	uint64_t rank = (uint64_t)(p / 100.0 * h->count + 0.5), seen = 0;
+	if (rank == 0)
+		rank = 1;
+	for (unsigned i = 0; i < X_HIST_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= rank) {
+			uint64_t value = x_hist_bucket_max(i);
+			return value > h->max ? h->max : value;
+		}
+	}
+	return h->max;
+}
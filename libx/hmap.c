@@ -23,6 +23,9 @@
 #include "x/hmap.h"
 #include "x/list.h"
 #include "x/memory.h"
+#include "x/string.h"
+#include "x/once.h"
+#include "x/time.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -38,31 +41,84 @@ static const int s_primes[] =
 	402653189, 805306457, 1610612741
 };
 
-static void x_hmap_expand(x_hmap *ht, int elem_cnt)
+static x_once s_seed_once = X_ONCE_INIT;
+static uint64_t s_seed;
+
+static void seed_init(void)
+{
+	/* Per process seed so bucket placement can not be predicted from keys */
+	uint64_t entropy[3] = { x_time_tick(), (uintptr_t)&entropy, (uintptr_t)seed_init };
+	s_seed = x_memhash64(entropy, sizeof entropy, 0);
+}
+
+size_t x_hmap_memhash(const void *p, size_t size)
+{
+	x_once_init(&s_seed_once, seed_init);
+	return (size_t)x_memhash64(p, size, s_seed);
+}
+
+size_t x_hmap_strhash(const char *s)
+{
+	x_once_init(&s_seed_once, seed_init);
+	return (size_t)x_strhash64(s, s_seed);
+}
+
+/*
+ * Bucket heads are zero filled on allocation and initialized on first use,
+ * so a large table costs nothing until its pages are touched.
+ */
+static inline x_list *hmap_bucket(x_list *table, size_t slot)
+{
+	x_list *list = table + slot;
+	if (!list->head.next)
+		x_list_init(list);
+	return list;
+}
+
+static void hmap_migrate(x_hmap *ht, size_t n)
 {
-	int new_slot_cnt, new_idx, new_load_limit;
-	x_list *new_table;
+	while (n-- && ht->migrate_idx < ht->old_slot_cnt) {
+		x_list *list = ht->old_table + ht->migrate_idx++;
+		if (!list->head.next)
+			continue;
+		x_list_popeach(cur, list) {
+			size_t h = ht->hash(cur) % ht->slot_cnt;
+			x_list_add_back(hmap_bucket(ht->table, h), cur);
+		}
+	}
+	if (ht->migrate_idx == ht->old_slot_cnt) {
+		x_free(ht->old_table);
+		ht->old_table = NULL;
+		ht->old_slot_cnt = 0;
+		ht->migrate_idx = 0;
+	}
+}
+
+static void x_hmap_expand(x_hmap *ht, size_t elem_cnt)
+{
+	size_t new_slot_cnt, new_idx, new_load_limit;
+	if (ht->old_table)
+		hmap_migrate(ht, SIZE_MAX);
 	new_load_limit = ht->load_limit;
 	new_slot_cnt = ht->slot_cnt;
 	new_idx = ht->prime_idx;
-	while(new_load_limit < elem_cnt && new_idx < x_arrlen(s_primes)) {
+	while(new_load_limit < elem_cnt && new_idx + 1 < x_arrlen(s_primes)) {
 		new_slot_cnt = s_primes[++new_idx];
 		new_load_limit = ht->load_factor * new_slot_cnt;
 	}
-	new_table = x_malloc(NULL, new_slot_cnt * sizeof(x_list));
-	for(size_t i = 0; i < new_slot_cnt; ++i)
-		x_list_init(new_table + i);
-	for(size_t i = 0; i < ht->slot_cnt; ++i) {
-		x_list_popeach(cur, ht->table) {
-			size_t h = ht->hash(cur) % new_slot_cnt;
-			x_list_add_back(new_table + h, cur);
-		}
-	}
-	x_free(ht->table);
+	if (new_idx == ht->prime_idx)
+		return;
+	ht->old_table = ht->table;
+	ht->old_slot_cnt = ht->slot_cnt;
+	ht->migrate_idx = 0;
+	ht->table = x_zalloc(NULL, new_slot_cnt * sizeof(x_list));
+	if (ht->hugepage)
+		(void)x_mhuge(ht->table);
 	ht->prime_idx = new_idx;
-	ht->table = new_table;
 	ht->slot_cnt = new_slot_cnt;
 	ht->load_limit = new_load_limit;
+	if (!ht->incremental)
+		hmap_migrate(ht, SIZE_MAX);
 }
 
 void x_hmap_init(x_hmap *ht, float load_factor, x_hmap_hash_fn *hash_fn, x_hmap_equal_fn *equal_fn)
@@ -74,67 +130,102 @@ void x_hmap_init(x_hmap *ht, float load_factor, x_hmap_hash_fn *hash_fn, x_hmap_
 	ht->load_factor = load_factor;
 	ht->elem_cnt = 0;
 	ht->slot_cnt = s_primes[idx];
+	ht->old_table = NULL;
+	ht->old_slot_cnt = 0;
+	ht->migrate_idx = 0;
+	ht->incremental = false;
+	ht->hugepage = false;
 	ht->hash = hash_fn;
 	ht->equal = equal_fn;
 
-	ht->table = x_malloc(NULL, ht->slot_cnt * sizeof(x_link));
-	for(size_t i = 0; i < ht->slot_cnt; ++i)
-		x_list_init(ht->table + i);
+	ht->table = x_zalloc(NULL, ht->slot_cnt * sizeof(x_list));
+}
+
+void x_hmap_set_incremental(x_hmap *ht, bool incremental)
+{
+	ht->incremental = incremental;
+	if (!incremental && ht->old_table)
+		hmap_migrate(ht, SIZE_MAX);
+}
+
+/* Advise huge pages for the bucket table from now on, once it spans 2MB */
+void x_hmap_set_hugepage(x_hmap *ht, bool hugepage)
+{
+	ht->hugepage = hugepage;
+	if (hugepage)
+		(void)x_mhuge(ht->table);
+}
+
+void x_hmap_reserve(x_hmap *ht, size_t elem_cnt)
+{
+	/* Sized up front on purpose, so the rehash is not spread over later calls */
+	x_hmap_expand(ht, elem_cnt);
+	if (ht->old_table)
+		hmap_migrate(ht, SIZE_MAX);
 }
 
-static x_link *hmap_locate(x_hmap *ht, const x_link *link, size_t *slot)
+static x_link *hmap_locate(x_hmap *ht, const x_link *link, size_t hash)
 {
-	*slot = ht->hash(link) % ht->slot_cnt;
-	x_list_foreach(cur, ht->table + *slot)
+	if (ht->old_table)
+		hmap_migrate(ht, X_HMAP_MIGRATE_STEP);
+	if (ht->old_table) {
+		size_t slot = hash % ht->old_slot_cnt;
+		if (slot >= ht->migrate_idx && ht->old_table[slot].head.next) {
+			x_list_foreach(cur, ht->old_table + slot)
+				if (ht->equal(link, cur))
+					return cur;
+		}
+	}
+	x_list *list = ht->table + hash % ht->slot_cnt;
+	if (!list->head.next)
+		return NULL;
+	x_list_foreach(cur, list)
 		if (ht->equal(link, cur))
 			return cur;
 	return NULL;
 }
 
+static void hmap_insert(x_hmap *ht, x_link *link, size_t hash)
+{
+	if(ht->elem_cnt >= ht->load_limit)
+		x_hmap_expand(ht, ht->elem_cnt + 1);
+	x_list_add_back(hmap_bucket(ht->table, hash % ht->slot_cnt), link);
+	ht->elem_cnt++;
+}
+
 x_link *x_hmap_find(x_hmap *ht, const x_link *link)
 {
-	size_t slot;
 	assert(link->prev == NULL && link->prev == NULL);
-	return hmap_locate(ht, link, &slot);
+	return hmap_locate(ht, link, ht->hash(link));
 }
 
 x_link *x_hmap_find_or_insert(x_hmap *ht, x_link *link)
 {
-	size_t slot;
 	assert(link->prev == NULL && link->prev == NULL);
-	x_link *result = hmap_locate(ht, link, &slot);
+	size_t hash = ht->hash(link);
+	x_link *result = hmap_locate(ht, link, hash);
 	if (result)
 		return result;
-
-	if(ht->elem_cnt >= ht->load_limit)
-		x_hmap_expand(ht, ht->elem_cnt + 1);
-
-	x_list_add_back(ht->table + slot, link);
-	ht->elem_cnt++;
+	hmap_insert(ht, link, hash);
 	return 0;
 }
 
 x_link *x_hmap_replace_or_insert(x_hmap *ht, x_link *link)
 {
-	size_t slot;
 	assert(link->prev == NULL && link->prev == NULL);
-	x_link *result = hmap_locate(ht, link, &slot);
+	size_t hash = ht->hash(link);
+	x_link *result = hmap_locate(ht, link, hash);
 	if (result) {
 		x_list_replace(result, link);
 		return result;
 	}
-	if(ht->elem_cnt >= ht->load_limit)
-		x_hmap_expand(ht, ht->elem_cnt + 1);
-
-	x_list_add_back(ht->table + slot, link);
-	ht->elem_cnt++;
+	hmap_insert(ht, link, hash);
 	return 0;
 }
 
 x_link *x_hmap_find_and_remove(x_hmap *ht, const x_link *link)
 {
-	size_t slot;
-	x_link *result = hmap_locate(ht, link, &slot);
+	x_link *result = hmap_locate(ht, link, ht->hash(link));
 	if (!result)
 		return NULL;
 	x_list_del(result);
@@ -147,10 +238,12 @@ void x_hmap_remove(x_hmap *ht, x_link *link)
 	assert(link->prev != NULL && link->prev != NULL);
 	x_list_del(link);
 	ht->elem_cnt--;
+	if (ht->old_table)
+		hmap_migrate(ht, X_HMAP_MIGRATE_STEP);
 }
 
 void x_hmap_free(x_hmap * ht)
 {
+	x_free(ht->old_table);
 	x_free(ht->table);
 }
-
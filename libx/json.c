@@ -1610,13 +1610,6 @@ x_json *x_json_create_number(double num)
     x_json *item = x_json_new_item();
 	item->type = X_JSON_NUMBER;
 	item->value.number = num;
-	/* use saturation in case of overflow */
-	if (num >= INT_MAX)
-		item->value.integer = INT_MAX;
-	else if (num <= (double)INT_MIN)
-		item->value.integer = INT_MIN;
-	else
-		item->value.integer = (int)num;
     return item;
 }
 
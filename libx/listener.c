@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/listener.h"
+#include "x/reactor.h"
+#include "x/socket.h"
+#include "x/errno.h"
+#include <errno.h>
+#include <assert.h>
+
+int x_listener_init(x_listener *ln, x_reactor *r, x_sock sock, short flags,
+		x_listener_fn *on_accept, void *arg)
+{
+	assert(ln != NULL && r != NULL && on_accept != NULL);
+	if (flags & X_EV_ONCE) {
+		errno = X_EINVAL;
+		return -1;
+	}
+	ln->reactor = r;
+	ln->budget = X_LISTENER_BUDGET;
+	ln->on_accept = on_accept;
+	ln->arg = arg;
+	x_evsocket_init(&ln->ev, sock, flags | X_EV_READ, ln);
+	return x_reactor_add(r, &ln->ev.base);
+}
+
+void x_listener_free(x_listener *ln)
+{
+	assert(ln != NULL);
+	if (ln->ev.base.ev_flags & X_EV_REACTING)
+		x_reactor_remove(ln->reactor, &ln->ev.base);
+}
+
+int x_listener_dispatch(x_event *e)
+{
+	assert(e != NULL);
+	x_listener *ln = e->data;
+	int n = 0;
+	while (n < ln->budget) {
+		x_sock sock = x_sock_accept(ln->ev.sock, NULL, NULL);
+		if (sock == X_BADSOCK) {
+			int err = x_sock_errno();
+			if (err == X_SOCK_ERR(EINTR) || err == X_SOCK_ERR(ECONNABORTED))
+				continue;
+			/* Drained, or out of descriptors and nothing to do about it here */
+			return n;
+		}
+		n++;
+		ln->on_accept(ln, sock, ln->arg);
+	}
+	/* An edge triggered listener would never hear about the rest */
+	if (ln->ev.base.ev_flags & X_EV_EDGE)
+		(void)x_reactor_modify(&ln->ev.base);
+	return n;
+}
@@ -20,15 +20,76 @@
  * THE SOFTWARE.
  */
 
+#undef X_MSET_TRACE
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
 #include "x/list.h"
 #include "x/memory.h"
 #include "x/thread.h"
 #include "x/mutex.h"
 #include "x/once.h"
+#include "x/assert.h"
+#include "x/time.h"
+#include "x/dump.h"
+#include "x/printf.h"
+#include "x/atomic.h"
+#include <stdlib.h>
 #include <string.h>
+#ifndef X_OS_WIN
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #define RETRY_INTERVAL 20
 
+/* Flags in the top bits of the size of x_mblock and arena_block */
+#define MBLOCK_MAPPED ((size_t)1 << (sizeof(size_t) * CHAR_BIT - 1))
+#define MBLOCK_COUNTED ((size_t)1 << (sizeof(size_t) * CHAR_BIT - 2))
+#define MBLOCK_SIZE(b) ((b)->size & ~(MBLOCK_MAPPED | MBLOCK_COUNTED))
+#define MBLOCK_IS_MAPPED(b) (!!((b)->size & MBLOCK_MAPPED))
+#define MBLOCK_IS_COUNTED(b) (!!((b)->size & MBLOCK_COUNTED))
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+#define ARENA_ALIGN (2 * sizeof(void *))
+#define ARENA_CHUNK_HEAD x_align(sizeof(struct arena_chunk), ARENA_ALIGN)
+#define ARENA_CHUNK_DATA(c) ((uint8_t *)(c) + ARENA_CHUNK_HEAD)
+#define ARENA_BLOCK_SIZE(size) (sizeof(struct arena_block) + x_align(size, ARENA_ALIGN))
+
+struct arena_chunk
+{
+	x_link link;
+	size_t size;
+};
+
+/* Same tail as x_mblock, so size and mset are found the same way */
+struct arena_block
+{
+	size_t size;
+	x_mset *mset;
+	char data[];
+};
+
+struct site
+{
+	const char *file;
+	const char *func;
+	int line;
+	uint64_t cnt;
+	uint64_t bytes;
+};
+
+struct x_mset_site_table_st
+{
+	size_t used;
+	struct site other;
+	struct site table[X_MSET_SITE_MAX];
+};
+
+x_static_assert(sizeof(struct arena_block) == ARENA_ALIGN);
+
 static x_once s_mset_once = X_ONCE_INIT;
 static x_mset s_mset = {
 	.list = X_LIST_INIT(s_mset.list),
@@ -51,20 +112,335 @@ static void init_default_mset(void)
 #endif
 }
 
+static void *retry_malloc(size_t size)
+{
+	void *p = malloc(size);
+	while (!p) {
+		x_thread_sleep(RETRY_INTERVAL);
+		p = malloc(size);
+	}
+	return p;
+}
+
+static struct site *site_lookup(struct x_mset_site_table_st *sites, const x_location *loc)
+{
+	const char *file = loc ? loc->file : NULL;
+	int line = loc ? loc->line : 0;
+	size_t mask = X_MSET_SITE_MAX - 1;
+	size_t i = (((uintptr_t)file >> 3) * 31 + line) & mask;
+	for (size_t n = 0; n < X_MSET_SITE_MAX; n++, i = (i + 1) & mask) {
+		struct site *st = sites->table + i;
+		if (st->cnt == 0) {
+			if (sites->used * 4 >= X_MSET_SITE_MAX * 3)
+				break;
+			sites->used++;
+			st->file = file;
+			st->func = loc ? loc->func : NULL;
+			st->line = line;
+			return st;
+		}
+		if (st->file == file && st->line == line)
+			return st;
+	}
+	return &sites->other;
+}
+
+/*
+ * hdr is the size field of the block. Counted blocks are marked, blocks
+ * that were live before x_mset_stats_enable are never subtracted.
+ */
+static void stats_alloc(x_mset *mset, size_t *hdr, const x_location *loc)
+{
+	x_mset_stats *stats = &mset->stats;
+	size_t size = *hdr & ~(MBLOCK_MAPPED | MBLOCK_COUNTED);
+	*hdr |= MBLOCK_COUNTED;
+	stats->live_bytes += size;
+	stats->live_blocks++;
+	stats->alloc_cnt++;
+	if (stats->live_bytes > stats->peak_bytes)
+		stats->peak_bytes = stats->live_bytes;
+	if (mset->sites) {
+		struct site *st = site_lookup(mset->sites, loc);
+		st->cnt++;
+		st->bytes += size;
+	}
+}
+
+static void stats_free(x_mset *mset, size_t *hdr)
+{
+	if (!(*hdr & MBLOCK_COUNTED))
+		return;
+	*hdr &= ~MBLOCK_COUNTED;
+	mset->stats.live_bytes -= *hdr & ~MBLOCK_MAPPED;
+	mset->stats.live_blocks--;
+	mset->stats.free_cnt++;
+}
+
+static void stats_resize(x_mset *mset, size_t old_size, size_t new_size)
+{
+	x_mset_stats *stats = &mset->stats;
+	stats->live_bytes = stats->live_bytes - old_size + new_size;
+	if (stats->live_bytes > stats->peak_bytes)
+		stats->peak_bytes = stats->live_bytes;
+}
+
+static void stats_reset(x_mset *mset)
+{
+	mset->stats.live_bytes = 0;
+	mset->stats.live_blocks = 0;
+}
+
+#ifndef X_OS_WIN
+static size_t s_mmap_threshold = X_MSET_MMAP_THRESHOLD;
+static int s_mmap_threshold_pinned;
+
+static size_t page_size(void)
+{
+	static size_t size = 0;
+	if (!size)
+		size = sysconf(_SC_PAGESIZE);
+	return size;
+}
+
+static size_t mapped_length(size_t size)
+{
+	return x_align(sizeof(x_mblock) + size, page_size());
+}
+
+static x_mblock *mapped_new(size_t size)
+{
+	void *p = mmap(NULL, mapped_length(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		return NULL;
+	x_mblock *b = p;
+	b->size = size | MBLOCK_MAPPED;
+	return b;
+}
+
+static x_mblock *mapped_resize(x_mblock *b, size_t size)
+{
+	size_t old_len = mapped_length(MBLOCK_SIZE(b)), new_len = mapped_length(size);
+	size_t flags = MBLOCK_MAPPED | (b->size & MBLOCK_COUNTED);
+	if (old_len == new_len) {
+		b->size = size | flags;
+		return b;
+	}
+#ifdef __linux__
+	/* Pages are moved by remapping the page tables, contents are not copied */
+	void *p = mremap(b, old_len, new_len, MREMAP_MAYMOVE);
+	if (p == MAP_FAILED)
+		return NULL;
+	x_mblock *new_blk = p;
+	new_blk->size = size | flags;
+#else
+	x_mblock *new_blk = mapped_new(size);
+	if (!new_blk)
+		return NULL;
+	new_blk->mset = b->mset;
+	new_blk->size |= b->size & MBLOCK_COUNTED;
+	memcpy(new_blk->data, b->data, x_min(MBLOCK_SIZE(b), size));
+	munmap(b, old_len);
+#endif
+	return new_blk;
+}
+#endif
+
+static x_mblock *block_new(size_t size)
+{
+	x_mblock *b = NULL;
+#ifndef X_OS_WIN
+	if (size >= x_atomic_load(&s_mmap_threshold, X_ATOMIC_RELAXED))
+		b = mapped_new(size);
+#endif
+	if (!b) {
+		b = retry_malloc(sizeof *b + size);
+		b->size = size;
+	}
+	return b;
+}
+
+static void block_release(x_mblock *b)
+{
+#ifndef X_OS_WIN
+	if (MBLOCK_IS_MAPPED(b)) {
+		size_t size = MBLOCK_SIZE(b);
+		munmap(b, mapped_length(size));
+		/* A block of this size was freed, the next ones come from the heap */
+		if (!x_atomic_load(&s_mmap_threshold_pinned, X_ATOMIC_RELAXED)
+				&& size >= x_atomic_load(&s_mmap_threshold, X_ATOMIC_RELAXED)
+				&& size <= X_MSET_MMAP_THRESHOLD_MAX)
+			x_atomic_store(&s_mmap_threshold, size + 1, X_ATOMIC_RELAXED);
+		return;
+	}
+#endif
+	free(b);
+}
+
+static x_mblock *block_resize(x_mblock *b, size_t size)
+{
+	x_mblock *new_blk = NULL;
+#ifndef X_OS_WIN
+	if (MBLOCK_IS_MAPPED(b)) {
+		if ((new_blk = mapped_resize(b, size)))
+			return new_blk;
+	}
+	else if (size >= x_atomic_load(&s_mmap_threshold, X_ATOMIC_RELAXED)
+			&& (new_blk = mapped_new(size))) {
+		new_blk->mset = b->mset;
+		new_blk->size |= b->size & MBLOCK_COUNTED;
+		memcpy(new_blk->data, b->data, x_min(MBLOCK_SIZE(b), size));
+		free(b);
+		return new_blk;
+	}
+	if (MBLOCK_IS_MAPPED(b)) {
+		/* Out of address space for the mapping, fall back to the heap */
+		new_blk = retry_malloc(sizeof *b + size);
+		size_t counted = b->size & MBLOCK_COUNTED;
+		memcpy(new_blk, b, sizeof *b + x_min(MBLOCK_SIZE(b), size));
+		block_release(b);
+		new_blk->size = size | counted;
+		return new_blk;
+	}
+#endif
+	size_t counted = b->size & MBLOCK_COUNTED;
+	new_blk = realloc(b, sizeof *b + size);
+	if (new_blk)
+		b = NULL;
+	while (!new_blk) {
+		x_thread_sleep(RETRY_INTERVAL);
+		x_mblock **bp = &b;
+		new_blk = realloc(*bp, sizeof *new_blk + size);
+	}
+	new_blk->size = size | counted;
+	return new_blk;
+}
+
+static struct arena_chunk *arena_chunk_new(size_t size)
+{
+	struct arena_chunk *c = retry_malloc(ARENA_CHUNK_HEAD + size);
+	c->size = size;
+	return c;
+}
+
+static void arena_release(x_mset *mset, bool keep_current)
+{
+	x_link *cur_chunk = (keep_current && mset->cur) ? x_list_first(&mset->list) : NULL;
+	while (!x_list_is_empty(&mset->list)) {
+		x_link *pos = x_list_last(&mset->list);
+		if (pos == cur_chunk)
+			break;
+		x_list_del(pos);
+		free(x_container_of(pos, struct arena_chunk, link));
+	}
+	if (cur_chunk)
+		mset->cur = ARENA_CHUNK_DATA(x_container_of(cur_chunk, struct arena_chunk, link));
+	else
+		mset->cur = mset->end = NULL;
+}
+
+static struct arena_block *arena_carve(x_mset *mset, size_t size)
+{
+	struct arena_block *b;
+	size_t need = ARENA_BLOCK_SIZE(size);
+	if (need > (size_t)(mset->end - mset->cur)) {
+		struct arena_chunk *c;
+		if (need > mset->chunk_size / 4) {
+			/* Oversized blocks get a private chunk, the bump chunk stays in use */
+			c = arena_chunk_new(need);
+			x_list_add_back(&mset->list, &c->link);
+			b = (struct arena_block *)ARENA_CHUNK_DATA(c);
+			goto out;
+		}
+		c = arena_chunk_new(mset->chunk_size);
+		x_list_add_front(&mset->list, &c->link);
+		mset->cur = ARENA_CHUNK_DATA(c);
+		mset->end = mset->cur + mset->chunk_size;
+	}
+	b = (struct arena_block *)mset->cur;
+	mset->cur += need;
+out:
+	b->size = size;
+	b->mset = mset;
+	return b;
+}
+
+static void *arena_alloc(x_mset *mset, size_t size, const x_location *loc)
+{
+	struct arena_block *b = arena_carve(mset, size);
+	if (mset->flags & X_MSET_STATS)
+		stats_alloc(mset, &b->size, loc);
+	return b->data;
+}
+
+static bool arena_is_last(x_mset *mset, struct arena_block *b)
+{
+	return (uint8_t *)b + ARENA_BLOCK_SIZE(MBLOCK_SIZE(b)) == mset->cur;
+}
+
+static void arena_free(x_mset *mset, struct arena_block *b)
+{
+	if (mset->flags & X_MSET_STATS)
+		stats_free(mset, &b->size);
+	/* Only the most recent block can be given back, others wait for x_mset_clear */
+	if (arena_is_last(mset, b))
+		mset->cur = (uint8_t *)b;
+}
+
+static void *arena_realloc(x_mset *mset, struct arena_block *b, size_t size)
+{
+	size_t old_size = MBLOCK_SIZE(b), counted = b->size & MBLOCK_COUNTED;
+	if (arena_is_last(mset, b) && ARENA_BLOCK_SIZE(size) <= (size_t)(mset->end - (uint8_t *)b)) {
+		if (counted)
+			stats_resize(mset, old_size, size);
+		b->size = size | counted;
+		mset->cur = (uint8_t *)b + ARENA_BLOCK_SIZE(size);
+		return b->data;
+	}
+	if (size <= old_size)
+		return b->data;
+	struct arena_block *new_blk = arena_carve(mset, size);
+	memcpy(new_blk->data, b->data, old_size);
+	if (counted) {
+		new_blk->size |= counted;
+		stats_resize(mset, old_size, size);
+	}
+	return new_blk->data;
+}
+
 void x_mset_init(x_mset *mset)
 {
 	x_mutex_init(&mset->lock);
 	x_list_init(&mset->list);
+	mset->flags = 0;
+	mset->chunk_size = 0;
+	mset->cur = mset->end = NULL;
+	memset(&mset->stats, 0, sizeof mset->stats);
+	mset->sites = NULL;
+}
+
+void x_mset_init_arena(x_mset *mset, size_t chunk_size)
+{
+	x_list_init(&mset->list);
+	mset->flags = X_MSET_ARENA;
+	mset->chunk_size = chunk_size ? x_align(chunk_size, ARENA_ALIGN) : X_MSET_ARENA_CHUNK_SIZE;
+	mset->cur = mset->end = NULL;
+	memset(&mset->stats, 0, sizeof mset->stats);
+	mset->sites = NULL;
 }
 
 void x_mset_clear(x_mset *mset)
 {
 	if (!mset)
 		mset = &s_mset;
+	stats_reset(mset);
+	if (mset->flags & X_MSET_ARENA) {
+		arena_release(mset, true);
+		return;
+	}
 	while (!x_list_is_empty(&mset->list)) {
 		x_link *pos = x_list_first(&mset->list);
 		x_list_del(pos);
-		free(x_container_of(pos, x_mblock, link));
+		block_release(x_container_of(pos, x_mblock, link));
 	}
 }
 
@@ -77,21 +453,37 @@ void x_mset_free(x_mset *mset)
 		mset = &s_mset;
 	}
 
+	free(mset->sites);
+	mset->sites = NULL;
+	stats_reset(mset);
+	if (mset->flags & X_MSET_ARENA) {
+		arena_release(mset, false);
+		return;
+	}
+
 	while (!x_list_is_empty(&mset->list)) {
 		x_link *pos = x_list_first(&mset->list);
 		x_list_del(pos);
-		free(x_container_of(pos, x_mblock, link));
+		block_release(x_container_of(pos, x_mblock, link));
 	}
 	x_mutex_destroy(&mset->lock);
 }
 
-void *x_malloc(x_mset *mset, size_t size)
+void x_mset_set_mmap_threshold(size_t size)
 {
-	x_mblock *b = malloc(sizeof *b + size);
-	while (!b) {
-		x_thread_sleep(RETRY_INTERVAL);
-		b = malloc(sizeof *b + size);
-	}
+#ifndef X_OS_WIN
+	x_atomic_store(&s_mmap_threshold, size, X_ATOMIC_RELAXED);
+	x_atomic_store(&s_mmap_threshold_pinned, 1, X_ATOMIC_RELAXED);
+#else
+	(void)size;
+#endif
+}
+
+static void *mset_alloc(x_mset *mset, size_t size, const x_location *loc)
+{
+	if (mset && (mset->flags & X_MSET_ARENA))
+		return arena_alloc(mset, size, loc);
+	x_mblock *b = block_new(size);
 	if (!mset) {
 		x_once_init(&s_mset_once, init_default_mset);
 		mset = &s_mset;
@@ -99,22 +491,49 @@ void *x_malloc(x_mset *mset, size_t size)
 	b->mset = mset;
 	x_mutex_lock(&b->mset->lock);
 	x_list_add_back(&mset->list, &b->link);
+	if (mset->flags & X_MSET_STATS)
+		stats_alloc(mset, &b->size, loc);
 	x_mutex_unlock(&b->mset->lock);
 	return b->data;
 }
 
-void *x_zalloc(x_mset *mset, size_t size)
+void *x_malloc(x_mset *mset, size_t size)
 {
-	void *p = x_malloc(mset, size);
-	memset(p, 0, size);
+	return mset_alloc(mset, size, NULL);
+}
+
+void *__x_malloc_at(const x_location *loc, x_mset *mset, size_t size)
+{
+	return mset_alloc(mset, size, loc);
+}
+
+static void *mset_zalloc(x_mset *mset, size_t size, const x_location *loc)
+{
+	void *p = mset_alloc(mset, size, loc);
+	/* Fresh anonymous mappings are already zero filled, leave the pages untouched */
+	if ((mset && (mset->flags & X_MSET_ARENA)) || !MBLOCK_IS_MAPPED(x_container_of(p, x_mblock, data)))
+		memset(p, 0, size);
 	return p;
 }
 
+void *x_zalloc(x_mset *mset, size_t size)
+{
+	return mset_zalloc(mset, size, NULL);
+}
+
+void *__x_zalloc_at(const x_location *loc, x_mset *mset, size_t size)
+{
+	return mset_zalloc(mset, size, loc);
+}
+
 void *x_calloc(x_mset *mset, size_t nmemb, size_t size)
 {
-	void *p = x_malloc(mset, nmemb * size);
-	memset(p, 0, nmemb * size);
-	return p;
+	return mset_zalloc(mset, nmemb * size, NULL);
+}
+
+void *__x_calloc_at(const x_location *loc, x_mset *mset, size_t nmemb, size_t size)
+{
+	return mset_zalloc(mset, nmemb * size, loc);
 }
 
 void *x_realloc(void *ptr, size_t size)
@@ -123,21 +542,20 @@ void *x_realloc(void *ptr, size_t size)
 		return x_malloc(NULL, size);
 	x_mblock *b = x_container_of(ptr, x_mblock, data);
 	assert(b->mset);
+	if (b->mset->flags & X_MSET_ARENA)
+		return arena_realloc(b->mset, x_container_of(ptr, struct arena_block, data), size);
+	size_t old_size = MBLOCK_SIZE(b);
 	x_mutex_lock(&b->mset->lock);
 	x_list_del(&b->link);
 	x_mutex_unlock(&b->mset->lock);
-	x_mblock *new_blk = realloc(b, sizeof *b + size);
-	if (new_blk)
-		b = NULL;
-	while (!new_blk) {
-		x_thread_sleep(RETRY_INTERVAL);
-		x_mblock **bp = &b;
-		new_blk = realloc(*bp, sizeof *b + size);
-	}
+	x_mblock *new_blk = block_resize(b, size);
 	if (new_blk->mset) {
-		x_mutex_lock(&new_blk->mset->lock);
-		x_list_add_back(&new_blk->mset->list, &new_blk->link);
-		x_mutex_unlock(&new_blk->mset->lock);
+		x_mset *mset = new_blk->mset;
+		x_mutex_lock(&mset->lock);
+		x_list_add_back(&mset->list, &new_blk->link);
+		if (MBLOCK_IS_COUNTED(new_blk))
+			stats_resize(mset, old_size, size);
+		x_mutex_unlock(&mset->lock);
 	}
 	return new_blk->data;
 }
@@ -148,20 +566,29 @@ void x_free(void *ptr)
 		return;
 	x_mblock *b = x_container_of(ptr, x_mblock, data);
 	assert(b->mset);
+	if (b->mset->flags & X_MSET_ARENA) {
+		arena_free(b->mset, x_container_of(ptr, struct arena_block, data));
+		return;
+	}
 	x_mutex_lock(&b->mset->lock);
 	x_list_del(&b->link);
+	if (b->mset->flags & X_MSET_STATS)
+		stats_free(b->mset, &b->size);
 	x_mutex_unlock(&b->mset->lock);
-	free(b);
+	block_release(b);
 }
 
 void x_mdetach(void *ptr)
 {
 	x_mblock *b = x_container_of(ptr, x_mblock, data);
+	x_assert(!b->mset || !(b->mset->flags & X_MSET_ARENA), "arena blocks can not be detached");
 	if (b->mset) {
-		x_mutex_lock(&b->mset->lock);
-		b->mset = NULL;
-		x_mutex_unlock(&b->mset->lock);
+		x_mset *mset = b->mset;
+		x_mutex_lock(&mset->lock);
 		x_list_del(&b->link);
+		if (mset->flags & X_MSET_STATS)
+			stats_free(mset, &b->size);
+		x_mutex_unlock(&mset->lock);
 		b->mset = NULL;
 	}
 }
@@ -169,18 +596,152 @@ void x_mdetach(void *ptr)
 void x_mattach(x_mset *mset, void *ptr)
 {
 	x_mblock *b = x_container_of(ptr, x_mblock, data);
+	x_assert(!mset || !(mset->flags & X_MSET_ARENA), "blocks can not be attached to arena");
 	x_mdetach(ptr);
-	b->mset = mset;
-	if (!mset)
+	if (!mset) {
+		x_once_init(&s_mset_once, init_default_mset);
 		mset = &s_mset;
-	x_mutex_lock(&b->mset->lock);
+	}
+	b->mset = mset;
+	x_mutex_lock(&mset->lock);
 	x_list_add_back(&mset->list, &b->link);
-	x_mutex_unlock(&b->mset->lock);
+	if (mset->flags & X_MSET_STATS)
+		stats_alloc(mset, &b->size, NULL);
+	x_mutex_unlock(&mset->lock);
+}
+
+int x_mhuge(void *ptr)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	x_mblock *b = x_container_of(ptr, x_mblock, data);
+	if (b->mset && (b->mset->flags & X_MSET_ARENA))
+		return -1;
+	if (!MBLOCK_IS_MAPPED(b) || MBLOCK_SIZE(b) < HUGE_PAGE_SIZE)
+		return -1;
+	return madvise(b, mapped_length(MBLOCK_SIZE(b)), MADV_HUGEPAGE) ? -1 : 0;
+#else
+	return -1;
+#endif
 }
 
 void *x_mcopy(x_mset *mset, const void *ptr, size_t size)
 {
-	void *new_ptr = x_malloc(mset, size);
+	void *new_ptr = mset_alloc(mset, size, NULL);
 	memcpy(new_ptr, ptr, size);
 	return new_ptr;
 }
+
+void *__x_mcopy_at(const x_location *loc, x_mset *mset, const void *ptr, size_t size)
+{
+	void *new_ptr = mset_alloc(mset, size, loc);
+	memcpy(new_ptr, ptr, size);
+	return new_ptr;
+}
+
+static void mset_lock(x_mset *mset)
+{
+	if (!(mset->flags & X_MSET_ARENA))
+		x_mutex_lock(&mset->lock);
+}
+
+static void mset_unlock(x_mset *mset)
+{
+	if (!(mset->flags & X_MSET_ARENA))
+		x_mutex_unlock(&mset->lock);
+}
+
+int x_mset_stats_enable(x_mset *mset, bool sites)
+{
+	struct x_mset_site_table_st *table = NULL;
+	if (!mset) {
+		x_once_init(&s_mset_once, init_default_mset);
+		mset = &s_mset;
+	}
+	/* Plain malloc, the table must not be accounted in any mset */
+	if (sites && !(table = calloc(1, sizeof *table)))
+		return -1;
+	mset_lock(mset);
+	if (!(mset->flags & X_MSET_STATS)) {
+		memset(&mset->stats, 0, sizeof mset->stats);
+		mset->stats.since = x_time_tick();
+		mset->flags |= X_MSET_STATS;
+	}
+	if (table && !mset->sites) {
+		mset->sites = table;
+		table = NULL;
+	}
+	mset_unlock(mset);
+	free(table);
+	return 0;
+}
+
+void x_mset_stats_get(x_mset *mset, x_mset_stats *stats)
+{
+	if (!mset)
+		mset = &s_mset;
+	mset_lock(mset);
+	*stats = mset->stats;
+	mset_unlock(mset);
+}
+
+static int site_cmp(const void *p1, const void *p2)
+{
+	const struct site *s1 = p1, *s2 = p2;
+	return (s1->bytes < s2->bytes) - (s1->bytes > s2->bytes);
+}
+
+static x_dump *dump_site(const struct site *st)
+{
+	x_uchar label[256];
+	if (st->file)
+		x_snprintf(label, x_arrlen(label), x_u("%s:%d"), st->file, st->line);
+	else
+		x_snprintf(label, x_arrlen(label), x_u("unknown"));
+	return x_dump_pair(x_dump_str(label),
+			x_dump_block(x_u("site"),
+				x_dump_pair(x_dump_symbol(x_u("count")), x_dump_uint(st->cnt)),
+				x_dump_pair(x_dump_symbol(x_u("bytes")), x_dump_uint(st->bytes)),
+				NULL));
+}
+
+x_dump *x_mset_stats_dump(x_mset *mset)
+{
+	x_mset_stats stats;
+	struct site *sites = NULL;
+	size_t nsites = 0;
+	if (!mset)
+		mset = &s_mset;
+
+	mset_lock(mset);
+	stats = mset->stats;
+	if (mset->sites) {
+		sites = malloc((mset->sites->used + 1) * sizeof *sites);
+		for (size_t i = 0; sites && i < X_MSET_SITE_MAX; i++)
+			if (mset->sites->table[i].cnt)
+				sites[nsites++] = mset->sites->table[i];
+		if (sites && mset->sites->other.cnt)
+			sites[nsites++] = mset->sites->other;
+	}
+	mset_unlock(mset);
+
+	uint64_t elapsed = x_time_tick() - stats.since;
+	double secs = elapsed ? elapsed / 1000.0 : 1.0;
+	x_dump *dmp = x_dump_block(x_u("mset"),
+			x_dump_pair(x_dump_symbol(x_u("live_bytes")), x_dump_uint(stats.live_bytes)),
+			x_dump_pair(x_dump_symbol(x_u("live_blocks")), x_dump_uint(stats.live_blocks)),
+			x_dump_pair(x_dump_symbol(x_u("peak_bytes")), x_dump_uint(stats.peak_bytes)),
+			x_dump_pair(x_dump_symbol(x_u("alloc_count")), x_dump_uint(stats.alloc_cnt)),
+			x_dump_pair(x_dump_symbol(x_u("free_count")), x_dump_uint(stats.free_cnt)),
+			x_dump_pair(x_dump_symbol(x_u("alloc_rate")), x_dump_float(stats.alloc_cnt / secs)),
+			x_dump_pair(x_dump_symbol(x_u("free_rate")), x_dump_float(stats.free_cnt / secs)),
+			NULL);
+	if (!sites)
+		return dmp;
+
+	qsort(sites, nsites, sizeof *sites, site_cmp);
+	x_dump *sites_dmp = x_dump_empty_block(x_u("sites"), nsites);
+	for (size_t i = 0; i < nsites; i++)
+		x_dump_bind(sites_dmp, i, dump_site(sites + i));
+	free(sites);
+	return x_dump_block(x_u("mset_stats"), dmp, sites_dmp, NULL);
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/memory.h"
+#include "x/thread.h"
+#include "x/tss.h"
+#include "x/list.h"
+#include "x/mutex.h"
+#include "x/macros.h"
+#include "x/string.h"
+#include "x/compiler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RETRY_INTERVAL 20
+#define OBJ_ALIGN (2 * sizeof(void *))
+#define SLAB_HEAD x_align(sizeof(x_link), OBJ_ALIGN)
+
+struct x_mpool_magazine_st
+{
+	struct x_mpool_magazine_st *next;
+	size_t cnt;
+	void *objs[X_MPOOL_MAGAZINE_SIZE];
+};
+
+struct mpool_cache
+{
+	x_link link;
+	x_mpool *pool;
+	struct x_mpool_magazine_st *loaded, *prev;
+};
+
+typedef struct x_mpool_magazine_st magazine;
+
+static void *retry_malloc(size_t size)
+{
+	void *p = malloc(size);
+	while (!p) {
+		x_thread_sleep(RETRY_INTERVAL);
+		p = malloc(size);
+	}
+	return p;
+}
+
+static magazine *mag_pop(magazine **list)
+{
+	magazine *m = *list;
+	if (m)
+		*list = m->next;
+	return m;
+}
+
+static void mag_push(magazine **list, magazine *m)
+{
+	m->next = *list;
+	*list = m;
+}
+
+static void mag_free_list(magazine *list)
+{
+	while (list) {
+		magazine *next = list->next;
+		free(list);
+		list = next;
+	}
+}
+
+/* Must be called with pool->lock held */
+static magazine *depot_empty_mag(x_mpool *pool)
+{
+	magazine *m = mag_pop(&pool->empty);
+	if (!m)
+		m = retry_malloc(sizeof *m);
+	m->cnt = 0;
+	return m;
+}
+
+/* Must be called with pool->lock held */
+static void depot_return_mag(x_mpool *pool, magazine *m)
+{
+	mag_push(m->cnt ? &pool->full : &pool->empty, m);
+}
+
+/* Must be called with pool->lock held, carves at least one object */
+static void slab_fill(x_mpool *pool, magazine *m)
+{
+	while (m->cnt < X_MPOOL_MAGAZINE_SIZE) {
+		if (pool->cur + pool->obj_size > pool->end) {
+			if (m->cnt)
+				break;
+			x_link *slab = retry_malloc(pool->slab_size);
+			x_list_add_back(&pool->slab_list, slab);
+			pool->cur = (uint8_t *)slab + SLAB_HEAD;
+			pool->end = (uint8_t *)slab + pool->slab_size;
+		}
+		m->objs[m->cnt++] = pool->cur;
+		pool->cur += pool->obj_size;
+	}
+}
+
+static void cache_release(void *ptr)
+{
+	struct mpool_cache *cache = ptr;
+	x_mpool *pool = cache->pool;
+	x_mutex_lock(&pool->lock);
+	depot_return_mag(pool, cache->loaded);
+	depot_return_mag(pool, cache->prev);
+	x_list_del(&cache->link);
+	x_mutex_unlock(&pool->lock);
+	free(cache);
+}
+
+static struct mpool_cache *cache_get(x_mpool *pool)
+{
+	struct mpool_cache *cache = x_tss_get(&pool->cache);
+	if (cache)
+		return cache;
+	cache = retry_malloc(sizeof *cache);
+	cache->pool = pool;
+	x_mutex_lock(&pool->lock);
+	cache->loaded = depot_empty_mag(pool);
+	cache->prev = depot_empty_mag(pool);
+	x_list_add_back(&pool->cache_list, &cache->link);
+	x_mutex_unlock(&pool->lock);
+	x_tss_set(&pool->cache, cache);
+	return cache;
+}
+
+int x_mpool_init(x_mpool *pool, size_t obj_size)
+{
+	assert(pool);
+	if (x_tss_init(&pool->cache, cache_release))
+		return -1;
+	if (obj_size < sizeof(void *))
+		obj_size = sizeof(void *);
+	pool->obj_size = x_align(obj_size, obj_size < OBJ_ALIGN ? sizeof(void *) : OBJ_ALIGN);
+	pool->slab_size = x_max(X_MPOOL_SLAB_SIZE, SLAB_HEAD + pool->obj_size * X_MPOOL_MAGAZINE_SIZE);
+	x_mutex_init(&pool->lock);
+	x_list_init(&pool->slab_list);
+	x_list_init(&pool->cache_list);
+	pool->full = pool->empty = NULL;
+	pool->cur = pool->end = NULL;
+	return 0;
+}
+
+void x_mpool_free(x_mpool *pool)
+{
+	if (!pool)
+		return;
+	x_tss_remove(&pool->cache);
+	x_list_popeach(cur, &pool->cache_list) {
+		struct mpool_cache *cache = x_container_of(cur, struct mpool_cache, link);
+		free(cache->loaded);
+		free(cache->prev);
+		free(cache);
+	}
+	mag_free_list(pool->full);
+	mag_free_list(pool->empty);
+	x_list_popeach(cur, &pool->slab_list)
+		free(cur);
+	x_mutex_destroy(&pool->lock);
+}
+
+void *x_mpool_get(x_mpool *pool)
+{
+	struct mpool_cache *cache = cache_get(pool);
+	if (X_UNLIKELY(cache->loaded->cnt == 0)) {
+		if (cache->prev->cnt)
+			x_swap(&cache->loaded, &cache->prev, magazine *);
+		else {
+			x_mutex_lock(&pool->lock);
+			magazine *m = mag_pop(&pool->full);
+			if (m) {
+				depot_return_mag(pool, cache->prev);
+				cache->prev = cache->loaded;
+				cache->loaded = m;
+			}
+			else
+				slab_fill(pool, cache->loaded);
+			x_mutex_unlock(&pool->lock);
+		}
+	}
+	return cache->loaded->objs[--cache->loaded->cnt];
+}
+
+void x_mpool_put(x_mpool *pool, void *obj)
+{
+	if (!obj)
+		return;
+	struct mpool_cache *cache = cache_get(pool);
+	if (X_UNLIKELY(cache->loaded->cnt == X_MPOOL_MAGAZINE_SIZE)) {
+		if (cache->prev->cnt == 0)
+			x_swap(&cache->loaded, &cache->prev, magazine *);
+		else {
+			x_mutex_lock(&pool->lock);
+			depot_return_mag(pool, cache->prev);
+			cache->prev = cache->loaded;
+			cache->loaded = depot_empty_mag(pool);
+			x_mutex_unlock(&pool->lock);
+		}
+	}
+	cache->loaded->objs[cache->loaded->cnt++] = obj;
+}
@@ -66,6 +66,7 @@ void epoll_mux_free(x_sockmux *mux)
 {
 	x_free(mux->events);
 	close_epoll(mux->epoll_fd);
+	x_free(mux);
 }
 
 
@@ -78,17 +79,26 @@ static inline int epoll_setup_mask(short flags)
 		ret |= EPOLLOUT;
 	if (flags & X_EV_ONCE)
 		ret |= EPOLLONESHOT;
+#ifdef EPOLLET
+	if (flags & X_EV_EDGE)
+		ret |= EPOLLET;
+#endif
+#ifdef EPOLLEXCLUSIVE
+	/* the kernel only accepts IN/OUT/ERR/HUP/ET next to EXCLUSIVE */
+	if ((flags & X_EV_EXCLUSIVE) && !(flags & X_EV_ONCE))
+		ret = (ret & ~EPOLLPRI) | EPOLLEXCLUSIVE;
+#endif
 	return ret;
 }
 
-static int epoll_mux_add(x_sockmux *mux, x_sock fd, short flags)
+static int epoll_mux_add(x_sockmux *mux, x_sock fd, short flags, void *ptr)
 {
 	struct epoll_event e;
 	int ret;
 	assert(mux != NULL);
 	if (mux->n_events >= mux->max_events)
 		epoll_resize(mux, mux->max_events << 1);
-	e.data.fd = fd;
+	e.data.ptr = ptr;
 	e.events = epoll_setup_mask(flags);
 	ret = epoll_ctl(mux->epoll_fd, EPOLL_CTL_ADD, fd, &e);
 	if (ret) {
@@ -106,12 +116,23 @@ out:
 	return 0;
 }
 
-static int epoll_mux_mod(x_sockmux *mux, x_sock fd, short flags)
+static int epoll_mux_mod(x_sockmux *mux, x_sock fd, short flags, void *ptr)
 {
 	assert(mux != NULL);
 	struct epoll_event e;
-	e.data.fd = fd;
+	e.data.ptr = ptr;
 	e.events = epoll_setup_mask(flags);
+#ifdef EPOLLEXCLUSIVE
+	/* EPOLL_CTL_MOD refuses exclusive entries, re-add them instead */
+	if (e.events & EPOLLEXCLUSIVE) {
+		(void)epoll_ctl(mux->epoll_fd, EPOLL_CTL_DEL, fd, &e);
+		if (epoll_ctl(mux->epoll_fd, EPOLL_CTL_ADD, fd, &e)) {
+			x_eval_errno();
+			return -1;
+		}
+		return 0;
+	}
+#endif
 	if (epoll_ctl(mux->epoll_fd, EPOLL_CTL_MOD, fd, &e)) {
 		x_eval_errno();
 		return -1;
@@ -123,7 +144,7 @@ static void epoll_mux_del(x_sockmux *mux, x_sock fd, short flags)
 {
 	assert(mux != NULL);
 	struct epoll_event e;
-	e.data.fd = fd;
+	e.data.ptr = NULL;
 	e.events = epoll_setup_mask(flags);
 	(void)epoll_ctl(mux->epoll_fd, EPOLL_CTL_DEL, fd, &e);
 	--mux->n_events;
@@ -143,21 +164,22 @@ static int epoll_mux_poll(x_sockmux *mux, struct timeval * timeout)
 	return nreadys;
 }
 
-static x_sock epoll_mux_next(x_sockmux *mux, short *res_flags)
+static void *epoll_mux_next(x_sockmux *mux, short *res_flags)
 {
 	*res_flags = 0;
 	for (int i = mux->iterator; i < mux->nreadys; i++) {
-		if (mux->events[i].events & (EPOLLIN | EPOLLPRI))
+		uint32_t events = mux->events[i].events;
+		if (events & (EPOLLIN | EPOLLPRI))
 			*res_flags |= X_EV_READ;
-		if (mux->events[i].events & EPOLLOUT)
+		if (events & EPOLLOUT)
 			*res_flags |= X_EV_WRITE;
-		if (mux->events[i].events & EPOLLERR)
+		if (events & EPOLLERR)
 			*res_flags |= X_EV_ERROR;
 		mux->iterator = i + 1;
 		if (*res_flags)
-			return mux->events[i].data.fd;
+			return mux->events[i].data.ptr;
 	}
-	return X_BADSOCK;
+	return NULL;
 }
 
 const struct x_sockmux_ops_st x_sockmux_epoll = {
@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+#include "x/sockmux.h"
+#include "x/event.h"
+#include "x/memory.h"
+#include "x/mutex.h"
+#include "x/errno.h"
+#include "x/detect.h"
+
+#if defined(X_OS_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef IORING_FEAT_EXT_ARG
+#define MUX_URING
+#endif
+#endif
+#endif
+
+#ifdef MUX_URING
+
+#include "x/atomic.h"
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+/*
+ * io_uring readiness backend. Every registered socket has one outstanding
+ * one-shot IORING_OP_POLL_ADD; a poll that fired is re-armed at the next
+ * m_poll, after the caller had its chance to consume the data, so the
+ * semantics stay level triggered like x_sockmux_epoll. Adds, modifications
+ * and re-arms are only queued in the SQ ring and go to the kernel with the
+ * io_uring_enter that also waits for completions, one syscall per loop.
+ * X_EV_EDGE sockets use a multishot poll instead, which reports each new
+ * wakeup and stays armed, so they need no re-arm at all. X_EV_EXCLUSIVE
+ * has no io_uring equivalent and is ignored.
+ */
+
+#define URING_SQ_ENTRIES 256
+#define URING_CQ_ENTRIES 4096
+#define URING_TAG_IGNORE UINT64_MAX
+#define URING_TAG(fd, gen) (((uint64_t)(gen) << 32) | (uint32_t)(fd))
+
+#ifndef IORING_POLL_ADD_MULTI
+#define URING_NO_MULTISHOT
+#define IORING_POLL_ADD_MULTI 0
+#define IORING_CQE_F_MORE 0
+#endif
+
+struct poll_slot
+{
+	void *ptr;
+	uint32_t gen;
+	uint32_t mask;
+	bool active;
+	bool armed;
+	bool oneshot;
+	bool edge;
+};
+
+struct ready
+{
+	void *ptr;
+	short flags;
+};
+
+struct x_sockmux_st
+{
+	int ring_fd;
+	x_mutex lock;
+
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned sq_mask;
+	unsigned sq_entries;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+	unsigned sq_pending;
+
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe *cqes;
+
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+
+	struct poll_slot *slots;
+	size_t slot_cnt;
+	int *rearm;
+	size_t rearm_cnt;
+	size_t rearm_cap;
+
+	struct ready *readys;
+	size_t nreadys;
+	size_t ready_cap;
+	size_t iterator;
+};
+
+static int sys_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+		unsigned flags, const void *arg, size_t argsz)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static void uring_unmap(x_sockmux *mux)
+{
+	if (mux->sq_ring && mux->sq_ring != MAP_FAILED)
+		munmap(mux->sq_ring, mux->sq_ring_size);
+	if (mux->cq_ring && mux->cq_ring != MAP_FAILED)
+		munmap(mux->cq_ring, mux->cq_ring_size);
+	if (mux->sqes && (void *)mux->sqes != MAP_FAILED)
+		munmap(mux->sqes, mux->sqes_size);
+}
+
+static x_sockmux *uring_mux_create(void)
+{
+	struct io_uring_params p;
+	x_sockmux *mux = x_malloc(NULL, sizeof *mux);
+	memset(mux, 0, sizeof *mux);
+	memset(&p, 0, sizeof p);
+	p.flags = IORING_SETUP_CQSIZE;
+	p.cq_entries = URING_CQ_ENTRIES;
+	if ((mux->ring_fd = sys_uring_setup(URING_SQ_ENTRIES, &p)) < 0)
+		goto fail;
+	/* Timed waits need EXT_ARG, and a poll per socket may overflow the CQ */
+	if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_NODROP))
+		goto fail;
+
+	mux->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	mux->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	mux->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	mux->sq_ring = mmap(NULL, mux->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			mux->ring_fd, IORING_OFF_SQ_RING);
+	mux->cq_ring = mmap(NULL, mux->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			mux->ring_fd, IORING_OFF_CQ_RING);
+	mux->sqes = mmap(NULL, mux->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			mux->ring_fd, IORING_OFF_SQES);
+	if (mux->sq_ring == MAP_FAILED || mux->cq_ring == MAP_FAILED || (void *)mux->sqes == MAP_FAILED)
+		goto fail;
+
+	char *sq = mux->sq_ring, *cq = mux->cq_ring;
+	mux->sq_head = (unsigned *)(sq + p.sq_off.head);
+	mux->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	mux->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+	mux->sq_entries = p.sq_entries;
+	mux->sq_array = (unsigned *)(sq + p.sq_off.array);
+	mux->cq_head = (unsigned *)(cq + p.cq_off.head);
+	mux->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	mux->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+	mux->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+	x_mutex_init(&mux->lock);
+	return mux;
+fail:
+	uring_unmap(mux);
+	if (mux->ring_fd >= 0)
+		close(mux->ring_fd);
+	x_free(mux);
+	return NULL;
+}
+
+static void uring_mux_free(x_sockmux *mux)
+{
+	uring_unmap(mux);
+	close(mux->ring_fd);
+	x_mutex_destroy(&mux->lock);
+	x_free(mux->slots);
+	x_free(mux->rearm);
+	x_free(mux->readys);
+	x_free(mux);
+}
+
+/*
+ * Called with mux->lock held. Entries the kernel did not take stay counted
+ * in sq_pending for the next enter, and an enter that takes none is an
+ * error rather than a reason to spin.
+ */
+static int uring_flush(x_sockmux *mux)
+{
+	while (mux->sq_pending) {
+		int ret = sys_uring_enter(mux->ring_fd, mux->sq_pending, 0, 0, NULL, 0);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0) {
+			if (ret == 0)
+				errno = EAGAIN;
+			x_eval_errno();
+			return -1;
+		}
+		mux->sq_pending -= ret;
+	}
+	return 0;
+}
+
+static struct io_uring_sqe *uring_get_sqe(x_sockmux *mux)
+{
+	unsigned tail = *mux->sq_tail;
+	if (tail - x_atomic_load(mux->sq_head, X_ATOMIC_ACQUIRE) == mux->sq_entries) {
+		(void)uring_flush(mux);
+		if (tail - x_atomic_load(mux->sq_head, X_ATOMIC_ACQUIRE) == mux->sq_entries)
+			return NULL;
+	}
+	struct io_uring_sqe *sqe = &mux->sqes[tail & mux->sq_mask];
+	memset(sqe, 0, sizeof *sqe);
+	mux->sq_array[tail & mux->sq_mask] = tail & mux->sq_mask;
+	return sqe;
+}
+
+static void uring_commit_sqe(x_sockmux *mux)
+{
+	x_atomic_store(mux->sq_tail, *mux->sq_tail + 1, X_ATOMIC_RELEASE);
+	mux->sq_pending++;
+}
+
+static uint32_t uring_poll_mask(short flags)
+{
+	uint32_t mask = 0;
+	if (flags & X_EV_READ)
+		mask |= POLLIN | POLLPRI;
+	if (flags & X_EV_WRITE)
+		mask |= POLLOUT;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	mask = (mask << 16) | (mask >> 16);
+#endif
+	return mask;
+}
+
+static int uring_arm(x_sockmux *mux, int fd, struct poll_slot *slot)
+{
+	struct io_uring_sqe *sqe = uring_get_sqe(mux);
+	if (!sqe) {
+		errno = X_EBUSY;
+		return -1;
+	}
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = slot->mask;
+	if (slot->edge)
+		sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->user_data = URING_TAG(fd, slot->gen);
+	uring_commit_sqe(mux);
+	slot->armed = true;
+	return 0;
+}
+
+static void uring_disarm(x_sockmux *mux, int fd, struct poll_slot *slot)
+{
+	if (!slot->armed)
+		return;
+	struct io_uring_sqe *sqe = uring_get_sqe(mux);
+	if (sqe) {
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->addr = URING_TAG(fd, slot->gen);
+		sqe->user_data = URING_TAG_IGNORE;
+		uring_commit_sqe(mux);
+	}
+	slot->armed = false;
+}
+
+static struct poll_slot *uring_slot(x_sockmux *mux, x_sock fd)
+{
+	if ((size_t)fd >= mux->slot_cnt) {
+		size_t cnt = mux->slot_cnt ? mux->slot_cnt : 64;
+		while (cnt <= (size_t)fd)
+			cnt *= 2;
+		mux->slots = x_realloc(mux->slots, cnt * sizeof *mux->slots);
+		memset(mux->slots + mux->slot_cnt, 0, (cnt - mux->slot_cnt) * sizeof *mux->slots);
+		mux->slot_cnt = cnt;
+	}
+	return &mux->slots[fd];
+}
+
+static int uring_set(x_sockmux *mux, x_sock fd, short flags, void *ptr, bool adding)
+{
+	int ret = -1;
+	assert(mux != NULL);
+	if (fd < 0) {
+		errno = X_EBADF;
+		return -1;
+	}
+	x_mutex_lock(&mux->lock);
+	struct poll_slot *slot = uring_slot(mux, fd);
+	if (!adding && !slot->active) {
+		errno = X_ENOENT;
+		goto out;
+	}
+	uring_disarm(mux, fd, slot);
+	slot->gen++;
+	slot->ptr = ptr;
+	slot->mask = uring_poll_mask(flags);
+	slot->oneshot = !!(flags & X_EV_ONCE);
+#ifndef URING_NO_MULTISHOT
+	slot->edge = !slot->oneshot && (flags & X_EV_EDGE);
+#endif
+	slot->active = true;
+	ret = uring_arm(mux, fd, slot);
+out:
+	x_mutex_unlock(&mux->lock);
+	return ret;
+}
+
+static int uring_mux_add(x_sockmux *mux, x_sock fd, short flags, void *ptr)
+{
+	return uring_set(mux, fd, flags, ptr, true);
+}
+
+static int uring_mux_mod(x_sockmux *mux, x_sock fd, short flags, void *ptr)
+{
+	return uring_set(mux, fd, flags, ptr, false);
+}
+
+static void uring_mux_del(x_sockmux *mux, x_sock fd, short flags)
+{
+	assert(mux != NULL);
+	x_mutex_lock(&mux->lock);
+	if (fd >= 0 && (size_t)fd < mux->slot_cnt && mux->slots[fd].active) {
+		struct poll_slot *slot = &mux->slots[fd];
+		bool armed = slot->armed;
+		uring_disarm(mux, fd, slot);
+		slot->gen++;
+		slot->active = false;
+		/*
+		 * A pending poll pins the file, submit the removal now so closing
+		 * the socket right after this really releases it.
+		 */
+		if (armed)
+			(void)uring_flush(mux);
+	}
+	x_mutex_unlock(&mux->lock);
+}
+
+static void uring_push_ready(x_sockmux *mux, void *ptr, short flags)
+{
+	if (mux->nreadys == mux->ready_cap) {
+		mux->ready_cap = mux->ready_cap ? mux->ready_cap * 2 : 64;
+		mux->readys = x_realloc(mux->readys, mux->ready_cap * sizeof *mux->readys);
+	}
+	mux->readys[mux->nreadys].ptr = ptr;
+	mux->readys[mux->nreadys].flags = flags;
+	mux->nreadys++;
+}
+
+static void uring_push_rearm(x_sockmux *mux, int fd)
+{
+	if (mux->rearm_cnt == mux->rearm_cap) {
+		mux->rearm_cap = mux->rearm_cap ? mux->rearm_cap * 2 : 64;
+		mux->rearm = x_realloc(mux->rearm, mux->rearm_cap * sizeof *mux->rearm);
+	}
+	mux->rearm[mux->rearm_cnt++] = fd;
+}
+
+static short uring_res_flags(int res)
+{
+	short flags = 0;
+	if (res < 0)
+		return X_EV_ERROR;
+	if (res & (POLLIN | POLLPRI))
+		flags |= X_EV_READ;
+	if (res & POLLOUT)
+		flags |= X_EV_WRITE;
+	if (res & (POLLERR | POLLNVAL))
+		flags |= X_EV_ERROR;
+	if ((res & POLLHUP) && !flags)
+		flags |= X_EV_ERROR;
+	return flags;
+}
+
+static void uring_reap(x_sockmux *mux)
+{
+	unsigned head = *mux->cq_head;
+	unsigned tail = x_atomic_load(mux->cq_tail, X_ATOMIC_ACQUIRE);
+	for (; head != tail; head++) {
+		struct io_uring_cqe *cqe = &mux->cqes[head & mux->cq_mask];
+		if (cqe->user_data == URING_TAG_IGNORE)
+			continue;
+		int fd = (int)(uint32_t)cqe->user_data;
+		uint32_t gen = (uint32_t)(cqe->user_data >> 32);
+		if ((size_t)fd >= mux->slot_cnt)
+			continue;
+		struct poll_slot *slot = &mux->slots[fd];
+		if (!slot->active || slot->gen != gen || cqe->res == -ECANCELED)
+			continue;
+		/* A multishot poll stays armed while the kernel sets F_MORE */
+		if (!slot->edge || !(cqe->flags & IORING_CQE_F_MORE)) {
+			slot->armed = false;
+			if (!slot->oneshot)
+				uring_push_rearm(mux, fd);
+		}
+		short flags = uring_res_flags(cqe->res);
+		if (flags)
+			uring_push_ready(mux, slot->ptr, flags);
+	}
+	x_atomic_store(mux->cq_head, head, X_ATOMIC_RELEASE);
+}
+
+static int uring_mux_poll(x_sockmux *mux, struct timeval *timeout)
+{
+	assert(mux != NULL);
+	x_mutex_lock(&mux->lock);
+	mux->iterator = 0;
+	mux->nreadys = 0;
+	for (size_t i = 0; i < mux->rearm_cnt; i++) {
+		struct poll_slot *slot = &mux->slots[mux->rearm[i]];
+		if (slot->active && !slot->armed && !slot->oneshot)
+			(void)uring_arm(mux, mux->rearm[i], slot);
+	}
+	mux->rearm_cnt = 0;
+	unsigned to_submit = mux->sq_pending;
+	bool ready = *mux->cq_head != x_atomic_load(mux->cq_tail, X_ATOMIC_ACQUIRE);
+	x_mutex_unlock(&mux->lock);
+
+	struct __kernel_timespec ts;
+	struct io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof arg);
+	if (timeout) {
+		ts.tv_sec = timeout->tv_sec;
+		ts.tv_nsec = timeout->tv_usec * 1000;
+		arg.ts = (uint64_t)(uintptr_t)&ts;
+	}
+	int ret = sys_uring_enter(mux->ring_fd, to_submit, ready ? 0 : 1,
+			IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+	if (ret < 0 && errno != ETIME && errno != EINTR) {
+		x_eval_errno();
+		return -1;
+	}
+
+	x_mutex_lock(&mux->lock);
+	/* Only what was submitted, errors are returned when nothing was */
+	if (ret > 0)
+		mux->sq_pending -= ret;
+	uring_reap(mux);
+	int nreadys = (int)mux->nreadys;
+	x_mutex_unlock(&mux->lock);
+	if (nreadys == 0 && ret < 0 && errno == EINTR) {
+		x_eval_errno();
+		return -1;
+	}
+	return nreadys;
+}
+
+static void *uring_mux_next(x_sockmux *mux, short *res_flags)
+{
+	if (mux->iterator >= mux->nreadys)
+		return NULL;
+	struct ready *r = &mux->readys[mux->iterator++];
+	*res_flags = r->flags;
+	return r->ptr;
+}
+
+#else
+
+static x_sockmux *uring_mux_create(void)
+{
+	return NULL;
+}
+
+#define uring_mux_free NULL
+#define uring_mux_add NULL
+#define uring_mux_mod NULL
+#define uring_mux_del NULL
+#define uring_mux_poll NULL
+#define uring_mux_next NULL
+
+#endif
+
+const struct x_sockmux_ops_st x_sockmux_uring = {
+	.m_add = uring_mux_add,
+	.m_mod = uring_mux_mod,
+	.m_del = uring_mux_del,
+	.m_create = uring_mux_create,
+	.m_free = uring_mux_free,
+	.m_poll = uring_mux_poll,
+	.m_next = uring_mux_next,
+};
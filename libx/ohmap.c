@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/ohmap.h"
+#include "x/memory.h"
+#include "x/detect.h"
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GROUP_SSE2
+#elif defined(__ARM_NEON) && defined(X_ARCH_AARCH64)
+#include <arm_neon.h>
+#define GROUP_NEON
+#endif
+
+#define CTRL_EMPTY 0x80
+#define CTRL_DELETED 0xFE
+#define CTRL_IS_FULL(c) (!((c) & 0x80))
+
+#define MIN_CAPACITY 16
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(p) __builtin_prefetch(p)
+#else
+#define PREFETCH(p) ((void)(p))
+#endif
+
+#define LSBS 0x0101010101010101ULL
+#define MSBS 0x8080808080808080ULL
+
+static inline unsigned bit_ctz(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(x);
+#else
+	unsigned n = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+static inline unsigned bit_clz(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_clzll(x);
+#else
+	unsigned n = 0;
+	while (!(x & (1ULL << 63))) {
+		x <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/*
+ * A group is the window of GROUP_WIDTH control bytes starting at any slot.
+ * The match functions return one bit per slot; a set bit is at position
+ * (slot << GROUP_SHIFT) so the slot offset is recovered with ctz.
+ */
+#if defined(GROUP_SSE2)
+
+#define GROUP_WIDTH 16
+#define GROUP_SHIFT 0
+typedef uint32_t group_mask;
+
+static inline group_mask group_match(const uint8_t *ctrl, uint8_t h2)
+{
+	__m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+	return (group_mask)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)h2)));
+}
+
+static inline group_mask group_match_empty(const uint8_t *ctrl)
+{
+	return group_match(ctrl, CTRL_EMPTY);
+}
+
+static inline group_mask group_match_free(const uint8_t *ctrl)
+{
+	return (group_mask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+}
+
+static inline unsigned group_leading(group_mask m)
+{
+	return bit_clz(m) - (64 - GROUP_WIDTH);
+}
+
+#elif defined(GROUP_NEON)
+
+#define GROUP_WIDTH 8
+#define GROUP_SHIFT 3
+typedef uint64_t group_mask;
+
+static inline group_mask group_match(const uint8_t *ctrl, uint8_t h2)
+{
+	uint8x8_t eq = vceq_u8(vld1_u8(ctrl), vdup_n_u8(h2));
+	return vget_lane_u64(vreinterpret_u64_u8(eq), 0) & MSBS;
+}
+
+static inline group_mask group_match_empty(const uint8_t *ctrl)
+{
+	return group_match(ctrl, CTRL_EMPTY);
+}
+
+static inline group_mask group_match_free(const uint8_t *ctrl)
+{
+	return vget_lane_u64(vreinterpret_u64_u8(vld1_u8(ctrl)), 0) & MSBS;
+}
+
+static inline unsigned group_leading(group_mask m)
+{
+	return bit_clz(m) >> GROUP_SHIFT;
+}
+
+#else
+
+#define GROUP_WIDTH 8
+#define GROUP_SHIFT 3
+typedef uint64_t group_mask;
+
+static inline uint64_t group_load(const uint8_t *ctrl)
+{
+	uint64_t w;
+	memcpy(&w, ctrl, sizeof w);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	w = __builtin_bswap64(w);
+#endif
+	return w;
+}
+
+static inline group_mask group_match(const uint8_t *ctrl, uint8_t h2)
+{
+	/* Exact zero byte detection, no false positives from borrows */
+	uint64_t x = group_load(ctrl) ^ (LSBS * h2);
+	return ~(((x & ~MSBS) + ~MSBS) | x | ~MSBS);
+}
+
+static inline group_mask group_match_empty(const uint8_t *ctrl)
+{
+	/* EMPTY is the only control byte with bit 7 set and bit 1 clear */
+	uint64_t w = group_load(ctrl);
+	return w & ~(w << 6) & MSBS;
+}
+
+static inline group_mask group_match_free(const uint8_t *ctrl)
+{
+	return group_load(ctrl) & MSBS;
+}
+
+static inline unsigned group_leading(group_mask m)
+{
+	return bit_clz(m) >> GROUP_SHIFT;
+}
+
+#endif
+
+static inline unsigned group_lowest(group_mask m)
+{
+	return bit_ctz(m) >> GROUP_SHIFT;
+}
+
+static inline uint64_t mix_hash(size_t hash)
+{
+	/* Callers often hash small integers to themselves, spread them first */
+	uint64_t h = (uint64_t)hash * 0x9E3779B97F4A7C15ULL;
+	return h ^ (h >> 32);
+}
+
+static inline size_t capacity_to_growth(size_t cap)
+{
+	return cap - cap / 8;
+}
+
+static inline void set_ctrl(x_ohmap *om, size_t i, uint8_t c)
+{
+	/* The first GROUP_WIDTH bytes are mirrored after the end, so a group
+	 * can be loaded from any slot without wrapping */
+	om->ctrl[i] = c;
+	om->ctrl[((i - GROUP_WIDTH) & om->mask) + GROUP_WIDTH] = c;
+}
+
+static void table_alloc(x_ohmap *om, size_t cap)
+{
+	size_t slots_size = cap * sizeof(x_link *);
+	om->slots = x_malloc(NULL, slots_size + cap + GROUP_WIDTH);
+	if (om->hugepage)
+		(void)x_mhuge(om->slots);
+	om->ctrl = (uint8_t *)om->slots + slots_size;
+	memset(om->ctrl, CTRL_EMPTY, cap + GROUP_WIDTH);
+	om->mask = cap - 1;
+	om->growth_left = capacity_to_growth(cap) - om->elem_cnt;
+}
+
+static size_t find_free(const x_ohmap *om, uint64_t h)
+{
+	size_t pos = (h >> 7) & om->mask, step = 0;
+	for (;;) {
+		group_mask m = group_match_free(om->ctrl + pos);
+		if (m)
+			return (pos + group_lowest(m)) & om->mask;
+		step += GROUP_WIDTH;
+		pos = (pos + step) & om->mask;
+	}
+}
+
+static void rehash(x_ohmap *om, size_t cap)
+{
+	x_link **old_slots = om->slots;
+	uint8_t *old_ctrl = om->ctrl;
+	size_t old_cap = om->mask + 1;
+	table_alloc(om, cap);
+	for (size_t i = 0; i < old_cap; i++) {
+		if (!CTRL_IS_FULL(old_ctrl[i]))
+			continue;
+		uint64_t h = mix_hash(om->hash(old_slots[i]));
+		size_t idx = find_free(om, h);
+		set_ctrl(om, idx, h & 0x7F);
+		om->slots[idx] = old_slots[i];
+	}
+	x_free(old_slots);
+}
+
+static size_t locate(const x_ohmap *om, const x_link *link, uint64_t h, bool by_addr)
+{
+	size_t pos = (h >> 7) & om->mask, step = 0;
+	/* The hit is almost always in the first group, overlap fetching its
+	 * slots with the control bytes instead of waiting for the match */
+	PREFETCH(om->slots + pos);
+	for (;;) {
+		const uint8_t *g = om->ctrl + pos;
+		for (group_mask m = group_match(g, h & 0x7F); m; m &= m - 1) {
+			size_t idx = (pos + group_lowest(m)) & om->mask;
+			x_link *cur = om->slots[idx];
+			if (by_addr ? cur == link : om->equal(link, cur))
+				return idx;
+		}
+		if (group_match_empty(g))
+			return SIZE_MAX;
+		step += GROUP_WIDTH;
+		pos = (pos + step) & om->mask;
+	}
+}
+
+static void insert_new(x_ohmap *om, x_link *link, uint64_t h)
+{
+	size_t idx = find_free(om, h);
+	if (om->ctrl[idx] == CTRL_EMPTY && om->growth_left == 0) {
+		size_t cap = om->mask + 1;
+		/* Mostly tombstones, clean them up without growing */
+		if (om->elem_cnt > capacity_to_growth(cap) / 2)
+			cap *= 2;
+		rehash(om, cap);
+		idx = find_free(om, h);
+	}
+	if (om->ctrl[idx] == CTRL_EMPTY)
+		om->growth_left--;
+	set_ctrl(om, idx, h & 0x7F);
+	om->slots[idx] = link;
+	om->elem_cnt++;
+}
+
+static void erase(x_ohmap *om, size_t idx)
+{
+	/* If no group containing idx has ever been full, probing never went
+	 * past it and the slot can become EMPTY instead of a tombstone */
+	group_mask empty_before = group_match_empty(om->ctrl + ((idx - GROUP_WIDTH) & om->mask));
+	group_mask empty_after = group_match_empty(om->ctrl + idx);
+	bool was_never_full = empty_before && empty_after
+		&& group_lowest(empty_after) + group_leading(empty_before) < GROUP_WIDTH;
+	set_ctrl(om, idx, was_never_full ? CTRL_EMPTY : CTRL_DELETED);
+	if (was_never_full)
+		om->growth_left++;
+	om->slots[idx] = NULL;
+	om->elem_cnt--;
+}
+
+void x_ohmap_init(x_ohmap *om, x_hmap_hash_fn *hash_fn, x_hmap_equal_fn *equal_fn)
+{
+	om->elem_cnt = 0;
+	om->hugepage = false;
+	om->hash = hash_fn;
+	om->equal = equal_fn;
+	table_alloc(om, MIN_CAPACITY);
+}
+
+/* Advise huge pages for the table from now on, once it spans 2MB */
+void x_ohmap_set_hugepage(x_ohmap *om, bool hugepage)
+{
+	om->hugepage = hugepage;
+	if (hugepage)
+		(void)x_mhuge(om->slots);
+}
+
+void x_ohmap_reserve(x_ohmap *om, size_t elem_cnt)
+{
+	size_t cap = om->mask + 1;
+	while (capacity_to_growth(cap) < elem_cnt)
+		cap *= 2;
+	if (cap != om->mask + 1)
+		rehash(om, cap);
+}
+
+x_link *x_ohmap_find(x_ohmap *om, const x_link *link)
+{
+	size_t idx = locate(om, link, mix_hash(om->hash(link)), false);
+	return idx == SIZE_MAX ? NULL : om->slots[idx];
+}
+
+x_link *x_ohmap_find_or_insert(x_ohmap *om, x_link *link)
+{
+	uint64_t h = mix_hash(om->hash(link));
+	size_t idx = locate(om, link, h, false);
+	if (idx != SIZE_MAX)
+		return om->slots[idx];
+	insert_new(om, link, h);
+	return NULL;
+}
+
+x_link *x_ohmap_replace_or_insert(x_ohmap *om, x_link *link)
+{
+	uint64_t h = mix_hash(om->hash(link));
+	size_t idx = locate(om, link, h, false);
+	if (idx != SIZE_MAX) {
+		x_link *old = om->slots[idx];
+		om->slots[idx] = link;
+		return old;
+	}
+	insert_new(om, link, h);
+	return NULL;
+}
+
+x_link *x_ohmap_find_and_remove(x_ohmap *om, const x_link *link)
+{
+	size_t idx = locate(om, link, mix_hash(om->hash(link)), false);
+	if (idx == SIZE_MAX)
+		return NULL;
+	x_link *result = om->slots[idx];
+	erase(om, idx);
+	return result;
+}
+
+void x_ohmap_remove(x_ohmap *om, x_link *link)
+{
+	size_t idx = locate(om, link, mix_hash(om->hash(link)), true);
+	assert(idx != SIZE_MAX);
+	erase(om, idx);
+}
+
+x_link *x_ohmap_next(const x_ohmap *om, size_t *iter)
+{
+	for (size_t i = *iter; i <= om->mask; i++) {
+		if (CTRL_IS_FULL(om->ctrl[i])) {
+			*iter = i + 1;
+			return om->slots[i];
+		}
+	}
+	*iter = om->mask + 1;
+	return NULL;
+}
+
+void x_ohmap_free(x_ohmap *om)
+{
+	x_free(om->slots);
+}
@@ -29,40 +29,83 @@
 #include "x/log.h"
 #include "x/reactor.h"
 #include "x/errno.h"
+#include "x/memory.h"
+#include "x/atomic.h"
+#include "x/thread.h"
 #ifdef X_OS_WIN32
 #include <windows.h>
 #else
 #include <unistd.h>
 #include <sys/socket.h>
 #endif
+#ifdef X_OS_LINUX
+#include <sys/eventfd.h>
+#endif
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 
+enum {
+	REACTOR_CMD_NONE,
+	REACTOR_CMD_ADD,
+	REACTOR_CMD_MODIFY,
+};
+
 static void ioevent_reset(x_reactor *r);
 static void ioevent_set(x_reactor *r);
+static int reactor_add_locked(x_reactor *r, x_event *e);
+static int reactor_modify_locked(x_reactor *r, x_event *e);
+static int reactor_apply_commands(x_reactor *r);
+
+static uint64_t timer_key(const struct timeval *tv)
+{
+	return (uint64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
 
 static void reset_all_timer(x_reactor *r, struct timeval *now)
 {
-	for (int i = 0; i < r->timer_heap.entry_cnt; i++) {
-		x_evtimer *e = x_container_of(r->timer_heap.table[i], x_evtimer, node);
+	/* All keys become equal, so the heap order still holds */
+	uint64_t key = timer_key(now);
+	for (size_t i = 0; i < r->timer_heap.entry_cnt; i++) {
+		x_evtimer *e = x_container_of(r->timer_heap.table[i].node, x_evtimer, node);
 		e->expiration = *now;
+		r->timer_heap.table[i].key = key;
 	}
 }
 
-static int reactor_pend_timer(x_reactor *r, const struct timeval *tv)
+/* The handler of the last popped event has returned */
+static void stats_end_dispatch(x_reactor_stats *stats)
+{
+	if (!stats->last_pop)
+		return;
+	x_hist_add(&stats->dispatch_ns, x_time_nsec() - stats->last_pop);
+	stats->last_pop = 0;
+}
+
+static size_t pending_depth(const x_reactor *r)
+{
+	size_t depth = 0;
+	x_list_foreach(pos, &r->pending_list)
+		depth++;
+	return depth;
+}
+
+static int reactor_pend_heap(x_reactor *r)
 {
 	int npendings = 0;
 	struct timeval now;
 	if (x_time_now(&now))
 		return 0;
-	int ntimers = r->timer_heap.entry_cnt;
-	for (int i = 0; i < ntimers; i++) {
-		x_evtimer *top = x_container_of(x_heap_top(&r->timer_heap), x_evtimer, node);
-		if (x_time_lt(now, top->expiration))
+	uint64_t now_key = timer_key(&now), top_key;
+	size_t ntimers = r->timer_heap.entry_cnt;
+	for (size_t i = 0; i < ntimers; i++) {
+		x_evtimer *top = x_container_of(x_dheap_top(&r->timer_heap, &top_key), x_evtimer, node);
+		if (now_key < top_key)
 			break;
-		x_heap_pop(&r->timer_heap);
+		if (r->stats)
+			x_hist_add(&r->stats->timer_late_us, now_key - top_key);
+		x_dheap_pop(&r->timer_heap, NULL);
 		if (!top->base.pending_link.next)
 			x_list_add_back(&r->pending_list, &top->base.pending_link);
 		if (!(top->base.ev_flags & X_EV_ONCE)) {
@@ -75,7 +118,7 @@ static int reactor_pend_timer(x_reactor *r, const struct timeval *tv)
 				top->expiration = now;
 				x_time_forward(top->expiration, top->interval);
 			}
-			x_heap_push(&r->timer_heap, &top->node);
+			x_dheap_push(&r->timer_heap, &top->node, timer_key(&top->expiration));
 		}
 		else
 			top->base.ev_flags &= ~X_EV_REACTING;
@@ -84,16 +127,100 @@ static int reactor_pend_timer(x_reactor *r, const struct timeval *tv)
 	return npendings;
 }
 
+static int reactor_pend_wheel(x_reactor *r)
+{
+	x_list expired;
+	x_list_init(&expired);
+	uint64_t now = x_time_tick();
+	int npendings = x_twheel_advance(&r->timer_wheel, now, &expired);
+	x_link *link;
+	while ((link = x_list_first(&expired))) {
+		x_list_del(link);
+		x_evtimer *e = x_container_of(link, x_evtimer, wheel_node.link);
+		if (r->stats && now > e->wheel_node.expire)
+			x_hist_add(&r->stats->timer_late_us, (now - e->wheel_node.expire) * 1000);
+		if (!e->base.pending_link.next)
+			x_list_add_back(&r->pending_list, &e->base.pending_link);
+		if (!(e->base.ev_flags & X_EV_ONCE)) {
+			uint64_t expire = e->wheel_node.expire;
+			if ((e->base.ev_flags & X_EV_ACCURATE) && e->interval)
+				expire += ((now - expire) / e->interval + 1) * e->interval;
+			else
+				expire = now + e->interval;
+			x_twheel_add(&r->timer_wheel, &e->wheel_node, expire);
+		}
+		else
+			e->base.ev_flags &= ~X_EV_REACTING;
+	}
+	return npendings;
+}
+
+static int reactor_pend_timer(x_reactor *r)
+{
+	if (r->timer_store == X_REACTOR_TIMER_WHEEL)
+		return reactor_pend_wheel(r);
+	return reactor_pend_heap(r);
+}
+
+/* Time until the earliest timer is due, false if there is no timer */
+static bool reactor_timer_timeout(x_reactor *r, struct timeval *tv)
+{
+	if (r->timer_store == X_REACTOR_TIMER_WHEEL) {
+		uint64_t next = x_twheel_next(&r->timer_wheel);
+		if (next == UINT64_MAX)
+			return false;
+		uint64_t now = x_time_tick(), wait = next > now ? next - now : 0;
+		x_time_set_msec(*tv, wait);
+		return true;
+	}
+	x_ranode *timer_node = x_dheap_top(&r->timer_heap, NULL);
+	if (!timer_node)
+		return false;
+	struct timeval now;
+	x_time_now(&now);
+	x_evtimer *evt = x_container_of(timer_node, x_evtimer, node);
+	if (x_time_lt(evt->expiration, now))
+		x_time_set_msec(*tv, 0);
+	else
+		x_time_diff(evt->expiration, now, tv);
+	/* The wall clock went backwards, fire everything rather than stall */
+	if (x_time_to_msec(*tv) > evt->interval + 5000) {
+		reset_all_timer(r, &now);
+		x_time_set_msec(*tv, 0);
+	}
+	return true;
+}
+
+/*
+ * Sockets removed by another thread while the mux was polling may still be
+ * in its ready set, their pointers are remembered until the results are
+ * consumed so they are never dereferenced.
+ */
+static void reactor_add_stale(x_reactor *r, x_evsocket *e)
+{
+	if (r->stale_cnt == r->stale_cap) {
+		r->stale_cap = r->stale_cap ? r->stale_cap * 2 : 8;
+		r->stale = x_realloc(r->stale, r->stale_cap * sizeof *r->stale);
+	}
+	r->stale[r->stale_cnt++] = e;
+}
+
+static bool reactor_is_stale(const x_reactor *r, const x_evsocket *e)
+{
+	for (size_t i = 0; i < r->stale_cnt; i++)
+		if (r->stale[i] == e)
+			return true;
+	return false;
+}
+
 static int reactor_pend_socket(x_reactor *r)
 {
-	x_sock fd;
+	x_evsocket *e;
 	short flags;
 	int npendings = 0;
-	while ((fd = r->mux_ops->m_next(r->mux, &flags)) != X_BADSOCK) {
-		x_evsocket pattern = { .sock = fd };
-		x_link *link = x_hmap_find(&r->sock_ht, &pattern.hash_link);
-		assert(link);
-		x_evsocket *e = x_container_of(link, x_evsocket, hash_link);
+	while ((e = r->mux_ops->m_next(r->mux, &flags))) {
+		if (r->stale_cnt && reactor_is_stale(r, e))
+			continue;
 		e->base.res_flags = flags;
 		if (e == &r->io_event) {
 			ioevent_reset(r);
@@ -106,18 +233,47 @@ static int reactor_pend_socket(x_reactor *r)
 	return npendings;
 }
 
-static int reactor_pend_object(x_reactor *r)
+/* Move the objects raised since the last call to obj_ready, in raise order */
+static void reactor_take_objects(x_reactor *r)
 {
-	int npendings = 0;
-	x_list_foreach(cur, &r->obj_list) {
+	if (!x_atomic_load(&r->obj_stack, X_ATOMIC_RELAXED))
+		return;
+	x_evobject *e = x_atomic_exchange(&r->obj_stack, NULL, X_ATOMIC_ACQUIRE), *fifo = NULL;
+	while (e) {
+		x_evobject *next = e->ready_next;
+		e->ready_next = fifo;
+		fifo = e;
+		e = next;
+	}
+	for (; fifo; fifo = fifo->ready_next)
+		x_list_add_back(&r->obj_ready, &fifo->link);
+}
+
+/*
+ * Counts the ready objects, and pends them if pend is true. An object whose
+ * res_flags were cleared leaves obj_ready, unless it is raised again at the
+ * same time, whoever sets queued back to 1 first owns it then.
+ */
+static int reactor_pend_object(x_reactor *r, bool pend)
+{
+	int nreadys = 0;
+	reactor_take_objects(r);
+	for (x_link *cur = r->obj_ready.head.next, *next; cur != &r->obj_ready.head; cur = next) {
+		next = cur->next;
 		x_evobject *e = x_container_of(cur, x_evobject, link);
-		if (!e->base.res_flags)
-			continue;
-		if (!e->base.pending_link.next)
+		if (!x_atomic_load(&e->base.res_flags, X_ATOMIC_ACQUIRE)) {
+			x_atomic_store(&e->queued, 0, X_ATOMIC_SEQ_CST);
+			if (!x_atomic_load(&e->base.res_flags, X_ATOMIC_SEQ_CST)
+					|| x_atomic_exchange(&e->queued, 1, X_ATOMIC_SEQ_CST)) {
+				x_list_del(&e->link);
+				continue;
+			}
+		}
+		if (pend && !e->base.pending_link.next)
 			x_list_add_back(&r->pending_list, &e->base.pending_link);
-		npendings += 1;
+		nreadys++;
 	}
-	return npendings;
+	return nreadys;
 }
 
 void x_reactor_break(x_reactor *r)
@@ -131,7 +287,7 @@ void x_reactor_break(x_reactor *r)
 static size_t evsocket_hash(const x_link *node)
 {
 	x_evsocket *e = x_container_of(node, x_evsocket, hash_link);
-	return x_memhash(&e->sock, sizeof e->sock);
+	return x_hmap_memhash(&e->sock, sizeof e->sock);
 }
 static bool evsocket_equal(const x_link *node1, const x_link *node2)
 {
@@ -140,151 +296,344 @@ static bool evsocket_equal(const x_link *node1, const x_link *node2)
 	return e1->sock == e2->sock;
 }
 
-static bool timer_ordered(const x_ranode *p1, const x_ranode *p2)
+int x_reactor_init(x_reactor *r)
 {
-	const x_evtimer *e1 = x_container_of(p1, x_evtimer, node);
-	const x_evtimer *e2 = x_container_of(p2, x_evtimer, node);
-	return x_time_le(e1->expiration, e2->expiration);
+	return x_reactor_init_mux(r, NULL);
 }
 
-int x_reactor_init(x_reactor *r)
+/*
+ * mux_ops NULL means epoll. Any other backend that cannot be created here,
+ * e.g. io_uring on an old or restricted kernel, falls back to epoll.
+ */
+int x_reactor_init_mux(x_reactor *r, const struct x_sockmux_ops_st *mux_ops)
 {
 	x_sock pair[2] = { -1, -1 };
 	memset(r, 0, sizeof(x_reactor));
+	r->io_pipe1 = -1;
 
-	r->mux_ops = &x_sockmux_epoll;
+	r->mux_ops = mux_ops ? mux_ops : &x_sockmux_epoll;
 	r->mux = r->mux_ops->m_create();
+	if (!r->mux && r->mux_ops != &x_sockmux_epoll) {
+		r->mux_ops = &x_sockmux_epoll;
+		r->mux = r->mux_ops->m_create();
+	}
 	if (!r->mux)
 		goto fail;
-	if (x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair) == -1)
-		goto fail;
+#ifdef X_OS_LINUX
+	/* One eventfd is both ends of the wakeup channel */
+	pair[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+	if (pair[0] == -1) {
+		if (x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair) == -1)
+			goto fail;
+		/* A full pipe already means a pending wakeup, never block on it */
+		if (x_sock_set_nonblocking(pair[0]) || x_sock_set_nonblocking(pair[1]))
+			goto fail;
+	}
 	x_mutex_init(&r->lock);
 	x_hmap_init(&r->sock_ht, 0.5, evsocket_hash, evsocket_equal);
 	x_list_init(&r->pending_list);
 	x_list_init(&r->obj_list);
-	x_heap_init(&r->timer_heap, timer_ordered);
+	x_list_init(&r->obj_ready);
+	x_mpsc_init(&r->cmd_queue);
+	x_dheap_init(&r->timer_heap);
+	r->timer_store = X_REACTOR_TIMER_HEAP;
 	x_evsocket_init(&r->io_event, pair[0], X_EV_READ, NULL);
 	x_reactor_add(r, &r->io_event.base);
 	r->breaking = false;
 	r->io_pipe1 = pair[1];
 	return 0;
 fail:
-	if (pair[0] != -1) {
+	if (pair[0] != -1)
 		x_sock_close(pair[0]);
+	if (pair[1] != -1)
 		x_sock_close(pair[1]);
-	}
 	if (r->mux)
 		r->mux_ops->m_free(r->mux);
 	return -1;
 }
 
+static void reactor_drop_event(x_event *e)
+{
+	if (e->pending_link.next)
+		x_list_del(&e->pending_link);
+	e->reactor = NULL;
+	e->ev_flags &= ~X_EV_REACTING;
+}
+
+/* Drop every event, each of them can be added again afterwards */
 static void reactor_clean_events(x_reactor *r)
 {
-	x_evsocket *e;
-	for (int i = 0; i < r->sock_ht.slot_cnt; i++) {
-		x_list_popeach(cur, &r->sock_ht.table[i]) {
-			e = x_container_of(cur, x_evsocket, hash_link);
+	x_link *cur;
+	/* Finish any pending migration, bucket heads are set up lazily */
+	x_hmap_set_incremental(&r->sock_ht, false);
+	for (size_t i = 0; i < r->sock_ht.slot_cnt; i++) {
+		if (!r->sock_ht.table[i].head.next)
+			continue;
+		while ((cur = x_list_first(&r->sock_ht.table[i]))) {
+			x_evsocket *e = x_container_of(cur, x_evsocket, hash_link);
+			x_list_del(cur);
 			r->mux_ops->m_del(r->mux, e->sock, e->base.ev_flags);
+			if (r->polling)
+				reactor_add_stale(r, e);
+			reactor_drop_event(&e->base);
+		}
+	}
+	x_hmap_free(&r->sock_ht);
+	x_hmap_init(&r->sock_ht, 0.5, evsocket_hash, evsocket_equal);
+
+	x_ranode *node;
+	while ((node = x_dheap_pop(&r->timer_heap, NULL)))
+		reactor_drop_event(&x_container_of(node, x_evtimer, node)->base);
+	x_dheap_free(&r->timer_heap);
+	if (r->timer_store == X_REACTOR_TIMER_WHEEL) {
+		for (size_t i = 0; i < X_TWHEEL_LEVELS * X_TWHEEL_SLOTS; i++) {
+			while ((cur = x_list_first(&r->timer_wheel.slots[i]))) {
+				x_list_del(cur);
+				reactor_drop_event(&x_container_of(cur, x_evtimer, wheel_node.link)->base);
+			}
 		}
+		x_twheel_free(&r->timer_wheel);
+		x_twheel_init(&r->timer_wheel, x_time_tick());
 	}
-	x_heap_free(&r->timer_heap);
-	x_list_popeach(cur, &r->obj_list);
+
+	reactor_take_objects(r);
+	while ((cur = x_list_first(&r->obj_list))) {
+		x_evobject *obj = x_container_of(cur, x_evobject, base.event_link);
+		x_list_del(cur);
+		if (obj->link.next)
+			x_list_del(&obj->link);
+		obj->queued = 0;
+		reactor_drop_event(&obj->base);
+	}
+
+	/* Failed foreign adds and x_reactor_pend leftovers */
+	while ((cur = x_list_first(&r->pending_list)))
+		x_list_del(cur);
 }
 
 void x_reactor_clear(x_reactor *r)
 {
 	x_mutex_lock(&r->lock);
+	reactor_apply_commands(r);
 	reactor_clean_events(r);
-	x_reactor_add(r, &r->io_event.base);
+	reactor_add_locked(r, &r->io_event.base);
 	x_mutex_unlock(&r->lock);
 }
 
 void x_reactor_free(x_reactor *r)
 {
+	reactor_apply_commands(r);
 	reactor_clean_events(r);
 	r->mux_ops->m_free(r->mux);
 	x_sock_close(r->io_event.sock);
-	x_sock_close(r->io_pipe1);
+	if (r->io_pipe1 != -1)
+		x_sock_close(r->io_pipe1);
 	x_mutex_destroy(&r->lock);
 	x_hmap_free(&r->sock_ht);
+	if (r->timer_store == X_REACTOR_TIMER_WHEEL)
+		x_twheel_free(&r->timer_wheel);
+	x_free(r->stale);
+	x_free(r->stats);
 }
 
-int x_reactor_add(x_reactor *r, x_event *e)
+/*
+ * Busy polling trades a core for latency: a wait first polls without
+ * blocking for up to usec, so an event arriving meanwhile is picked up
+ * without the sleep and wakeup of a blocking poll. Call from the loop
+ * thread, or while no thread is in x_reactor_wait.
+ */
+void x_reactor_set_busy_poll(x_reactor *r, uint32_t usec)
+{
+	assert(r != NULL);
+	r->busy_poll_usec = usec;
+}
+
+int x_reactor_set_timer_store(x_reactor *r, int store)
 {
 	int retval = -1;
-	assert(r != NULL && e != NULL);
-	if (e->ev_flags & X_EV_REACTING) {
-		errno = X_EALREADY;
+	assert(r != NULL);
+	if (store != X_REACTOR_TIMER_HEAP && store != X_REACTOR_TIMER_WHEEL) {
+		errno = X_EINVAL;
 		return -1;
 	}
+	x_mutex_lock(&r->lock);
+	if (x_dheap_size(&r->timer_heap) || (r->timer_store == X_REACTOR_TIMER_WHEEL
+				&& x_twheel_size(&r->timer_wheel))) {
+		errno = X_EBUSY;
+		goto out;
+	}
+	if (store != r->timer_store) {
+		if (store == X_REACTOR_TIMER_WHEEL)
+			x_twheel_init(&r->timer_wheel, x_time_tick());
+		else
+			x_twheel_free(&r->timer_wheel);
+		r->timer_store = store;
+	}
+	retval = 0;
+out:
+	x_mutex_unlock(&r->lock);
+	return retval;
+}
+
+/*
+ * The thread running x_reactor_wait owns the reactor. Other threads do not
+ * add or modify events directly, which would contend with the loop for
+ * r->lock, they post the event to cmd_queue instead and the loop applies
+ * it. Each event is queued at most once, a modification posted while the
+ * event is still queued is covered by the pending command, which reads the
+ * flags only when it is applied. The loop thread itself, and any thread
+ * before the first wait, changes events without r->lock and without a
+ * wakeup, as nothing polls meanwhile. A foreign x_reactor_remove takes
+ * r->lock, so it only excludes the loop while that is in x_reactor_wait.
+ */
+static bool reactor_is_foreign(x_reactor *r)
+{
+	uint32_t owner = x_atomic_load(&r->owner, X_ATOMIC_RELAXED);
+	return owner && owner != x_thread_native_id();
+}
+
+static void reactor_post(x_reactor *r, x_event *e, int cmd)
+{
+	int expected = REACTOR_CMD_NONE;
+	if (x_atomic_cas(&e->cmd, &expected, cmd, X_ATOMIC_ACQ_REL, X_ATOMIC_ACQUIRE))
+		x_mpsc_push(&r->cmd_queue, &e->cmd_node);
+	ioevent_set(r);
+}
+
+/*
+ * Called by the loop thread or with r->lock held, either makes the caller
+ * the only consumer.
+ * Returns the number of failed adds, which are pended with X_EV_ERROR.
+ */
+static int reactor_apply_commands(x_reactor *r)
+{
+	x_mpsc_node *node;
+	int nerrors = 0;
+	if (x_mpsc_is_empty(&r->cmd_queue))
+		return 0;
+	while ((node = x_mpsc_pop(&r->cmd_queue))) {
+		x_event *e = x_container_of(node, x_event, cmd_node);
+		int cmd = x_atomic_exchange(&e->cmd, REACTOR_CMD_NONE, X_ATOMIC_ACQ_REL);
+		if (cmd == REACTOR_CMD_ADD) {
+			e->ev_flags &= ~X_EV_REACTING;
+			if (reactor_add_locked(r, e) == 0)
+				continue;
+			/* Nobody is left to return the error to, report it as an event */
+			e->reactor = NULL;
+			e->res_flags = X_EV_ERROR;
+			if (!e->pending_link.next)
+				x_list_add_back(&r->pending_list, &e->pending_link);
+			nerrors++;
+		}
+		else if (cmd == REACTOR_CMD_MODIFY && (e->ev_flags & X_EV_REACTING))
+			(void)reactor_modify_locked(r, e);
+	}
+	return nerrors;
+}
+
+static int reactor_add_locked(x_reactor *r, x_event *e)
+{
 	x_evsocket *esock = x_container_of(e, x_evsocket, base);
 	x_evobject *eobj = x_container_of(e, x_evobject, base);
 	x_evtimer *etimer = x_container_of(e, x_evtimer, base);
-	x_mutex_lock(&r->lock);
 	switch (e->type) {
 		case X_EVENT_TIMER:
-			 x_time_now(&etimer->expiration);
-			 x_time_forward(etimer->expiration, etimer->interval);
-			x_heap_push(&r->timer_heap, &etimer->node);
+			if (r->timer_store == X_REACTOR_TIMER_WHEEL) {
+				x_twheel_add(&r->timer_wheel, &etimer->wheel_node, x_time_tick() + etimer->interval);
+				break;
+			}
+			x_time_now(&etimer->expiration);
+			x_time_forward(etimer->expiration, etimer->interval);
+			x_dheap_push(&r->timer_heap, &etimer->node, timer_key(&etimer->expiration));
 			break;
 		case X_EVENT_SOCKET:
 			if (x_hmap_find_or_insert(&r->sock_ht, &esock->hash_link)) {
 				errno = X_EEXIST;
-				goto out;
+				return -1;
 			}
-			if (r->mux_ops->m_add(r->mux, esock->sock, e->ev_flags) == -1) {
+			if (r->mux_ops->m_add(r->mux, esock->sock, e->ev_flags, esock) == -1) {
 				x_hmap_remove(&r->sock_ht, &esock->hash_link);
-				goto out;
+				return -1;
 			}
 			break;
 		case X_EVENT_OBJECT:
-			x_list_add_back(&r->obj_list, &eobj->link);
+			/* Added already raised */
+			if (x_atomic_load(&e->res_flags, X_ATOMIC_ACQUIRE)
+					&& !x_atomic_exchange(&eobj->queued, 1, X_ATOMIC_SEQ_CST))
+				x_list_add_back(&r->obj_ready, &eobj->link);
+			x_list_add_back(&r->obj_list, &e->event_link);
 			break;
 		default:
 			errno = X_EINVAL;
-			goto out;
+			return -1;
 	}
 	e->reactor = r;
 	e->ev_flags |= X_EV_REACTING;
-	ioevent_set(r);
-	retval = 0;
-out:
-	x_mutex_unlock(&r->lock);
-	return retval;
+	return 0;
 }
 
-int x_reactor_modify(x_event *e)
+int x_reactor_add(x_reactor *r, x_event *e)
 {
-	int retval = -1;
-	assert(e != NULL);
-	if (!(e->ev_flags & X_EV_REACTING)) {
-		errno = X_EINVAL;
+	assert(r != NULL && e != NULL);
+	if (e->ev_flags & X_EV_REACTING) {
+		errno = X_EALREADY;
 		return -1;
 	}
-	x_reactor *r = e->reactor;
+	if (reactor_is_foreign(r)) {
+		if (e->type != X_EVENT_TIMER && e->type != X_EVENT_SOCKET && e->type != X_EVENT_OBJECT) {
+			errno = X_EINVAL;
+			return -1;
+		}
+		e->reactor = r;
+		e->ev_flags |= X_EV_REACTING;
+		reactor_post(r, e, REACTOR_CMD_ADD);
+		return 0;
+	}
+	reactor_apply_commands(r);
+	return reactor_add_locked(r, e);
+}
+
+static int reactor_modify_locked(x_reactor *r, x_event *e)
+{
 	x_evsocket *esock = x_container_of(e, x_evsocket, base);
 	x_evtimer *etimer = x_container_of(e, x_evtimer, base);
-	x_mutex_lock(&r->lock);
 	switch (e->type) {
 		case X_EVENT_TIMER:
-			x_heap_remove(&r->timer_heap, &etimer->node);
-			x_heap_push(&r->timer_heap, &etimer->node);
+			if (r->timer_store == X_REACTOR_TIMER_WHEEL) {
+				x_twheel_remove(&r->timer_wheel, &etimer->wheel_node);
+				x_twheel_add(&r->timer_wheel, &etimer->wheel_node, etimer->wheel_node.expire);
+				break;
+			}
+			x_dheap_update(&r->timer_heap, &etimer->node, timer_key(&etimer->expiration));
 			break;
 		case X_EVENT_SOCKET:
-			if (r->mux_ops->m_mod(r->mux, esock->sock, e->ev_flags) == -1)
-				goto out;
+			if (r->mux_ops->m_mod(r->mux, esock->sock, e->ev_flags, esock) == -1)
+				return -1;
 			break;
 		case X_EVENT_OBJECT:
 			break;
 		default:
 			errno = X_EINVAL;
-			goto out;
+			return -1;
 	}
-	ioevent_set(r);
-	retval = 0;
-out:
-	x_mutex_unlock(&r->lock);
-	return retval;
+	return 0;
+}
+
+int x_reactor_modify(x_event *e)
+{
+	assert(e != NULL);
+	if (!(e->ev_flags & X_EV_REACTING)) {
+		errno = X_EINVAL;
+		return -1;
+	}
+	x_reactor *r = e->reactor;
+	if (reactor_is_foreign(r)) {
+		reactor_post(r, e, REACTOR_CMD_MODIFY);
+		return 0;
+	}
+	reactor_apply_commands(r);
+	return reactor_modify_locked(r, e);
 }
 
 void x_reactor_pend(x_reactor *r, x_event *e, short res_flags)
@@ -302,48 +651,118 @@ void x_reactor_remove(x_reactor *r, x_event *e)
 	x_evsocket *esock = x_container_of(e, x_evsocket, base);
 	x_evobject *eobj = x_container_of(e, x_evobject, base);
 	x_evtimer *etimer = x_container_of(e, x_evtimer, base);
-	x_mutex_lock(&r->lock);
+	bool foreign = reactor_is_foreign(r);
+	if (foreign)
+		x_mutex_lock(&r->lock);
+	/* An add or modify of e may still be queued, never leave it behind */
+	reactor_apply_commands(r);
 	switch (e->type) {
 		case X_EVENT_TIMER:
-			x_heap_remove(&r->timer_heap, &etimer->node);
+			if (r->timer_store == X_REACTOR_TIMER_WHEEL)
+				x_twheel_remove(&r->timer_wheel, &etimer->wheel_node);
+			else
+				x_dheap_remove(&r->timer_heap, &etimer->node);
 			break;
 		case X_EVENT_SOCKET:
 			if (x_hmap_find_and_remove(&r->sock_ht, &esock->hash_link)) {
 				r->mux_ops->m_del(r->mux, esock->sock, e->ev_flags);
-				goto out;
+				if (r->polling)
+					reactor_add_stale(r, esock);
 			}
 			break;
 		case X_EVENT_OBJECT:
-			x_list_del(&eobj->link);
+			reactor_take_objects(r);
+			if (eobj->link.next)
+				x_list_del(&eobj->link);
+			if (e->event_link.next)
+				x_list_del(&e->event_link);
+			eobj->queued = 0;
 			break;
 		default:
 			errno = X_EINVAL;
 			goto out;
 	}
-	e->reactor = NULL;
-	e->ev_flags &= ~X_EV_REACTING;
-	ioevent_set(r);
+	reactor_drop_event(e);
+	if (foreign)
+		ioevent_set(r);
 out:
-	x_mutex_unlock(&r->lock);
+	if (foreign)
+		x_mutex_unlock(&r->lock);
 }
 
+/*
+ * io_signaled stays set from the first wakeup until the loop consumes it,
+ * any wakeup in between is already covered and costs no syscall. It is
+ * cleared only after draining: a signaller that still saw it set did its
+ * work before that, and the loop looks at the command queue and obj_stack
+ * again before it polls. Clearing first would let the drain eat a wakeup
+ * written in between and leave io_signaled set with nothing to read.
+ */
 static void ioevent_reset(x_reactor *r)
 {
+#ifdef X_OS_LINUX
+	if (r->io_pipe1 == -1) {
+		uint64_t count;
+		(void)!read(r->io_event.sock, &count, sizeof count);
+		goto out;
+	}
+#endif
 	char buf[1024];
 	while (recv(r->io_event.sock, buf, sizeof buf, 0) == sizeof buf);
+#ifdef X_OS_LINUX
+out:
+#endif
+	x_atomic_store(&r->io_signaled, 0, X_ATOMIC_SEQ_CST);
+	/* Order the clear before the loop reads the queues again */
+	x_atomic_fence(X_ATOMIC_SEQ_CST);
 }
 
 static void ioevent_set(x_reactor *r)
 {
+	if (x_atomic_exchange(&r->io_signaled, 1, X_ATOMIC_SEQ_CST))
+		return;
+#ifdef X_OS_LINUX
+	if (r->io_pipe1 == -1) {
+		uint64_t one = 1;
+		(void)!write(r->io_event.sock, &one, sizeof one);
+		return;
+	}
+#endif
 	char octet = 0;
 	send(r->io_pipe1, &octet, sizeof(octet), 0);
 }
 
+/* m_poll, spinning first when busy polling, the blocking part gets what is left */
+static int reactor_poll(x_reactor *r, struct timeval *tv)
+{
+	if (!r->busy_poll_usec || (tv && !tv->tv_sec && !tv->tv_usec))
+		return r->mux_ops->m_poll(r->mux, tv);
+	struct timeval zero = { 0, 0 };
+	uint64_t timeout = tv ? (uint64_t)tv->tv_sec * 1000000 + tv->tv_usec : UINT64_MAX;
+	uint64_t budget = x_min(timeout, (uint64_t)r->busy_poll_usec), spent;
+	uint64_t start = x_time_nsec();
+	do {
+		int nreadys = r->mux_ops->m_poll(r->mux, &zero);
+		if (nreadys)
+			return nreadys;
+		spent = (x_time_nsec() - start) / 1000;
+	} while (spent < budget);
+	if (tv) {
+		timeout = spent < timeout ? timeout - spent : 0;
+		tv->tv_sec = timeout / 1000000;
+		tv->tv_usec = timeout % 1000000;
+	}
+	return r->mux_ops->m_poll(r->mux, tv);
+}
+
 int x_reactor_wait(x_reactor *r)
 {
 	assert(r != NULL);
 	struct timeval tv, *ptv = NULL;
 	int npendings = -1;
+	x_atomic_store(&r->owner, x_thread_native_id(), X_ATOMIC_RELAXED);
+	if (r->stats)
+		stats_end_dispatch(r->stats);
 	x_mutex_lock(&r->lock);
 	if (r->breaking) {
 		r->breaking = false;
@@ -351,38 +770,50 @@ int x_reactor_wait(x_reactor *r)
 		return 0;
 	}
 	do {
-		struct timeval now;
-		x_time_now(&now);
-		x_ranode *timer_node = x_heap_top(&r->timer_heap);
-		if (timer_node) {
-			x_evtimer *evt = x_container_of(timer_node, x_evtimer, node);
-			if (x_time_lt(evt->expiration, now)) {
-				x_time_set_msec(tv, 0);
-			}
-			else
-				x_time_diff(evt->expiration, now, &tv);
-			
-			if (x_time_to_msec(tv) > evt->interval + 5000) {
-				reset_all_timer(r, &now);
-				x_time_set_msec(tv, 0);
-			}
+		if ((npendings = reactor_apply_commands(r)))
+			break;
+		bool has_timer = reactor_timer_timeout(r, &tv);
+		ptv = has_timer ? &tv : NULL;
+		/* Objects still raised are reported again without blocking */
+		if (reactor_pend_object(r, false)) {
+			x_time_set_msec(tv, 0);
 			ptv = &tv;
 		}
+		r->polling = true;
+		r->stale_cnt = 0;
 		x_mutex_unlock(&r->lock);
-		int nreadys = r->mux_ops->m_poll(r->mux, ptv);
+		uint64_t poll_start = r->stats ? x_time_nsec() : 0;
+		int nreadys = reactor_poll(r, ptv);
+		if (r->stats) {
+			r->stats->iterations++;
+			x_hist_add(&r->stats->poll_ns, x_time_nsec() - poll_start);
+		}
 		x_mutex_lock(&r->lock);
+		r->polling = false;
+		/*
+		 * Not only signals interrupt the poll, the kernel also does so to
+		 * run task work, e.g. after an io_uring of this thread is closed.
+		 * Poll again, x_reactor_break is the way to leave the loop.
+		 */
+		if (nreadys < 0 && errno == X_EINTR)
+			nreadys = 0;
 		if (nreadys < 0) {
 			npendings = -1;
 			goto out;
 		}
-		npendings = 0;
-		if (timer_node)
-			npendings += reactor_pend_timer(r, &now);
+		/* Commands posted while polling, e.g. an object added ready */
+		npendings = reactor_apply_commands(r);
+		if (has_timer)
+			npendings += reactor_pend_timer(r);
 		npendings += reactor_pend_socket(r);
-		npendings += reactor_pend_object(r);
+		npendings += reactor_pend_object(r, true);
+		if (r->stats)
+			x_hist_add(&r->stats->events, npendings);
 	} while (!r->breaking && !npendings);
 	if (!npendings)
 		r->breaking = false;
+	if (r->stats)
+		x_hist_add(&r->stats->pending_depth, pending_depth(r));
 out:
 	x_mutex_unlock(&r->lock);
 	return npendings;
@@ -395,13 +826,80 @@ void x_reactor_signal(x_reactor *r)
 	ioevent_set(r);
 }
 
+/*
+ * Sets res_flags of an object added to a reactor and wakes the loop. Only
+ * the first raise after the loop has let go of the object pushes it, so
+ * raising an object that is already ready costs two atomic operations.
+ */
+void x_reactor_raise(x_evobject *e, short res_flags)
+{
+	assert(e != NULL && e->base.reactor != NULL);
+	x_reactor *r = e->base.reactor;
+	x_atomic_fetch_or(&e->base.res_flags, res_flags, X_ATOMIC_SEQ_CST);
+	if (x_atomic_exchange(&e->queued, 1, X_ATOMIC_SEQ_CST))
+		return;
+	/* The loop takes the whole stack at once, so there is no ABA */
+	x_evobject *head = x_atomic_load(&r->obj_stack, X_ATOMIC_RELAXED);
+	do
+		e->ready_next = head;
+	while (!x_atomic_cas_weak(&r->obj_stack, &head, e, X_ATOMIC_RELEASE, X_ATOMIC_RELAXED));
+	ioevent_set(r);
+}
+
 x_event *x_reactor_pop_event(x_reactor *r)
 {
-	if (x_list_is_empty(&r->pending_list))
+	if (x_list_is_empty(&r->pending_list)) {
+		if (r->stats)
+			stats_end_dispatch(r->stats);
 		return NULL;
+	}
 	x_event *e = x_container_of(x_list_first(&r->pending_list), x_event, pending_link);
 	x_list_del(&e->pending_link);
+	if (r->stats) {
+		uint64_t now = x_time_nsec();
+		if (r->stats->last_pop)
+			x_hist_add(&r->stats->dispatch_ns, now - r->stats->last_pop);
+		r->stats->last_pop = now;
+	}
 	return e;
 }
 
+static void stats_reset(x_reactor_stats *stats)
+{
+	stats->iterations = 0;
+	x_hist_init(&stats->events);
+	x_hist_init(&stats->poll_ns);
+	x_hist_init(&stats->dispatch_ns);
+	x_hist_init(&stats->timer_late_us);
+	x_hist_init(&stats->pending_depth);
+	stats->last_pop = 0;
+}
+
+/* Call from the loop thread, or while no thread is in x_reactor_wait */
+void x_reactor_enable_stats(x_reactor *r, bool enable)
+{
+	assert(r != NULL);
+	if (enable && !r->stats) {
+		r->stats = x_malloc(NULL, sizeof *r->stats);
+		stats_reset(r->stats);
+	}
+	else if (!enable && r->stats) {
+		x_free(r->stats);
+		r->stats = NULL;
+	}
+}
+
+void x_reactor_reset_stats(x_reactor *r)
+{
+	assert(r != NULL);
+	if (r->stats)
+		stats_reset(r->stats);
+}
+
+const x_reactor_stats *x_reactor_get_stats(const x_reactor *r)
+{
+	assert(r != NULL);
+	return r->stats;
+}
+
 
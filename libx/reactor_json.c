@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/reactor.h"
+#include "x/json.h"
+
+static x_json *hist_json(const x_hist *h)
+{
+	x_json *obj = x_json_create_object();
+	x_json_object_add_number(obj, "count", (double)h->count);
+	x_json_object_add_number(obj, "sum", (double)h->sum);
+	x_json_object_add_number(obj, "min", h->count ? (double)h->min : 0);
+	x_json_object_add_number(obj, "max", (double)h->max);
+	x_json_object_add_number(obj, "mean", h->count ? (double)h->sum / h->count : 0);
+	x_json_object_add_number(obj, "p50", (double)x_hist_percentile(h, 50));
+	x_json_object_add_number(obj, "p90", (double)x_hist_percentile(h, 90));
+	x_json_object_add_number(obj, "p99", (double)x_hist_percentile(h, 99));
+	x_json_object_add_number(obj, "p999", (double)x_hist_percentile(h, 99.9));
+
+	/* Only the buckets that were hit, as [upper bound, count] pairs */
+	x_json *buckets = x_json_create_array();
+	for (unsigned i = 0; i < X_HIST_BUCKETS; i++) {
+		if (!h->buckets[i])
+			continue;
+		x_json *pair = x_json_create_array();
+		x_json_array_add(pair, x_json_create_number((double)x_hist_bucket_max(i)));
+		x_json_array_add(pair, x_json_create_number((double)h->buckets[i]));
+		x_json_array_add(buckets, pair);
+	}
+	x_json_object_add(obj, "buckets", buckets);
+	return obj;
+}
+
+x_json *x_reactor_stats_json(const x_reactor_stats *stats)
+{
+	if (!stats)
+		return NULL;
+	x_json *obj = x_json_create_object();
+	x_json_object_add_number(obj, "iterations", (double)stats->iterations);
+	x_json_object_add(obj, "events", hist_json(&stats->events));
+	x_json_object_add(obj, "poll_ns", hist_json(&stats->poll_ns));
+	x_json_object_add(obj, "dispatch_ns", hist_json(&stats->dispatch_ns));
+	x_json_object_add(obj, "timer_late_us", hist_json(&stats->timer_late_us));
+	x_json_object_add(obj, "pending_depth", hist_json(&stats->pending_depth));
+	return obj;
+}
@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "x/rgroup.h"
+#include "x/reactor.h"
+#include "x/socket.h"
+#include "x/atomic.h"
+#include "x/memory.h"
+#include "x/errno.h"
+#include "x/sys.h"
+#include <string.h>
+#include <assert.h>
+#ifdef X_OS_LINUX
+#include <sched.h>
+#endif
+
+#define ACCEPT_RING_SIZE 1024 /* must be a power of 2 */
+
+static void rgroup_doorbell(x_rgroup_loop *l)
+{
+	/* The loop clears it before it drains */
+	x_reactor_raise(&l->doorbell, 1);
+}
+
+void x_rgroup_send(x_rgroup_loop *to, x_rgroup_msg *msg)
+{
+	assert(to != NULL && msg != NULL && msg->fn != NULL);
+	x_mpsc_push(&to->inbox, &msg->node);
+	rgroup_doorbell(to);
+}
+
+static bool accepted_push(x_rgroup_loop *l, x_sock sock)
+{
+	unsigned tail = l->accepted_tail;
+	if (tail - x_atomic_load(&l->accepted_head, X_ATOMIC_ACQUIRE) == ACCEPT_RING_SIZE)
+		return false;
+	l->accepted[tail & (ACCEPT_RING_SIZE - 1)] = sock;
+	x_atomic_store(&l->accepted_tail, tail + 1, X_ATOMIC_RELEASE);
+	return true;
+}
+
+static bool accepted_pop(x_rgroup_loop *l, x_sock *sock)
+{
+	unsigned head = l->accepted_head;
+	if (head == x_atomic_load(&l->accepted_tail, X_ATOMIC_ACQUIRE))
+		return false;
+	*sock = l->accepted[head & (ACCEPT_RING_SIZE - 1)];
+	x_atomic_store(&l->accepted_head, head + 1, X_ATOMIC_RELEASE);
+	return true;
+}
+
+static void rgroup_drain(x_rgroup_loop *l)
+{
+	x_rgroup *g = l->group;
+	x_mpsc_node *node;
+	x_sock sock;
+	x_atomic_store(&l->doorbell.base.res_flags, 0, X_ATOMIC_SEQ_CST);
+	while (accepted_pop(l, &sock))
+		g->on_accept(l, sock);
+	/* A push still in progress rings the doorbell again when it is done */
+	while ((node = x_mpsc_pop(&l->inbox))) {
+		x_rgroup_msg *msg = x_container_of(node, x_rgroup_msg, node);
+		msg->fn(l, msg);
+	}
+}
+
+static void rgroup_accept(x_listener *ln, x_sock sock, void *arg)
+{
+	x_rgroup_loop *l = arg;
+	x_rgroup *g = l->group;
+	x_rgroup_loop *to = l;
+	(void)ln;
+	if (g->dispatch == X_RGROUP_ROUND_ROBIN)
+		to = &g->loops[g->next_loop++ % (unsigned)g->loop_cnt];
+	if (to != l && accepted_push(to, sock)) {
+		rgroup_doorbell(to);
+		return;
+	}
+	/* Our own turn, or the target is backed up */
+	g->on_accept(l, sock);
+}
+
+static void rgroup_pin(int index)
+{
+#ifdef X_OS_LINUX
+	cpu_set_t set;
+	int nprocs = x_sys_nprocs();
+	if (nprocs <= 0)
+		return;
+	CPU_ZERO(&set);
+	CPU_SET(index % nprocs, &set);
+	(void)sched_setaffinity(0, sizeof set, &set);
+#else
+	(void)index;
+#endif
+}
+
+static int rgroup_loop_thread(void)
+{
+	x_rgroup_loop *l = x_thread_data();
+	x_rgroup *g = l->group;
+	x_event *e;
+	if (g->flags & X_RGROUP_PIN)
+		rgroup_pin(l->index);
+	while (!x_atomic_load(&g->stopping, X_ATOMIC_ACQUIRE)) {
+		if (x_reactor_wait(&l->reactor) < 0)
+			return -1;
+		while ((e = x_reactor_pop_event(&l->reactor))) {
+			if (e == &l->doorbell.base)
+				rgroup_drain(l);
+			else if (e == &l->listener.ev.base)
+				x_listener_dispatch(e);
+			else if (g->on_event)
+				g->on_event(l, e);
+		}
+	}
+	return 0;
+}
+
+int x_rgroup_init(x_rgroup *g, int nloops, int flags, x_rgroup_event_fn *on_event, void *arg)
+{
+	assert(g != NULL);
+	memset(g, 0, sizeof *g);
+	if (nloops <= 0)
+		nloops = x_sys_nprocs();
+	if (nloops <= 0)
+		nloops = 1;
+	g->loops = x_malloc(NULL, nloops * sizeof *g->loops);
+	memset(g->loops, 0, nloops * sizeof *g->loops);
+	g->flags = flags;
+	g->on_event = on_event;
+	g->arg = arg;
+	for (int i = 0; i < nloops; i++) {
+		x_rgroup_loop *l = &g->loops[i];
+		if (x_reactor_init(&l->reactor))
+			goto fail;
+		g->loop_cnt++;
+		l->group = g;
+		l->index = i;
+		l->listener.ev.sock = X_BADSOCK;
+		x_mpsc_init(&l->inbox);
+		x_evobject_init(&l->doorbell, 0, l);
+		x_reactor_add(&l->reactor, &l->doorbell.base);
+	}
+	return 0;
+fail:
+	x_rgroup_free(g);
+	return -1;
+}
+
+static x_sock rgroup_listener(const struct sockaddr *addr, socklen_t addrlen, bool reuseport)
+{
+	int on = 1;
+	x_sock sock = socket(addr->sa_family, SOCK_STREAM, 0);
+	if (sock == X_BADSOCK)
+		return X_BADSOCK;
+	(void)setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (void *)&on, sizeof on);
+	if (reuseport) {
+#ifdef SO_REUSEPORT
+		if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (void *)&on, sizeof on))
+			goto fail;
+#else
+		errno = X_ENOTSUP;
+		goto fail;
+#endif
+	}
+	if (bind(sock, addr, addrlen) || listen(sock, SOMAXCONN) || x_sock_set_nonblocking(sock))
+		goto fail;
+	return sock;
+fail:
+	x_sock_close(sock);
+	return X_BADSOCK;
+}
+
+int x_rgroup_listen(x_rgroup *g, const struct sockaddr *addr, socklen_t addrlen,
+		int dispatch, x_rgroup_accept_fn *on_accept)
+{
+	struct sockaddr_storage bound;
+	socklen_t bound_len = sizeof bound;
+	assert(g != NULL && addr != NULL && on_accept != NULL);
+	if ((dispatch != X_RGROUP_ROUND_ROBIN && dispatch != X_RGROUP_REUSEPORT)
+			|| addrlen > sizeof bound) {
+		errno = X_EINVAL;
+		return -1;
+	}
+	if (g->running || g->on_accept) {
+		errno = X_EBUSY;
+		return -1;
+	}
+	int nlisteners = dispatch == X_RGROUP_REUSEPORT ? g->loop_cnt : 1;
+	for (int i = 0; i < nlisteners; i++) {
+		x_rgroup_loop *l = &g->loops[i];
+		/* The first bind picks the port if none was given, share it */
+		x_sock sock = rgroup_listener(i ? (struct sockaddr *)&bound : addr,
+				i ? bound_len : addrlen, dispatch == X_RGROUP_REUSEPORT);
+		if (sock == X_BADSOCK)
+			goto fail;
+		if (i == 0 && getsockname(sock, (struct sockaddr *)&bound, &bound_len)) {
+			x_sock_close(sock);
+			goto fail;
+		}
+		if (x_listener_init(&l->listener, &l->reactor, sock, 0, rgroup_accept, l)) {
+			x_sock_close(sock);
+			l->listener.ev.sock = X_BADSOCK;
+			goto fail;
+		}
+	}
+	for (int i = 0; dispatch == X_RGROUP_ROUND_ROBIN && i < g->loop_cnt; i++)
+		g->loops[i].accepted = x_malloc(NULL, ACCEPT_RING_SIZE * sizeof(x_sock));
+	g->dispatch = dispatch;
+	g->on_accept = on_accept;
+	return 0;
+fail:
+	for (int i = 0; i < nlisteners; i++) {
+		x_rgroup_loop *l = &g->loops[i];
+		if (l->listener.ev.sock == X_BADSOCK)
+			continue;
+		x_listener_free(&l->listener);
+		x_sock_close(l->listener.ev.sock);
+		l->listener.ev.sock = X_BADSOCK;
+	}
+	return -1;
+}
+
+int x_rgroup_start(x_rgroup *g)
+{
+	assert(g != NULL);
+	if (g->running) {
+		errno = X_EALREADY;
+		return -1;
+	}
+	g->stopping = false;
+	for (int i = 0; i < g->loop_cnt; i++) {
+		x_rgroup_loop *l = &g->loops[i];
+		l->thread = x_thread_create(rgroup_loop_thread, NULL, l);
+		if (!l->thread) {
+			g->running = true;
+			x_rgroup_stop(g);
+			return -1;
+		}
+	}
+	g->running = true;
+	return 0;
+}
+
+void x_rgroup_stop(x_rgroup *g)
+{
+	assert(g != NULL);
+	if (!g->running)
+		return;
+	x_atomic_store(&g->stopping, true, X_ATOMIC_RELEASE);
+	for (int i = 0; i < g->loop_cnt; i++)
+		if (g->loops[i].thread)
+			x_reactor_break(&g->loops[i].reactor);
+	for (int i = 0; i < g->loop_cnt; i++) {
+		x_rgroup_loop *l = &g->loops[i];
+		if (!l->thread)
+			continue;
+		x_thread_join(l->thread, NULL);
+		x_thread_free(l->thread);
+		l->thread = NULL;
+	}
+	g->running = false;
+}
+
+void x_rgroup_free(x_rgroup *g)
+{
+	x_sock sock;
+	if (!g->loops)
+		return;
+	x_rgroup_stop(g);
+	for (int i = 0; i < g->loop_cnt; i++) {
+		x_rgroup_loop *l = &g->loops[i];
+		if (l->listener.ev.sock != X_BADSOCK)
+			x_sock_close(l->listener.ev.sock);
+		/* Handed over but never seen by the loop */
+		while (l->accepted && accepted_pop(l, &sock))
+			x_sock_close(sock);
+		x_free(l->accepted);
+		x_reactor_free(&l->reactor);
+	}
+	x_free(g->loops);
+	g->loops = NULL;
+	g->loop_cnt = 0;
+}
@@ -20,6 +20,10 @@
  * THE SOFTWARE.
  */
 
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
 #include "x/socket.h"
 #include "x/log.h"
 #include "x/string.h"
@@ -45,6 +49,7 @@
 #endif
 
 #include <errno.h>
+#include <limits.h>
 #include <string.h>
 #include <assert.h>
 #include <stdbool.h>
@@ -456,6 +461,46 @@ int x_sock_wait_readable(const x_sock *sock, size_t cnt, size_t millise)
 	return wait_socket(sock, cnt, true, millise);
 }
 
+/* The new socket is non-blocking and close-on-exec, atomically with accept4 */
+x_sock x_sock_accept(x_sock sock, struct sockaddr *addr, socklen_t *addrlen)
+{
+#if defined(X_OS_LINUX) || (defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC))
+	return accept4(sock, addr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+	x_sock fd = accept(sock, addr, addrlen);
+	if (fd == X_BADSOCK)
+		return X_BADSOCK;
+#ifndef X_OS_WIN32
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+	if (x_sock_set_nonblocking(fd)) {
+		x_sock_close(fd);
+		/* Lost either way, callers move on to the next one */
+		x_sock_set_errno(X_SOCK_ERR(ECONNABORTED));
+		return X_BADSOCK;
+	}
+	return fd;
+#endif
+}
+
+/*
+ * Lets the kernel busy poll the device queue of the socket for up to usec
+ * in a read that would block. epoll only does so with the net.core.busy_poll
+ * sysctl set, and only for sockets of NAPI capable devices.
+ */
+int x_sock_set_busy_poll(x_sock sock, uint32_t usec)
+{
+#ifdef SO_BUSY_POLL
+	int val = usec > INT_MAX ? INT_MAX : (int)usec;
+	return setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, (void *)&val, sizeof val);
+#else
+	(void)sock;
+	(void)usec;
+	errno = X_ENOTSUP;
+	return -1;
+#endif
+}
+
 int x_sock_set_keepalive(x_sock sock, uint32_t idle_sec, uint32_t interval_sec)
 {
 	int old_keep_alive;
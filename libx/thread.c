@@ -131,13 +131,15 @@ static DWORD WINAPI __x_thread_proc(void *arg)
 {
 	struct thread_info *info = arg;
 	x_thread *thread = info->thread;
+	x_thread_fn *func = info->func;
+	/* info is released by the creator once it is signaled */
 	if (init_thread_info(info))
 		return 0;
-	DWORD dwRetCode = setjmp(info->thread->jmp_exit);
+	DWORD dwRetCode = setjmp(thread->jmp_exit);
 	BOOL bIsJump = FALSE;
 	if (!bIsJump && dwRetCode == 0) {
 		bIsJump = TRUE;
-		dwRetCode = info->func();
+		dwRetCode = func();
 	}
 	void __x_tss_free_all_win32(void);
 	__x_tss_free_all_win32();
@@ -154,6 +156,8 @@ static void * __x_thread_proc(void *arg)
 {
 	struct thread_info *info = arg;
 	x_thread *thread = info->thread;
+	x_thread_fn *func = info->func;
+	/* info is released by the creator once it is signaled */
 	if (init_thread_info(info))
 		return NULL;
 	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
@@ -161,10 +165,10 @@ static void * __x_thread_proc(void *arg)
 	bool is_jmp = false;
 	int retval;
 	pthread_cleanup_push(thread_exit_unexpected, thread);
-	retval = setjmp(info->thread->jmp_exit);;
+	retval = setjmp(thread->jmp_exit);;
 	if (!is_jmp && retval == 0) {
 		is_jmp = true;
-		retval = info->func();
+		retval = func();
 	}
 	pthread_cleanup_pop(0);
 	free_thread(thread);
@@ -54,6 +54,24 @@ uint64_t x_time_tick(void)
 #endif
 }
 
+/* Monotonic nanoseconds, for measuring short intervals */
+uint64_t x_time_nsec(void)
+{
+#ifdef X_OS_WIN
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER count;
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (uint64_t)(count.QuadPart / freq.QuadPart) * 1000000000ULL
+		+ (uint64_t)(count.QuadPart % freq.QuadPart) * 1000000000ULL / freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
 int x_time_from_iso8601(const char *datetime, struct timeval *tv)
 {
     struct tm tm = {0};
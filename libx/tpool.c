@@ -24,16 +24,68 @@
 #include "x/thread.h"
 #include "x/mutex.h"
 #include "x/cond.h"
+#include "x/memory.h"
+#include "x/once.h"
+#include "x/tss.h"
+#include "x/atomic.h"
+#include "x/errno.h"
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
+#define DEQUE_INIT_SIZE 256 /* must be a power of 2 */
+#define GLOBAL_BATCH_MAX 64
+
+struct deque_buf
+{
+	int64_t mask;
+	struct deque_buf *prev; /* stealers may still read it, freed with the pool */
+	x_tpool_work *slots[];
+};
+
+struct x_tpool_worker_st
+{
+	/* top is advanced by stealers, bottom only moves in the owner */
+	int64_t top;
+	char top_pad[64 - sizeof(int64_t)];
+	int64_t bottom;
+	struct deque_buf *buf;
+	x_tpool *pool;
+	uint32_t seed;
+	char pad[64];
+};
+
+static x_once s_work_pool_once = X_ONCE_INIT;
+static x_mpool s_work_pool;
+static int s_work_pool_errno;
+
+/* The worker the calling thread runs, if any */
+static x_once s_worker_key_once = X_ONCE_INIT;
+static x_tss s_worker_key;
+static int s_worker_key_errno;
+
+static void init_work_pool(void)
+{
+	if (x_mpool_init(&s_work_pool, sizeof(x_tpool_work)))
+		s_work_pool_errno = errno ? errno : ENOMEM;
+}
+
+static void init_worker_key(void)
+{
+	if (x_tss_init(&s_worker_key, NULL))
+		s_worker_key_errno = errno ? errno : ENOMEM;
+}
+
 x_tpool_work *x_tpool_work_create(x_tpool_worker_f *func, void *arg)
 {
 	assert(func);
 	x_tpool_work *work;
-	work = malloc(sizeof *work);
-	if (!work)
+	x_once_init(&s_work_pool_once, init_work_pool);
+	if (s_work_pool_errno) {
+		errno = s_work_pool_errno;
 		return NULL;
+	}
+	work = x_mpool_get(&s_work_pool);
 	work->func = func;
 	work->arg  = arg;
 	work->next = NULL;
@@ -44,7 +96,7 @@ void x_tpool_work_free(x_tpool_work *work)
 {
 	if (!work)
 		return;
-	free(work);
+	x_mpool_put(&s_work_pool, work);
 }
 
 static x_tpool_work *x_tpool_work_get(x_tpool *tp)
@@ -90,32 +142,273 @@ static int tpool_worker(void)
 	return 0;
 }
 
+static struct deque_buf *deque_buf_new(int64_t size, struct deque_buf *prev)
+{
+	struct deque_buf *a = x_malloc(NULL, sizeof *a + size * sizeof a->slots[0]);
+	a->mask = size - 1;
+	a->prev = prev;
+	return a;
+}
+
+/* Owner only, doubles the buffer, the old one stays readable for stealers */
+static struct deque_buf *deque_grow(struct x_tpool_worker_st *w, struct deque_buf *a, int64_t t, int64_t b)
+{
+	struct deque_buf *n = deque_buf_new((a->mask + 1) * 2, a);
+	for (int64_t i = t; i < b; i++)
+		n->slots[i & n->mask] = x_atomic_load(&a->slots[i & a->mask], X_ATOMIC_RELAXED);
+	x_atomic_store(&w->buf, n, X_ATOMIC_RELEASE);
+	return n;
+}
+
+static void deque_push(struct x_tpool_worker_st *w, x_tpool_work *work)
+{
+	int64_t b = x_atomic_load(&w->bottom, X_ATOMIC_RELAXED);
+	int64_t t = x_atomic_load(&w->top, X_ATOMIC_ACQUIRE);
+	struct deque_buf *a = x_atomic_load(&w->buf, X_ATOMIC_RELAXED);
+	if (b - t > a->mask)
+		a = deque_grow(w, a, t, b);
+	x_atomic_store(&a->slots[b & a->mask], work, X_ATOMIC_RELAXED);
+	/* A release store rather than a release fence, thread sanitizer follows it */
+	x_atomic_store(&w->bottom, b + 1, X_ATOMIC_RELEASE);
+}
+
+/* Owner only, the most recently pushed work */
+static x_tpool_work *deque_take(struct x_tpool_worker_st *w)
+{
+	int64_t b = x_atomic_load(&w->bottom, X_ATOMIC_RELAXED) - 1;
+	struct deque_buf *a = x_atomic_load(&w->buf, X_ATOMIC_RELAXED);
+	x_atomic_store(&w->bottom, b, X_ATOMIC_RELAXED);
+	x_atomic_fence(X_ATOMIC_SEQ_CST);
+	int64_t t = x_atomic_load(&w->top, X_ATOMIC_RELAXED);
+	x_tpool_work *work = NULL;
+	if (t <= b) {
+		work = x_atomic_load(&a->slots[b & a->mask], X_ATOMIC_RELAXED);
+		if (t == b) {
+			/* The last one, race the stealers for it */
+			if (!x_atomic_cas(&w->top, &t, t + 1, X_ATOMIC_SEQ_CST, X_ATOMIC_RELAXED))
+				work = NULL;
+			x_atomic_store(&w->bottom, b + 1, X_ATOMIC_RELAXED);
+		}
+	}
+	else
+		x_atomic_store(&w->bottom, b + 1, X_ATOMIC_RELAXED);
+	return work;
+}
+
+/* Any thread, the oldest work, NULL if empty or another thief was faster */
+static x_tpool_work *deque_steal(struct x_tpool_worker_st *w, bool *lost)
+{
+	int64_t t = x_atomic_load(&w->top, X_ATOMIC_ACQUIRE);
+	x_atomic_fence(X_ATOMIC_SEQ_CST);
+	int64_t b = x_atomic_load(&w->bottom, X_ATOMIC_ACQUIRE);
+	if (t >= b)
+		return NULL;
+	struct deque_buf *a = x_atomic_load(&w->buf, X_ATOMIC_ACQUIRE);
+	x_tpool_work *work = x_atomic_load(&a->slots[t & a->mask], X_ATOMIC_RELAXED);
+	if (!x_atomic_cas(&w->top, &t, t + 1, X_ATOMIC_SEQ_CST, X_ATOMIC_RELAXED)) {
+		*lost = true;
+		return NULL;
+	}
+	return work;
+}
+
+static bool deque_is_empty(struct x_tpool_worker_st *w)
+{
+	return x_atomic_load(&w->top, X_ATOMIC_SEQ_CST) >= x_atomic_load(&w->bottom, X_ATOMIC_SEQ_CST);
+}
+
+/* Wakes one sleeping worker, if any, for work just made visible */
+static void tpool_notify(x_tpool *tp)
+{
+	x_atomic_fence(X_ATOMIC_SEQ_CST);
+	if (!x_atomic_load(&tp->idle_cnt, X_ATOMIC_RELAXED))
+		return;
+	x_mutex_lock(&tp->work_mutex);
+	x_cond_wake(&tp->work_cond);
+	x_mutex_unlock(&tp->work_mutex);
+}
+
+/* A share of the queue, the first to run and the rest to the own deque */
+static x_tpool_work *tpool_take_global(struct x_tpool_worker_st *w)
+{
+	x_tpool *tp = w->pool;
+	x_tpool_work *work;
+	if (!x_atomic_load(&tp->work_cnt, X_ATOMIC_RELAXED))
+		return NULL;
+	x_mutex_lock(&tp->work_mutex);
+	size_t n = tp->work_cnt / tp->worker_cnt + 1;
+	if (n > GLOBAL_BATCH_MAX)
+		n = GLOBAL_BATCH_MAX;
+	if (n > tp->work_cnt)
+		n = tp->work_cnt;
+	x_atomic_store(&tp->work_cnt, tp->work_cnt - n, X_ATOMIC_RELAXED);
+	work = x_tpool_work_get(tp);
+	for (size_t i = 1; i < n; i++)
+		deque_push(w, x_tpool_work_get(tp));
+	x_mutex_unlock(&tp->work_mutex);
+	return work;
+}
+
+static x_tpool_work *tpool_steal(struct x_tpool_worker_st *w)
+{
+	x_tpool *tp = w->pool;
+	size_t cnt = tp->worker_cnt;
+	bool lost;
+	do {
+		lost = false;
+		/* xorshift, so that thieves spread over the victims */
+		w->seed ^= w->seed << 13;
+		w->seed ^= w->seed >> 17;
+		w->seed ^= w->seed << 5;
+		size_t start = w->seed % cnt;
+		for (size_t i = 0; i < cnt; i++) {
+			struct x_tpool_worker_st *victim = &tp->workers[(start + i) % cnt];
+			if (victim == w)
+				continue;
+			x_tpool_work *work = deque_steal(victim, &lost);
+			if (work)
+				return work;
+		}
+	} while (lost);
+	return NULL;
+}
+
+static bool tpool_has_work(x_tpool *tp)
+{
+	if (tp->work_first)
+		return true;
+	for (size_t i = 0; i < tp->worker_cnt; i++)
+		if (!deque_is_empty(&tp->workers[i]))
+			return true;
+	return false;
+}
+
+/* Sleeps until there may be work, true once the pool stops */
+static bool tpool_idle(x_tpool *tp)
+{
+	x_mutex_lock(&tp->work_mutex);
+	x_atomic_fetch_add(&tp->idle_cnt, 1, X_ATOMIC_SEQ_CST);
+	x_atomic_fence(X_ATOMIC_SEQ_CST);
+	/* Work in any deque keeps it awake, so an idle worker only misses new work */
+	while (!tp->stop && !tpool_has_work(tp))
+		x_cond_sleep(&tp->work_cond, &tp->work_mutex, -1);
+	x_atomic_fetch_sub(&tp->idle_cnt, 1, X_ATOMIC_SEQ_CST);
+	bool stop = tp->stop;
+	x_mutex_unlock(&tp->work_mutex);
+	return stop;
+}
+
+static int tpool_steal_worker(void)
+{
+	struct x_tpool_worker_st *w = x_thread_data();
+	x_tpool *tp = w->pool;
+	x_tss_set(&s_worker_key, w);
+	while (!x_atomic_load(&tp->stop, X_ATOMIC_ACQUIRE)) {
+		x_tpool_work *work = deque_take(w);
+		if (!work)
+			work = tpool_take_global(w);
+		if (!work)
+			work = tpool_steal(w);
+		if (!work) {
+			if (tpool_idle(tp))
+				break;
+			continue;
+		}
+		work->func(work->arg);
+		x_tpool_work_free(work);
+		if (x_atomic_fetch_sub(&tp->working_cnt, 1, X_ATOMIC_ACQ_REL) == 1) {
+			x_mutex_lock(&tp->work_mutex);
+			x_cond_wake_all(&tp->working_cond);
+			x_mutex_unlock(&tp->work_mutex);
+		}
+	}
+	x_tss_set(&s_worker_key, NULL);
+	x_mutex_lock(&tp->work_mutex);
+	tp->thread_cnt--;
+	x_cond_wake(&tp->working_cond);
+	x_mutex_unlock(&tp->work_mutex);
+	return 0;
+}
+
+static void tpool_free_workers(x_tpool *tp)
+{
+	for (size_t i = 0; i < tp->worker_cnt; i++) {
+		struct x_tpool_worker_st *w = &tp->workers[i];
+		x_tpool_work *work;
+		while ((work = deque_take(w)))
+			x_tpool_work_free(work);
+		for (struct deque_buf *a = w->buf, *prev; a; a = prev) {
+			prev = a->prev;
+			x_free(a);
+		}
+	}
+	x_free(tp->workers);
+	tp->workers = NULL;
+}
+
 int x_tpool_init(x_tpool *tp, size_t num)
+{
+	return x_tpool_init_mode(tp, num, X_TPOOL_SHARED);
+}
+
+int x_tpool_init_mode(x_tpool *tp, size_t num, int mode)
 {
 	x_thread **thds = NULL;
+	if (mode != X_TPOOL_SHARED && mode != X_TPOOL_STEALING) {
+		errno = X_EINVAL;
+		return -1;
+	}
 	if (num == 0)
 		num = 2;
 	memset(tp, 0, sizeof *tp);
+	tp->mode = mode;
 	tp->thread_cnt = num;
+	if (mode == X_TPOOL_STEALING) {
+		x_once_init(&s_worker_key_once, init_worker_key);
+		if (s_worker_key_errno) {
+			errno = s_worker_key_errno;
+			return -1;
+		}
+		tp->worker_cnt = num;
+		tp->workers = x_malloc(NULL, num * sizeof *tp->workers);
+		memset(tp->workers, 0, num * sizeof *tp->workers);
+		for (size_t i = 0; i < num; i++) {
+			tp->workers[i].buf = deque_buf_new(DEQUE_INIT_SIZE, NULL);
+			tp->workers[i].pool = tp;
+			tp->workers[i].seed = (uint32_t)i * 2654435761u + 1;
+		}
+	}
 	x_mutex_init(&tp->work_mutex);
 	x_cond_init(&tp->work_cond);
 	x_cond_init(&tp->working_cond);
 	thds = malloc(sizeof(x_thread *) * num);
 	if (!thds)
-		return -1;
+		goto fail;
 	for (int i = 0; i < num; i++) {
-		thds[i] = x_thread_create(tpool_worker, NULL, tp);
+		if (mode == X_TPOOL_STEALING)
+			thds[i] = x_thread_create(tpool_steal_worker, NULL, &tp->workers[i]);
+		else
+			thds[i] = x_thread_create(tpool_worker, NULL, tp);
 		if (!thds[i]) {
-			for (int j = i - 1; j >= 0; j++) {
-				x_thread_kill(thds[j]);
+			x_mutex_lock(&tp->work_mutex);
+			tp->stop = true;
+			tp->thread_cnt = i;
+			x_cond_wake_all(&tp->work_cond);
+			x_mutex_unlock(&tp->work_mutex);
+			for (int j = 0; j < i; j++) {
 				x_thread_join(thds[j], NULL);
+				x_thread_free(thds[j]);
 			}
 			free(thds);
-			return -1;
+			goto fail;
 		}
 	}
 	tp->thread_list = thds;
 	return 0;
+fail:
+	if (tp->workers)
+		tpool_free_workers(tp);
+	return -1;
 }
 
 void x_tpool_destroy(x_tpool *tp)
@@ -124,6 +417,7 @@ void x_tpool_destroy(x_tpool *tp)
 		return;
 	x_tpool_work *work;
 	x_tpool_work *work2;
+	size_t nthreads = tp->thread_cnt;
 	x_mutex_lock(&(tp->work_mutex));
 	work = tp->work_first;
 	while (work != NULL) {
@@ -131,14 +425,21 @@ void x_tpool_destroy(x_tpool *tp)
 		x_tpool_work_free(work);
 		work = work2;
 	}
-	tp->stop = true;
+	tp->work_first = tp->work_last = NULL;
+	x_atomic_store(&tp->work_cnt, 0, X_ATOMIC_RELAXED);
+	x_atomic_store(&tp->stop, true, X_ATOMIC_RELEASE);
 	x_cond_wake_all(&(tp->work_cond));
 	x_mutex_unlock(&(tp->work_mutex));
 	x_tpool_wait(tp);
-	for (int i = 0; i < tp->thread_cnt; i++) {
-		x_thread_kill(tp->thread_list[i]);
+	/* thread_cnt counts the workers still running, all are gone now */
+	for (size_t i = 0; i < nthreads; i++) {
 		x_thread_join(tp->thread_list[i], NULL);
+		x_thread_free(tp->thread_list[i]);
 	}
+	free(tp->thread_list);
+	tp->thread_list = NULL;
+	if (tp->workers)
+		tpool_free_workers(tp);
 	x_mutex_destroy(&(tp->work_mutex));
 	x_cond_destroy(&(tp->work_cond));
 	x_cond_destroy(&(tp->working_cond));
@@ -148,6 +449,26 @@ void x_tpool_add_work(x_tpool *tp, x_tpool_work *work)
 {
 	assert(tp);
 	assert(work);
+	if (tp->mode == X_TPOOL_STEALING) {
+		struct x_tpool_worker_st *w = x_tss_get(&s_worker_key);
+		x_atomic_fetch_add(&tp->working_cnt, 1, X_ATOMIC_RELAXED);
+		if (w && w->pool == tp) {
+			deque_push(w, work);
+			tpool_notify(tp);
+			return;
+		}
+		x_mutex_lock(&tp->work_mutex);
+		if (!tp->work_first)
+			tp->work_first = work;
+		else
+			tp->work_last->next = work;
+		tp->work_last = work;
+		x_atomic_store(&tp->work_cnt, tp->work_cnt + 1, X_ATOMIC_RELAXED);
+		if (tp->idle_cnt)
+			x_cond_wake(&tp->work_cond);
+		x_mutex_unlock(&tp->work_mutex);
+		return;
+	}
 	x_mutex_lock(&(tp->work_mutex));
 	tp->working_cnt++;
 	if (!tp->work_first) {
@@ -167,11 +488,11 @@ void x_tpool_wait(x_tpool *tp)
 	assert(tp);
 	x_mutex_lock(&(tp->work_mutex));
 	while (true) {
-		if ((!tp->stop && tp->working_cnt != 0) || (tp->stop && tp->thread_cnt != 0))
+		size_t working = x_atomic_load(&tp->working_cnt, X_ATOMIC_ACQUIRE);
+		if ((!tp->stop && working != 0) || (tp->stop && tp->thread_cnt != 0))
 			x_cond_sleep(&(tp->working_cond), &(tp->work_mutex), -1);
 		else
 			break;
 	}
 	x_mutex_unlock(&(tp->work_mutex));
 }
-
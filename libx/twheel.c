@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/twheel.h"
+#include "x/memory.h"
+#include <assert.h>
+
+#define SLOT_MASK (X_TWHEEL_SLOTS - 1)
+#define LEVEL_SHIFT(l) ((l) * X_TWHEEL_BITS)
+#define WHEEL_SPAN ((uint64_t)1 << LEVEL_SHIFT(X_TWHEEL_LEVELS))
+
+static inline unsigned lowest_bit(uint64_t m)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(m);
+#else
+	unsigned n = 0;
+	while (!(m & 1)) {
+		m >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+static inline uint64_t rotr(uint64_t m, unsigned n)
+{
+	return n ? (m >> n) | (m << (64 - n)) : m;
+}
+
+static void wheel_place(x_twheel *w, x_twnode *n)
+{
+	uint64_t delta = n->expire - w->current, at = n->expire;
+	int level = 0;
+	if (n->expire < w->current) {
+		/* Overdue, fire on the current tick */
+		delta = 0;
+		at = w->current;
+	} else if (delta >= WHEEL_SPAN) {
+		delta = WHEEL_SPAN - 1;
+		at = w->current + delta;
+	}
+	while (delta >= (uint64_t)1 << LEVEL_SHIFT(level + 1))
+		level++;
+	unsigned idx = (at >> LEVEL_SHIFT(level)) & SLOT_MASK;
+	n->slot = level * X_TWHEEL_SLOTS + idx;
+	x_list_add_back(&w->slots[n->slot], &n->link);
+	w->occupied[level] |= (uint64_t)1 << idx;
+}
+
+/* Redistribute the coarse slots whose span begins at the current tick */
+static void wheel_cascade(x_twheel *w)
+{
+	for (int level = 1; level < X_TWHEEL_LEVELS; level++) {
+		unsigned idx = (w->current >> LEVEL_SHIFT(level)) & SLOT_MASK;
+		x_list *slot = &w->slots[level * X_TWHEEL_SLOTS + idx];
+		if (w->occupied[level] & ((uint64_t)1 << idx)) {
+			w->occupied[level] &= ~((uint64_t)1 << idx);
+			x_link *link;
+			while ((link = x_list_first(slot))) {
+				x_list_del(link);
+				wheel_place(w, x_container_of(link, x_twnode, link));
+			}
+		}
+		if (idx != 0)
+			break;
+	}
+}
+
+void x_twheel_init(x_twheel *w, uint64_t now)
+{
+	assert(w != NULL);
+	w->current = now;
+	w->entry_cnt = 0;
+	for (int i = 0; i < X_TWHEEL_LEVELS; i++)
+		w->occupied[i] = 0;
+	w->slots = x_malloc(NULL, X_TWHEEL_LEVELS * X_TWHEEL_SLOTS * sizeof(x_list));
+	for (int i = 0; i < X_TWHEEL_LEVELS * X_TWHEEL_SLOTS; i++)
+		x_list_init(&w->slots[i]);
+}
+
+void x_twheel_free(x_twheel *w)
+{
+	if (!w)
+		return;
+	x_free(w->slots);
+	w->slots = NULL;
+	w->entry_cnt = 0;
+}
+
+void x_twheel_add(x_twheel *w, x_twnode *n, uint64_t expire)
+{
+	assert(w != NULL);
+	assert(n != NULL);
+	n->expire = expire < w->current ? w->current : expire;
+	wheel_place(w, n);
+	w->entry_cnt++;
+}
+
+void x_twheel_remove(x_twheel *w, x_twnode *n)
+{
+	assert(w != NULL);
+	assert(n != NULL);
+	assert(x_twnode_pending(n));
+	x_list *slot = &w->slots[n->slot];
+	x_list_del(&n->link);
+	if (x_list_is_empty(slot))
+		w->occupied[n->slot / X_TWHEEL_SLOTS] &= ~((uint64_t)1 << (n->slot & SLOT_MASK));
+	w->entry_cnt--;
+}
+
+size_t x_twheel_advance(x_twheel *w, uint64_t now, x_list *expired)
+{
+	assert(w != NULL);
+	assert(expired != NULL);
+	size_t cnt = 0;
+	while (w->current <= now) {
+		if (w->entry_cnt == 0) {
+			w->current = now + 1;
+			break;
+		}
+		unsigned idx = w->current & SLOT_MASK;
+		if (idx == 0)
+			wheel_cascade(w);
+		uint64_t pending = w->occupied[0] >> idx;
+		if (!pending) {
+			/* Jump over empty slots to the next expiry or cascade,
+			 * never past a block boundary that still has to cascade */
+			uint64_t next = x_twheel_next(w);
+			if (next > now) {
+				w->current = now + 1;
+				break;
+			}
+			w->current = next;
+			continue;
+		}
+		uint64_t tick = w->current + lowest_bit(pending);
+		if (tick > now) {
+			w->current = now + 1;
+			break;
+		}
+		idx = tick & SLOT_MASK;
+		x_list *slot = &w->slots[idx];
+		x_link *link;
+		while ((link = x_list_first(slot))) {
+			x_list_del(link);
+			x_list_add_back(expired, link);
+			w->entry_cnt--;
+			cnt++;
+		}
+		w->occupied[0] &= ~((uint64_t)1 << idx);
+		w->current = tick + 1;
+	}
+	return cnt;
+}
+
+uint64_t x_twheel_next(const x_twheel *w)
+{
+	assert(w != NULL);
+	if (w->entry_cnt == 0)
+		return UINT64_MAX;
+	/* Level 0 holds exactly the ticks [current, current + SLOTS) */
+	uint64_t next = UINT64_MAX, m = rotr(w->occupied[0], w->current & SLOT_MASK);
+	if (m)
+		next = w->current + lowest_bit(m);
+	/* A level 0 tick past the block boundary may still be preceded by a
+	 * cascade, so take the earliest of both as a lower bound */
+	for (int level = 1; level < X_TWHEEL_LEVELS; level++) {
+		if (!w->occupied[level])
+			continue;
+		unsigned shift = LEVEL_SHIFT(level);
+		uint64_t base = (w->current + ((uint64_t)1 << shift) - 1) >> shift;
+		m = rotr(w->occupied[level], base & SLOT_MASK);
+		uint64_t tick = (base + lowest_bit(m)) << shift;
+		if (tick < next)
+			next = tick;
+	}
+	return next;
+}
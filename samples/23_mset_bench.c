@@ -0,0 +1,74 @@
+#include "x/memory.h"
+#include "x/thread.h"
+#include "x/time.h"
+#include "x/sys.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#define ROUNDS 200
+#define BLOCKS 4096
+
+struct bench_arg
+{
+	bool arena;
+};
+
+static int bench_thread(void)
+{
+	struct bench_arg *arg = x_thread_data();
+	void *table[BLOCKS];
+	x_mset arena;
+	x_mset *mset = NULL;
+
+	if (arg->arena) {
+		x_mset_init_arena(&arena, 0);
+		mset = &arena;
+	}
+
+	for (int r = 0; r < ROUNDS; r++) {
+		for (int i = 0; i < BLOCKS; i++)
+			table[i] = x_malloc(mset, 16 + (i & 63));
+		if (arg->arena)
+			x_mset_clear(mset);
+		else
+			for (int i = 0; i < BLOCKS; i++)
+				x_free(table[i]);
+	}
+
+	if (arg->arena)
+		x_mset_free(mset);
+	return 0;
+}
+
+static uint64_t run(int nthreads, bool arena)
+{
+	x_thread *thds[64];
+	struct bench_arg arg = { .arena = arena };
+	uint64_t start = x_time_tick();
+	for (int i = 0; i < nthreads; i++)
+		thds[i] = x_thread_create(bench_thread, NULL, &arg);
+	for (int i = 0; i < nthreads; i++) {
+		x_thread_join(thds[i], NULL);
+		x_thread_free(thds[i]);
+	}
+	return x_time_tick() - start;
+}
+
+int main(int argc, char *argv[])
+{
+	int max_threads = argc > 1 ? atoi(argv[1]) : x_sys_nprocs();
+	if (max_threads < 1)
+		max_threads = 1;
+	if (max_threads > 64)
+		max_threads = 64;
+
+	printf("%-8s %-12s %-12s %s\n", "threads", "mset(ms)", "arena(ms)", "allocs/thread");
+	for (int n = 1; n <= max_threads; n++) {
+		uint64_t t1 = run(n, false);
+		uint64_t t2 = run(n, true);
+		printf("%-8d %-12llu %-12llu %d\n", n, (unsigned long long)t1,
+				(unsigned long long)t2, ROUNDS * BLOCKS);
+	}
+	x_mset_free(NULL);
+	return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Compare x_hmap (chained) and x_ohmap (open addressing) with N = 1e3 ..
+ * 1e<max> entries, where max is given by argv[1] and defaults to 7.
+ * Each element takes about 24 bytes, so 1e8 needs several gigabytes.
+ */
+
+#include "x/hmap.h"
+#include "x/ohmap.h"
+#include "x/list.h"
+#include "x/memory.h"
+#include "x/macros.h"
+#include "x/time.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+struct elem {
+	x_link link;
+	uint64_t key;
+};
+
+static size_t elem_hash(const x_link *link)
+{
+	uint64_t k = x_container_of(link, struct elem, link)->key;
+	return (size_t)(k ^ (k >> 29));
+}
+
+static bool elem_equal(const x_link *l1, const x_link *l2)
+{
+	return x_container_of(l1, struct elem, link)->key
+		== x_container_of(l2, struct elem, link)->key;
+}
+
+static uint64_t mix(uint64_t x)
+{
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+struct result {
+	uint64_t insert, hit, miss;
+};
+
+static void bench_hmap(struct elem *elems, size_t n, struct result *res)
+{
+	x_hmap ht;
+	x_hmap_init(&ht, 0.75, elem_hash, elem_equal);
+	uint64_t t = x_time_tick();
+	for (size_t i = 0; i < n; i++) {
+		elems[i].link.prev = elems[i].link.next = NULL;
+		x_hmap_find_or_insert(&ht, &elems[i].link);
+	}
+	res->insert = x_time_tick() - t;
+
+	size_t found = 0;
+	struct elem key;
+	key.link.prev = key.link.next = NULL;
+	t = x_time_tick();
+	for (size_t i = 0; i < n; i++) {
+		key.key = mix(mix(i * 7919 % n));
+		found += !!x_hmap_find(&ht, &key.link);
+	}
+	res->hit = x_time_tick() - t;
+
+	t = x_time_tick();
+	for (size_t i = 0; i < n; i++) {
+		key.key = mix(mix(i + n));
+		found += !!x_hmap_find(&ht, &key.link);
+	}
+	res->miss = x_time_tick() - t;
+	if (found != n)
+		fprintf(stderr, "hmap: unexpected %zu hits\n", found);
+	x_hmap_free(&ht);
+}
+
+static void bench_ohmap(struct elem *elems, size_t n, struct result *res)
+{
+	x_ohmap om;
+	x_ohmap_init(&om, elem_hash, elem_equal);
+	uint64_t t = x_time_tick();
+	for (size_t i = 0; i < n; i++)
+		x_ohmap_find_or_insert(&om, &elems[i].link);
+	res->insert = x_time_tick() - t;
+
+	size_t found = 0;
+	struct elem key;
+	t = x_time_tick();
+	for (size_t i = 0; i < n; i++) {
+		key.key = mix(mix(i * 7919 % n));
+		found += !!x_ohmap_find(&om, &key.link);
+	}
+	res->hit = x_time_tick() - t;
+
+	t = x_time_tick();
+	for (size_t i = 0; i < n; i++) {
+		key.key = mix(mix(i + n));
+		found += !!x_ohmap_find(&om, &key.link);
+	}
+	res->miss = x_time_tick() - t;
+	if (found != n)
+		fprintf(stderr, "ohmap: unexpected %zu hits\n", found);
+	x_ohmap_free(&om);
+}
+
+int main(int argc, char *argv[])
+{
+	int max_exp = argc > 1 ? atoi(argv[1]) : 7;
+	if (max_exp < 3)
+		max_exp = 3;
+	if (max_exp > 8)
+		max_exp = 8;
+
+	printf("%-10s %-24s %-24s\n", "", "hmap(ms)", "ohmap(ms)");
+	printf("%-10s %-8s%-8s%-8s %-8s%-8s%-8s\n", "entries",
+			"insert", "hit", "miss", "insert", "hit", "miss");
+	size_t n = 1000;
+	for (int e = 3; e <= max_exp; e++, n *= 10) {
+		struct elem *elems = malloc(n * sizeof *elems);
+		if (!elems) {
+			fprintf(stderr, "out of memory at %zu entries\n", n);
+			break;
+		}
+		for (size_t i = 0; i < n; i++)
+			elems[i].key = mix(mix(i));
+		struct result r1, r2;
+		bench_hmap(elems, n, &r1);
+		bench_ohmap(elems, n, &r2);
+		printf("%-10zu %-8llu%-8llu%-8llu %-8llu%-8llu%-8llu\n", n,
+				(unsigned long long)r1.insert, (unsigned long long)r1.hit,
+				(unsigned long long)r1.miss, (unsigned long long)r2.insert,
+				(unsigned long long)r2.hit, (unsigned long long)r2.miss);
+		free(elems);
+	}
+	x_mset_free(NULL);
+	return 0;
+}
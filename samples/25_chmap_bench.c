@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Read-mostly lookup throughput of x_chmap against an x_hmap guarded by an
+ * x_rwlock, from 1 up to argv[1] threads (default: number of CPUs). One
+ * operation in WRITE_EVERY is an insert or remove of a key in the upper
+ * half, the lower half is always present.
+ */
+
+#include "x/chmap.h"
+#include "x/atomic.h"
+#include "x/hmap.h"
+#include "x/list.h"
+#include "x/rwlock.h"
+#include "x/thread.h"
+#include "x/memory.h"
+#include "x/macros.h"
+#include "x/time.h"
+#include "x/sys.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#define NKEYS 65536
+#define OPS_PER_THREAD 2000000
+#define WRITE_EVERY 64
+
+struct elem {
+	x_link link;
+	size_t key;
+};
+
+struct bench {
+	bool concurrent;
+	x_chmap cm;
+	x_hmap ht;
+	x_rwlock lock;
+	struct elem *elems;
+	int nthreads;
+	int next_id;
+};
+
+static size_t elem_hash(const x_link *link)
+{
+	return x_container_of(link, struct elem, link)->key;
+}
+
+static bool elem_equal(const x_link *l1, const x_link *l2)
+{
+	return x_container_of(l1, struct elem, link)->key
+		== x_container_of(l2, struct elem, link)->key;
+}
+
+static uint64_t next_rand(uint64_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+static int bench_thread(void)
+{
+	struct bench *b = x_thread_data();
+	int id = x_atomic_fetch_add(&b->next_id, 1, X_ATOMIC_RELAXED);
+	uint64_t rnd = 0x9E3779B97F4A7C15ULL * (id + 1);
+	/* Each thread owns a disjoint slice of the upper half for writes */
+	size_t slice = NKEYS / 2 / b->nthreads, base = NKEYS / 2 + id * slice;
+	size_t hits = 0, wpos = 0;
+
+	for (int i = 0; i < OPS_PER_THREAD; i++) {
+		if (slice && i % WRITE_EVERY == 0) {
+			struct elem *e = b->elems + base + wpos++ % slice;
+			if (b->concurrent) {
+				if (!x_chmap_find_and_remove(&b->cm, &e->link))
+					x_chmap_find_or_insert(&b->cm, &e->link);
+			}
+			else {
+				x_rwlock_wlock(&b->lock);
+				if (!x_hmap_find_and_remove(&b->ht, &e->link))
+					x_hmap_find_or_insert(&b->ht, &e->link);
+				x_rwlock_unlock(&b->lock);
+			}
+			continue;
+		}
+		struct elem key;
+		x_link_init(&key.link);
+		key.key = next_rand(&rnd) % NKEYS;
+		if (b->concurrent)
+			hits += !!x_chmap_find(&b->cm, &key.link);
+		else {
+			x_rwlock_rlock(&b->lock);
+			hits += !!x_hmap_find(&b->ht, &key.link);
+			x_rwlock_unlock(&b->lock);
+		}
+	}
+	return hits > 0 ? 0 : -1;
+}
+
+static uint64_t run(int nthreads, bool concurrent)
+{
+	x_thread *thds[256];
+	struct bench b = { .concurrent = concurrent, .nthreads = nthreads };
+	b.elems = calloc(NKEYS, sizeof *b.elems);
+	if (concurrent)
+		x_chmap_init(&b.cm, 0, 0.75, elem_hash, elem_equal);
+	else {
+		x_hmap_init(&b.ht, 0.75, elem_hash, elem_equal);
+		x_rwlock_init(&b.lock);
+	}
+	for (size_t i = 0; i < NKEYS; i++) {
+		b.elems[i].key = i;
+		if (concurrent)
+			x_chmap_find_or_insert(&b.cm, &b.elems[i].link);
+		else
+			x_hmap_find_or_insert(&b.ht, &b.elems[i].link);
+	}
+
+	uint64_t start = x_time_tick();
+	for (int i = 0; i < nthreads; i++)
+		thds[i] = x_thread_create(bench_thread, NULL, &b);
+	for (int i = 0; i < nthreads; i++) {
+		x_thread_join(thds[i], NULL);
+		x_thread_free(thds[i]);
+	}
+	uint64_t elapsed = x_time_tick() - start;
+
+	if (concurrent)
+		x_chmap_free(&b.cm);
+	else {
+		x_hmap_free(&b.ht);
+		x_rwlock_destroy(&b.lock);
+	}
+	free(b.elems);
+	return elapsed ? elapsed : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	int max_threads = argc > 1 ? atoi(argv[1]) : x_sys_nprocs();
+	if (max_threads < 1)
+		max_threads = 1;
+	if (max_threads > 256)
+		max_threads = 256;
+
+	printf("%-8s %-16s %-16s\n", "threads", "rwlock(Mops/s)", "chmap(Mops/s)");
+	for (int n = 1; n <= max_threads; n *= 2) {
+		double ops = (double)n * OPS_PER_THREAD / 1000.0;
+		uint64_t t1 = run(n, false);
+		uint64_t t2 = run(n, true);
+		printf("%-8d %-16.2f %-16.2f\n", n, ops / t1, ops / t2);
+		if (n < max_threads && n * 2 > max_threads)
+			n = max_threads / 2;
+	}
+	x_mset_free(NULL);
+	return 0;
+}
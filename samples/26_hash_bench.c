@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Throughput and distribution quality of x_memhash (djb2), x_hash64 and
+ * x_memhash64. Throughput is measured over key lengths from 4 bytes to
+ * 64KB. Quality is measured as bucket collisions of sequential integer and
+ * "user:N" string keys in the low 20 bits (what a power-of-two table uses)
+ * against the expectation for a random function, and as avalanche: the
+ * average and worst per-output-bit flip probability for single input bit
+ * changes (ideal 0.5).
+ */
+
+#include "x/string.h"
+#include "x/time.h"
+#include "x/memory.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#define BENCH_BYTES (64 * 1024 * 1024)
+#define QUALITY_BITS 20
+#define AVALANCHE_ROUNDS 2000
+
+typedef uint64_t hash_fn(const void *p, size_t size);
+
+static uint64_t djb2(const void *p, size_t size)
+{
+	return x_memhash(p, size);
+}
+
+static uint64_t murmur_byte(const void *p, size_t size)
+{
+	return x_hash64(p, size);
+}
+
+static uint64_t memhash64(const void *p, size_t size)
+{
+	return x_memhash64(p, size, 0x5eed);
+}
+
+static const struct {
+	const char *name;
+	hash_fn *fn;
+} s_hashes[] = {
+	{ "x_memhash", djb2 },
+	{ "x_hash64", murmur_byte },
+	{ "x_memhash64", memhash64 },
+};
+
+static double throughput(hash_fn *fn, uint8_t *buf, size_t len)
+{
+	size_t rounds = BENCH_BYTES / len;
+	uint64_t sink = 0;
+	uint64_t start = x_time_tick();
+	for (size_t i = 0; i < rounds; i++) {
+		buf[0] = (uint8_t)i;
+		sink ^= fn(buf, len);
+	}
+	uint64_t elapsed = x_time_tick() - start;
+	if (sink == 42)
+		printf(" ");
+	return (double)BENCH_BYTES / 1e6 / (elapsed ? elapsed : 1); /* MB per ms */
+}
+
+static size_t collisions(hash_fn *fn, bool strings)
+{
+	size_t nbuckets = (size_t)1 << QUALITY_BITS, cnt = 0;
+	uint8_t *used = calloc(nbuckets, 1);
+	for (uint32_t i = 0; i < nbuckets; i++) {
+		char str[32];
+		uint64_t h;
+		if (strings)
+			h = fn(str, sprintf(str, "user:%u", i));
+		else
+			h = fn(&i, sizeof i);
+		size_t b = h & (nbuckets - 1);
+		cnt += used[b];
+		used[b] = 1;
+	}
+	free(used);
+	return cnt;
+}
+
+static void avalanche(hash_fn *fn, double *mean, double *worst)
+{
+	enum { KEY_LEN = 16, IN_BITS = KEY_LEN * 8 };
+	static unsigned flips[IN_BITS][64];
+	uint8_t key[KEY_LEN];
+	uint64_t rnd = 88172645463325252ULL;
+	for (int i = 0; i < IN_BITS; i++)
+		for (int j = 0; j < 64; j++)
+			flips[i][j] = 0;
+	for (int r = 0; r < AVALANCHE_ROUNDS; r++) {
+		for (int i = 0; i < KEY_LEN; i++) {
+			rnd ^= rnd << 13, rnd ^= rnd >> 7, rnd ^= rnd << 17;
+			key[i] = (uint8_t)rnd;
+		}
+		uint64_t h = fn(key, KEY_LEN);
+		for (int i = 0; i < IN_BITS; i++) {
+			key[i / 8] ^= 1 << (i % 8);
+			uint64_t d = h ^ fn(key, KEY_LEN);
+			key[i / 8] ^= 1 << (i % 8);
+			for (int j = 0; j < 64; j++)
+				flips[i][j] += (d >> j) & 1;
+		}
+	}
+	double sum = 0, max_bias = 0;
+	for (int i = 0; i < IN_BITS; i++) {
+		for (int j = 0; j < 64; j++) {
+			double p = (double)flips[i][j] / AVALANCHE_ROUNDS;
+			sum += p;
+			if (fabs(p - 0.5) > max_bias)
+				max_bias = fabs(p - 0.5);
+		}
+	}
+	*mean = sum / (IN_BITS * 64);
+	*worst = max_bias;
+}
+
+int main(void)
+{
+	static const size_t lens[] = { 4, 8, 16, 32, 64, 128, 256, 1024, 4096, 65536 };
+	uint8_t *buf = malloc(65536);
+	for (size_t i = 0; i < 65536; i++)
+		buf[i] = (uint8_t)(i * 2654435761U >> 24);
+
+	printf("throughput (GB/s)\n%-8s", "bytes");
+	for (size_t h = 0; h < x_arrlen(s_hashes); h++)
+		printf(" %-12s", s_hashes[h].name);
+	printf("\n");
+	for (size_t l = 0; l < x_arrlen(lens); l++) {
+		printf("%-8zu", lens[l]);
+		for (size_t h = 0; h < x_arrlen(s_hashes); h++)
+			printf(" %-12.2f", throughput(s_hashes[h].fn, buf, lens[l]));
+		printf("\n");
+	}
+
+	double n = (double)((size_t)1 << QUALITY_BITS);
+	double expected = n - n * (1 - pow(1 - 1 / n, n));
+	printf("\nquality (%d-bit buckets, random function expects %.0f collisions)\n", QUALITY_BITS, expected);
+	printf("%-12s %-10s %-10s %-12s %s\n", "hash", "int keys", "str keys", "avalanche", "worst bias");
+	for (size_t h = 0; h < x_arrlen(s_hashes); h++) {
+		double mean, worst;
+		avalanche(s_hashes[h].fn, &mean, &worst);
+		printf("%-12s %-10zu %-10zu %-12.4f %.4f\n", s_hashes[h].name,
+				collisions(s_hashes[h].fn, false), collisions(s_hashes[h].fn, true),
+				mean, worst);
+	}
+	free(buf);
+	return 0;
+}
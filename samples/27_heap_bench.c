@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * x_heap (binary, comparator callback, node pointers only) against x_dheap
+ * (4-ary, inline uint64_t keys). Three workloads per heap size: push all
+ * then pop all, the "hold" model a timer queue sees (pop the minimum and
+ * push it back a random distance later) and construction of a heap from an
+ * unordered batch, where x_dheap_build heapifies in O(n).
+ */
+
+#include "x/heap.h"
+#include "x/time.h"
+#include "x/macros.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#define TOTAL_OPS (1 << 22)
+
+struct elem {
+	x_ranode node;
+	uint64_t key;
+};
+
+static bool elem_ordered(const x_ranode *n1, const x_ranode *n2)
+{
+	return x_container_of(n1, struct elem, node)->key
+		<= x_container_of(n2, struct elem, node)->key;
+}
+
+static uint64_t s_rnd = 88172645463325252ULL;
+
+static uint64_t rnd(void)
+{
+	s_rnd ^= s_rnd << 13, s_rnd ^= s_rnd >> 7, s_rnd ^= s_rnd << 17;
+	return s_rnd;
+}
+
+static double ns_per_op(uint64_t ms, size_t ops)
+{
+	return (double)ms * 1e6 / ops;
+}
+
+static void fill(struct elem *elems, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		elems[i].key = rnd() % (n * 16);
+}
+
+static double heap_push_pop(struct elem *elems, size_t n)
+{
+	size_t rounds = TOTAL_OPS / n, ops = 0;
+	uint64_t start = x_time_tick();
+	for (size_t r = 0; r < rounds; r++) {
+		x_heap h;
+		x_heap_init(&h, elem_ordered);
+		for (size_t i = 0; i < n; i++)
+			x_heap_push(&h, &elems[i].node);
+		while (x_heap_pop(&h))
+			;
+		x_heap_free(&h);
+		ops += n * 2;
+	}
+	return ns_per_op(x_time_tick() - start, ops);
+}
+
+static double dheap_push_pop(struct elem *elems, size_t n)
+{
+	size_t rounds = TOTAL_OPS / n, ops = 0;
+	uint64_t start = x_time_tick();
+	for (size_t r = 0; r < rounds; r++) {
+		x_dheap h;
+		x_dheap_init(&h);
+		for (size_t i = 0; i < n; i++)
+			x_dheap_push(&h, &elems[i].node, elems[i].key);
+		while (x_dheap_pop(&h, NULL))
+			;
+		x_dheap_free(&h);
+		ops += n * 2;
+	}
+	return ns_per_op(x_time_tick() - start, ops);
+}
+
+static double heap_hold(struct elem *elems, size_t n)
+{
+	x_heap h;
+	x_heap_init(&h, elem_ordered);
+	for (size_t i = 0; i < n; i++)
+		x_heap_push(&h, &elems[i].node);
+	uint64_t start = x_time_tick();
+	for (size_t i = 0; i < TOTAL_OPS; i++) {
+		struct elem *e = x_container_of(x_heap_pop(&h), struct elem, node);
+		e->key += 1 + rnd() % (n * 16);
+		x_heap_push(&h, &e->node);
+	}
+	double ns = ns_per_op(x_time_tick() - start, TOTAL_OPS);
+	x_heap_free(&h);
+	return ns;
+}
+
+static double dheap_hold(struct elem *elems, size_t n)
+{
+	x_dheap h;
+	x_dheap_init(&h);
+	for (size_t i = 0; i < n; i++)
+		x_dheap_push(&h, &elems[i].node, elems[i].key);
+	uint64_t start = x_time_tick();
+	for (size_t i = 0; i < TOTAL_OPS; i++) {
+		uint64_t key;
+		x_ranode *node = x_dheap_pop(&h, &key);
+		x_dheap_push(&h, node, key + 1 + rnd() % (n * 16));
+	}
+	double ns = ns_per_op(x_time_tick() - start, TOTAL_OPS);
+	x_dheap_free(&h);
+	return ns;
+}
+
+static double dheap_build(struct elem *elems, size_t n)
+{
+	x_ranode **nodes = malloc(n * sizeof *nodes);
+	uint64_t *keys = malloc(n * sizeof *keys);
+	for (size_t i = 0; i < n; i++) {
+		nodes[i] = &elems[i].node;
+		keys[i] = elems[i].key;
+	}
+	size_t rounds = TOTAL_OPS / n;
+	uint64_t start = x_time_tick();
+	for (size_t r = 0; r < rounds; r++) {
+		x_dheap h;
+		x_dheap_init(&h);
+		x_dheap_build(&h, nodes, keys, n);
+		x_dheap_free(&h);
+	}
+	double ns = ns_per_op(x_time_tick() - start, rounds * n);
+	free(keys);
+	free(nodes);
+	return ns;
+}
+
+static double dheap_push_only(struct elem *elems, size_t n)
+{
+	size_t rounds = TOTAL_OPS / n;
+	uint64_t start = x_time_tick();
+	for (size_t r = 0; r < rounds; r++) {
+		x_dheap h;
+		x_dheap_init(&h);
+		for (size_t i = 0; i < n; i++)
+			x_dheap_push(&h, &elems[i].node, elems[i].key);
+		x_dheap_free(&h);
+	}
+	return ns_per_op(x_time_tick() - start, rounds * n);
+}
+
+int main(void)
+{
+	static const size_t sizes[] = { 64, 1024, 16384, 262144, 1048576 };
+	size_t max = sizes[x_arrlen(sizes) - 1];
+	struct elem *elems = malloc(max * sizeof *elems);
+
+	printf("ns/op %-9s %-10s %-10s %-10s %-10s %-10s %s\n", "entries",
+			"heap p/p", "dheap p/p", "heap hold", "dheap hold", "push n", "build n");
+	for (size_t s = 0; s < x_arrlen(sizes); s++) {
+		size_t n = sizes[s];
+		fill(elems, n);
+		double hp = heap_push_pop(elems, n);
+		double dp = dheap_push_pop(elems, n);
+		fill(elems, n);
+		double hh = heap_hold(elems, n);
+		fill(elems, n);
+		double dh = dheap_hold(elems, n);
+		fill(elems, n);
+		double pn = dheap_push_only(elems, n);
+		double bn = dheap_build(elems, n);
+		printf("      %-9zu %-10.1f %-10.1f %-10.1f %-10.1f %-10.1f %.1f\n",
+				n, hp, dp, hh, dh, pn, bn);
+	}
+	free(elems);
+	return 0;
+}
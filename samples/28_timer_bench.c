@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * 1M idle-connection style timers on both reactor timer stores. "add" and
+ * "churn" go through x_reactor_add / x_reactor_remove (a connection seeing
+ * traffic re-arms its idle timer), "expire" drives the bare x_dheap and
+ * x_twheel through 60 simulated seconds at 1ms resolution and reports the
+ * cost per expired timer, including the empty ticks in between.
+ */
+
+#include "x/reactor.h"
+#include "x/time.h"
+#include "x/macros.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#define TIMER_CNT (1 << 20)
+#define CHURN_OPS (1 << 21)
+#define MAX_IDLE 60000
+
+static uint64_t s_rnd = 88172645463325252ULL;
+
+static uint64_t rnd(void)
+{
+	s_rnd ^= s_rnd << 13, s_rnd ^= s_rnd >> 7, s_rnd ^= s_rnd << 17;
+	return s_rnd;
+}
+
+static void reactor_bench(int store, const char *name)
+{
+	x_reactor r;
+	x_evtimer *timers = calloc(TIMER_CNT, sizeof *timers);
+	x_reactor_init(&r);
+	x_reactor_set_timer_store(&r, store);
+
+	uint64_t start = x_time_tick();
+	for (size_t i = 0; i < TIMER_CNT; i++) {
+		x_evtimer_init(&timers[i], 1000 + rnd() % MAX_IDLE, 0, NULL);
+		x_reactor_add(&r, &timers[i].base);
+	}
+	uint64_t add_ms = x_time_tick() - start;
+
+	start = x_time_tick();
+	for (size_t i = 0; i < CHURN_OPS; i++) {
+		x_evtimer *t = &timers[rnd() % TIMER_CNT];
+		x_reactor_remove(&r, &t->base);
+		x_reactor_add(&r, &t->base);
+	}
+	uint64_t churn_ms = x_time_tick() - start;
+
+	printf("%-8s %-12.1f %.1f\n", name, add_ms * 1e6 / TIMER_CNT, churn_ms * 1e6 / CHURN_OPS);
+	x_reactor_free(&r);
+	free(timers);
+}
+
+struct heap_timer {
+	x_ranode node;
+};
+
+static double heap_expire(void)
+{
+	x_dheap h;
+	struct heap_timer *timers = calloc(TIMER_CNT, sizeof *timers);
+	x_dheap_init(&h);
+	for (size_t i = 0; i < TIMER_CNT; i++)
+		x_dheap_push(&h, &timers[i].node, 1 + rnd() % MAX_IDLE);
+	size_t expired = 0;
+	uint64_t start = x_time_tick(), key;
+	for (uint64_t now = 1; now <= MAX_IDLE; now++) {
+		while (x_dheap_top(&h, &key) && key <= now) {
+			x_dheap_pop(&h, NULL);
+			expired++;
+		}
+	}
+	double ns = (x_time_tick() - start) * 1e6 / expired;
+	x_dheap_free(&h);
+	free(timers);
+	return ns;
+}
+
+static double wheel_expire(void)
+{
+	x_twheel w;
+	x_list list;
+	x_twnode *timers = calloc(TIMER_CNT, sizeof *timers);
+	x_twheel_init(&w, 0);
+	x_list_init(&list);
+	for (size_t i = 0; i < TIMER_CNT; i++)
+		x_twheel_add(&w, &timers[i], 1 + rnd() % MAX_IDLE);
+	size_t expired = 0;
+	uint64_t start = x_time_tick();
+	for (uint64_t now = 1; now <= MAX_IDLE; now++) {
+		expired += x_twheel_advance(&w, now, &list);
+		x_list_init(&list);
+	}
+	double ns = (x_time_tick() - start) * 1e6 / expired;
+	x_twheel_free(&w);
+	free(timers);
+	return ns;
+}
+
+int main(void)
+{
+	printf("%d timers, ns/op\n%-8s %-12s %s\n", TIMER_CNT, "store", "add", "churn");
+	reactor_bench(X_REACTOR_TIMER_HEAP, "heap");
+	reactor_bench(X_REACTOR_TIMER_WHEEL, "wheel");
+	printf("\nexpire over %d ticks, ns/timer\n", MAX_IDLE);
+	printf("%-8s %.1f\n", "heap", heap_expire());
+	printf("%-8s %.1f\n", "wheel", wheel_expire());
+	return 0;
+}
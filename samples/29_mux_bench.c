@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Ready event dispatch rate of x_reactor on each sockmux backend. In the
+ * "ready" run N socketpairs each hold one unread byte, so with level
+ * triggering every x_reactor_wait reports all N sockets ready and the loop
+ * measures poll + dispatch + pop per event. In the "echo" run one byte
+ * is written to 1/8 of the sockets per round and drained on dispatch.
+ * That is closer to a server, where few of many registered sockets wake.
+ */
+
+#include "x/reactor.h"
+#include "x/sockmux.h"
+#include "x/time.h"
+#include "x/macros.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+#define BENCH_MS 1000
+
+static double bench(const struct x_sockmux_ops_st *ops, size_t n, bool echo)
+{
+	x_reactor r;
+	x_evsocket *evs = calloc(n, sizeof *evs);
+	x_sock (*pairs)[2] = calloc(n, sizeof *pairs);
+	if (x_reactor_init_mux(&r, ops)) {
+		free(pairs);
+		free(evs);
+		return 0;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pairs[i]) == -1) {
+			perror("socketpair");
+			exit(1);
+		}
+		if (!echo)
+			(void)send(pairs[i][1], "x", 1, 0);
+		x_evsocket_init(&evs[i], pairs[i][0], X_EV_READ, NULL);
+		x_reactor_add(&r, &evs[i].base);
+	}
+
+	size_t wake = echo ? (n + 7) / 8 : 0, next = 0;
+	uint64_t events = 0, start = x_time_tick(), elapsed;
+	do {
+		for (int i = 0; i < 64; i++) {
+			for (size_t j = 0; j < wake; j++, next = (next + 1) % n)
+				(void)send(pairs[next][1], "x", 1, 0);
+			if (x_reactor_wait(&r) <= 0)
+				break;
+			x_event *e;
+			while ((e = x_reactor_pop_event(&r))) {
+				char c;
+				if (echo)
+					(void)recv(x_container_of(e, x_evsocket, base)->sock, &c, 1, 0);
+				events++;
+			}
+		}
+	} while ((elapsed = x_time_tick() - start) < BENCH_MS);
+
+	x_reactor_free(&r);
+	for (size_t i = 0; i < n; i++) {
+		x_sock_close(pairs[i][0]);
+		x_sock_close(pairs[i][1]);
+	}
+	free(pairs);
+	free(evs);
+	return elapsed * 1e6 / events;
+}
+
+int main(void)
+{
+	static const size_t counts[] = { 1, 16, 256, 4096, 8192 };
+	struct rlimit rl;
+	getrlimit(RLIMIT_NOFILE, &rl);
+	printf("ns/event %-8s %-12s %-12s %-12s %s\n", "sockets",
+			"epoll ready", "uring ready", "epoll echo", "uring echo");
+	for (size_t i = 0; i < x_arrlen(counts); i++) {
+		size_t n = counts[i];
+		if (n * 2 + 16 > rl.rlim_cur) {
+			printf("         %-8zu skipped, RLIMIT_NOFILE %llu\n", n, (unsigned long long)rl.rlim_cur);
+			continue;
+		}
+		printf("         %-8zu %-12.1f %-12.1f %-12.1f %.1f\n", n,
+				bench(&x_sockmux_epoll, n, false), bench(&x_sockmux_uring, n, false),
+				bench(&x_sockmux_epoll, n, true), bench(&x_sockmux_uring, n, true));
+	}
+	return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Loopback echo throughput of x_rgroup with 1, 2, 4 ... N loops, N being
+ * the CPU count or the first argument. Each loop gets one client thread
+ * that keeps CONNS connections busy with MSG_SIZE byte ping-pongs, so the
+ * offered load grows with the group. Throughput should scale with the
+ * loops until the clients, which share the CPUs, become the limit.
+ */
+
+#include "x/rgroup.h"
+#include "x/thread.h"
+#include "x/memory.h"
+#include "x/atomic.h"
+#include "x/time.h"
+#include "x/sys.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_MS 1000
+#define CONNS 16
+#define MSG_SIZE 64
+
+struct conn
+{
+	x_evsocket ev;
+};
+
+static struct sockaddr_in s_addr;
+static bool s_stop;
+
+static void on_accept(x_rgroup_loop *loop, x_sock sock)
+{
+	struct conn *c = x_malloc(NULL, sizeof *c);
+	x_evsocket_init(&c->ev, sock, X_EV_READ, c);
+	if (x_reactor_add(&loop->reactor, &c->ev.base)) {
+		x_sock_close(sock);
+		x_free(c);
+	}
+}
+
+static void on_event(x_rgroup_loop *loop, x_event *e)
+{
+	struct conn *c = e->data;
+	char buf[4096];
+	ssize_t n = recv(c->ev.sock, buf, sizeof buf, 0);
+	if (n > 0) {
+		(void)send(c->ev.sock, buf, n, MSG_NOSIGNAL);
+		return;
+	}
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return;
+	x_reactor_remove(&loop->reactor, &c->ev.base);
+	x_sock_close(c->ev.sock);
+	x_free(c);
+}
+
+static int client_thread(void)
+{
+	uint64_t *rounds = x_thread_data();
+	x_sock socks[CONNS];
+	char msg[MSG_SIZE];
+	memset(msg, 'x', sizeof msg);
+	for (int i = 0; i < CONNS; i++) {
+		socks[i] = socket(AF_INET, SOCK_STREAM, 0);
+		if (connect(socks[i], (struct sockaddr *)&s_addr, sizeof s_addr)) {
+			perror("connect");
+			exit(1);
+		}
+	}
+	while (!x_atomic_load(&s_stop, X_ATOMIC_ACQUIRE)) {
+		for (int i = 0; i < CONNS; i++)
+			(void)x_sock_sendall(socks[i], msg, sizeof msg);
+		for (int i = 0; i < CONNS; i++)
+			(void)x_sock_recvall(socks[i], msg, sizeof msg);
+		*rounds += CONNS;
+	}
+	for (int i = 0; i < CONNS; i++)
+		x_sock_close(socks[i]);
+	return 0;
+}
+
+static double bench(int nloops, int dispatch)
+{
+	x_rgroup g;
+	x_thread **clients = calloc(nloops, sizeof *clients);
+	uint64_t *rounds = calloc(nloops, sizeof *rounds), total = 0;
+	socklen_t addrlen = sizeof s_addr;
+	memset(&s_addr, 0, sizeof s_addr);
+	s_addr.sin_family = AF_INET;
+	s_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (x_rgroup_init(&g, nloops, X_RGROUP_PIN, on_event, NULL)
+			|| x_rgroup_listen(&g, (struct sockaddr *)&s_addr, sizeof s_addr, dispatch, on_accept)) {
+		perror("x_rgroup");
+		exit(1);
+	}
+	getsockname(x_rgroup_loop_at(&g, 0)->listener.ev.sock, (struct sockaddr *)&s_addr, &addrlen);
+	x_rgroup_start(&g);
+
+	s_stop = false;
+	for (int i = 0; i < nloops; i++)
+		clients[i] = x_thread_create(client_thread, NULL, &rounds[i]);
+	x_thread_sleep(BENCH_MS);
+	x_atomic_store(&s_stop, true, X_ATOMIC_RELEASE);
+	for (int i = 0; i < nloops; i++) {
+		x_thread_join(clients[i], NULL);
+		x_thread_free(clients[i]);
+		total += rounds[i];
+	}
+	/* Let the loops see the hangups and release their connections */
+	x_thread_sleep(50);
+	x_rgroup_stop(&g);
+	x_rgroup_free(&g);
+	free(rounds);
+	free(clients);
+	return total * 1000.0 / BENCH_MS;
+}
+
+int main(int argc, char *argv[])
+{
+	int max = argc > 1 ? atoi(argv[1]) : x_sys_nprocs();
+	if (max <= 0)
+		max = 1;
+	printf("%-6s %-16s %s\n", "loops", "round robin/s", "reuseport/s");
+	for (int n = 1; ; n = n * 2 > max && n < max ? max : n * 2) {
+		printf("%-6d %-16.0f %.0f\n", n, bench(n, X_RGROUP_ROUND_ROBIN),
+				bench(n, X_RGROUP_REUSEPORT));
+		if (n >= max)
+			break;
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Loopback UDP packets per second through x_dgram and x_reactor. Each
+ * round sends a burst of 64-byte datagrams to a socket registered with
+ * the reactor, waits for it and receives until the socket is empty, so
+ * the numbers are the syscall and wakeup cost per packet. With a batch
+ * of 1 that is a sendmsg and a recvmsg per packet, with a batch of n
+ * a sendmmsg and a recvmmsg per n packets. The "gso" column sends each
+ * burst as one message cut into 64-byte segments and receives with GRO.
+ */
+
+#include "x/dgram.h"
+#include "x/reactor.h"
+#include "x/time.h"
+#include "x/macros.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_MS 1000
+#define PAYLOAD 64
+#define MAX_BATCH 64
+
+static x_sock udp_socket(struct sockaddr_in *addr)
+{
+	socklen_t len = sizeof *addr;
+	x_sock sock = socket(AF_INET, SOCK_DGRAM, 0);
+	memset(addr, 0, sizeof *addr);
+	addr->sin_family = AF_INET;
+	addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (sock == X_BADSOCK || bind(sock, (struct sockaddr *)addr, sizeof *addr)
+			|| getsockname(sock, (struct sockaddr *)addr, &len)
+			|| x_sock_set_nonblocking(sock)) {
+		perror("udp socket");
+		exit(1);
+	}
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *)x_p(int, 4 << 20), sizeof(int));
+	return sock;
+}
+
+static double bench(int batch, bool gso)
+{
+	static char out[MAX_BATCH * PAYLOAD], in[MAX_BATCH][MAX_BATCH * PAYLOAD];
+	x_dgram_msg send_msgs[MAX_BATCH], recv_msgs[MAX_BATCH];
+	x_dgram_iov send_iov[MAX_BATCH], recv_iov[MAX_BATCH];
+	struct sockaddr_in addr_tx, addr_rx;
+	x_sock tx = udp_socket(&addr_tx), rx = udp_socket(&addr_rx);
+	x_reactor r;
+	x_evsocket ev;
+	if (gso && x_dgram_set_gro(rx, true)) {
+		x_sock_close(tx);
+		x_sock_close(rx);
+		return 0;
+	}
+	memset(send_msgs, 0, sizeof send_msgs);
+	memset(recv_msgs, 0, sizeof recv_msgs);
+	for (int i = 0; i < MAX_BATCH; i++) {
+		x_dgram_iov_set(&send_iov[i], out + i * PAYLOAD, PAYLOAD);
+		send_msgs[i].iov = &send_iov[i];
+		send_msgs[i].iovcnt = 1;
+		send_msgs[i].addr = (struct sockaddr *)&addr_rx;
+		send_msgs[i].addrlen = sizeof addr_rx;
+		x_dgram_iov_set(&recv_iov[i], in[i], sizeof in[i]);
+		recv_msgs[i].iov = &recv_iov[i];
+		recv_msgs[i].iovcnt = 1;
+	}
+	/* A single message carrying the whole burst */
+	if (gso) {
+		x_dgram_iov_set(&send_iov[0], out, batch * PAYLOAD);
+		send_msgs[0].segment = PAYLOAD;
+	}
+	x_reactor_init(&r);
+	x_evsocket_init(&ev, rx, X_EV_READ, NULL);
+	x_reactor_add(&r, &ev.base);
+
+	uint64_t packets = 0, start = x_time_tick(), elapsed;
+	do {
+		for (int round = 0; round < 64; round++) {
+			if (x_dgram_send(tx, send_msgs, gso ? 1 : batch) <= 0)
+				break;
+			if (x_reactor_wait(&r) <= 0)
+				break;
+			while (x_reactor_pop_event(&r)) {
+				int n;
+				while ((n = x_dgram_recv(rx, recv_msgs, batch)) > 0) {
+					for (int i = 0; i < n; i++)
+						packets += recv_msgs[i].segment
+							? (recv_msgs[i].len + recv_msgs[i].segment - 1) / recv_msgs[i].segment
+							: 1;
+				}
+			}
+		}
+	} while ((elapsed = x_time_tick() - start) < BENCH_MS);
+
+	x_reactor_free(&r);
+	x_sock_close(tx);
+	x_sock_close(rx);
+	return packets * 1000.0 / elapsed;
+}
+
+int main(void)
+{
+	static const int batches[] = { 1, 8, 32, 64 };
+	printf("kpps     %-8s %-12s %s\n", "batch", "mmsg", "gso");
+	for (size_t i = 0; i < x_arrlen(batches); i++) {
+		int n = batches[i];
+		printf("         %-8d %-12.1f %.1f\n", n, bench(n, false) / 1000, bench(n, true) / 1000);
+	}
+	return 0;
+}
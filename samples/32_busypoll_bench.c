@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Round trip latency of a one-byte ping-pong between two reactor threads
+ * over a socket pair, with blocking waits and with busy polling. A blocking
+ * wait pays for the sleep and wakeup of both threads on every round, a
+ * busy polling one picks the byte up while spinning, as long as both
+ * threads have a core of their own. CPU time is for the whole process.
+ * "so_busy_poll" additionally sets SO_BUSY_POLL, which only helps sockets
+ * of NAPI capable devices, not this pair.
+ */
+
+#include "x/reactor.h"
+#include "x/thread.h"
+#include "x/time.h"
+#include "x/hist.h"
+#include "x/sys.h"
+#include "x/macros.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef X_OS_WIN32
+#define SHUT_WR SD_SEND
+#else
+#include <sys/resource.h>
+#endif
+
+#define BENCH_MS 1000
+
+struct side
+{
+	x_sock sock;
+	uint32_t busy_usec;
+};
+
+/* Waits for one byte on the socket and reads it, -1 at the end */
+static int wait_byte(x_reactor *r, x_sock sock)
+{
+	char c;
+	for (;;) {
+		if (x_reactor_wait(r) < 0)
+			return -1;
+		while (x_reactor_pop_event(r))
+			;
+		int n = recv(sock, &c, 1, 0);
+		if (n == 1)
+			return 0;
+		if (n == 0)
+			return -1;
+	}
+}
+
+static int ponger(void)
+{
+	struct side *s = x_thread_data();
+	x_reactor r;
+	x_evsocket ev;
+	x_reactor_init(&r);
+	x_reactor_set_busy_poll(&r, s->busy_usec);
+	x_evsocket_init(&ev, s->sock, X_EV_READ, NULL);
+	x_reactor_add(&r, &ev.base);
+	while (!wait_byte(&r, s->sock) && send(s->sock, "o", 1, 0) == 1)
+		;
+	x_reactor_remove(&r, &ev.base);
+	x_reactor_free(&r);
+	return 0;
+}
+
+static double cpu_sec(void)
+{
+#ifdef X_OS_WIN32
+	return 0;
+#else
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec
+		+ (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+static void bench(const char *name, uint32_t busy_usec, bool so_busy_poll)
+{
+	x_sock pair[2];
+	x_reactor r;
+	x_evsocket ev;
+	x_hist rtt;
+	if (x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair)
+			|| x_sock_set_nonblocking(pair[0]) || x_sock_set_nonblocking(pair[1])) {
+		perror("x_sock_pair");
+		exit(1);
+	}
+	if (so_busy_poll && (x_sock_set_busy_poll(pair[0], busy_usec)
+				|| x_sock_set_busy_poll(pair[1], busy_usec))) {
+		printf("%-14s SO_BUSY_POLL not available\n", name);
+		x_sock_close(pair[0]);
+		x_sock_close(pair[1]);
+		return;
+	}
+	struct side peer = { pair[1], busy_usec };
+	x_thread *t = x_thread_create(ponger, NULL, &peer);
+
+	x_reactor_init(&r);
+	x_reactor_set_busy_poll(&r, busy_usec);
+	x_evsocket_init(&ev, pair[0], X_EV_READ, NULL);
+	x_reactor_add(&r, &ev.base);
+	x_hist_init(&rtt);
+	double cpu = cpu_sec();
+	uint64_t start = x_time_nsec(), now = start;
+	while (now - start < BENCH_MS * 1000000ull) {
+		if (send(pair[0], "i", 1, 0) != 1 || wait_byte(&r, pair[0]))
+			break;
+		uint64_t sent = now;
+		now = x_time_nsec();
+		x_hist_add(&rtt, now - sent);
+	}
+	double wall = (now - start) / 1e9;
+	cpu = cpu_sec() - cpu;
+	shutdown(pair[0], SHUT_WR);
+	x_thread_join(t, NULL);
+	x_thread_free(t);
+
+	printf("%-14s %-10.1f %-10.1f %-10.1f %-10.1f %.0f%%\n", name,
+			(double)rtt.sum / rtt.count / 1000,
+			x_hist_percentile(&rtt, 50) / 1000.0,
+			x_hist_percentile(&rtt, 99) / 1000.0,
+			x_hist_percentile(&rtt, 99.9) / 1000.0,
+			cpu / wall * 100);
+	x_reactor_remove(&r, &ev.base);
+	x_reactor_free(&r);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+}
+
+int main(void)
+{
+	if (x_sys_nprocs() < 2)
+		printf("one CPU: a spinning thread keeps its peer off the core, expect busy polling to lose\n");
+	printf("usec           %-10s %-10s %-10s %-10s %s\n", "mean", "p50", "p99", "p99.9", "cpu");
+	bench("blocking", 0, false);
+	bench("busy 50us", 50, false);
+	bench("busy 1ms", 1000, false);
+	bench("so_busy_poll", 1000, true);
+	return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Fine-grained tasks through x_tpool, with the shared queue and with work
+ * stealing. "flat" adds 1M tiny tasks from the main thread. "tree" starts
+ * one task that splits into two until 2M tasks ran, so almost all work is
+ * added from the workers themselves. Threads default to the CPU count,
+ * pass another count as the first argument.
+ */
+
+#include "x/tpool.h"
+#include "x/atomic.h"
+#include "x/time.h"
+#include "x/sys.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define FLAT_TASKS (1 << 20)
+#define TREE_DEPTH 20
+
+static x_tpool *s_pool;
+static size_t s_done;
+
+static void tiny(void *arg)
+{
+	(void)arg;
+	x_atomic_fetch_add(&s_done, 1, X_ATOMIC_RELAXED);
+}
+
+static void split(void *arg)
+{
+	intptr_t depth = (intptr_t)arg;
+	x_atomic_fetch_add(&s_done, 1, X_ATOMIC_RELAXED);
+	if (depth == 0)
+		return;
+	x_tpool_add_work(s_pool, x_tpool_work_create(split, (void *)(depth - 1)));
+	x_tpool_add_work(s_pool, x_tpool_work_create(split, (void *)(depth - 1)));
+}
+
+static void bench(const char *name, int mode, size_t nthreads)
+{
+	x_tpool pool;
+	s_pool = &pool;
+	if (x_tpool_init_mode(&pool, nthreads, mode)) {
+		perror("x_tpool_init_mode");
+		exit(1);
+	}
+
+	s_done = 0;
+	uint64_t start = x_time_nsec();
+	for (int i = 0; i < FLAT_TASKS; i++)
+		x_tpool_add_work(&pool, x_tpool_work_create(tiny, NULL));
+	x_tpool_wait(&pool);
+	double flat = s_done / ((x_time_nsec() - start) / 1e9);
+
+	s_done = 0;
+	start = x_time_nsec();
+	x_tpool_add_work(&pool, x_tpool_work_create(split, (void *)(intptr_t)TREE_DEPTH));
+	x_tpool_wait(&pool);
+	double tree = s_done / ((x_time_nsec() - start) / 1e9);
+
+	printf("%-10s %-12.2f %.2f\n", name, flat / 1e6, tree / 1e6);
+	x_tpool_destroy(&pool);
+}
+
+int main(int argc, char *argv[])
+{
+	int nthreads = argc > 1 ? atoi(argv[1]) : x_sys_nprocs();
+	if (nthreads <= 0)
+		nthreads = 1;
+	printf("Mtasks/s, %d threads\n", nthreads);
+	printf("%-10s %-12s %s\n", "mode", "flat", "tree");
+	bench("shared", X_TPOOL_SHARED, nthreads);
+	bench("stealing", X_TPOOL_STEALING, nthreads);
+	return 0;
+}
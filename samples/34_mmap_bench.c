@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Allocate and free large blocks over and over, with the dynamic mmap
+ * threshold and with the threshold pinned at X_MSET_MMAP_THRESHOLD, where
+ * every cycle maps and unmaps the block. "edges" writes only the first and
+ * last byte, "full" writes the whole block.
+ */
+
+#include "x/memory.h"
+#include "x/time.h"
+#include <stdio.h>
+#include <string.h>
+
+static double cycle_ns(size_t size, bool full, int n)
+{
+	uint64_t start = x_time_nsec();
+	for (int i = 0; i < n; i++) {
+		char *p = x_malloc(NULL, size);
+		if (full)
+			memset(p, i, size);
+		else
+			p[0] = p[size - 1] = i;
+		x_free(p);
+	}
+	return (double)(x_time_nsec() - start) / n;
+}
+
+static void bench(const char *name)
+{
+	static const size_t sizes[] = { 256 << 10, 1 << 20, 4 << 20 };
+	for (size_t i = 0; i < sizeof sizes / sizeof sizes[0]; i++)
+		printf("%-8s %6zuK %12.0f %12.0f\n", name, sizes[i] >> 10,
+				cycle_ns(sizes[i], false, 100000), cycle_ns(sizes[i], true, 2000));
+}
+
+int main(void)
+{
+	printf("ns per x_malloc + x_free\n");
+	printf("%-8s %7s %12s %12s\n", "mode", "size", "edges", "full");
+	bench("dynamic");
+	x_mset_set_mmap_threshold(X_MSET_MMAP_THRESHOLD);
+	bench("pinned");
+	return 0;
+}
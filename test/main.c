@@ -31,12 +31,29 @@ int main(int argc, char *argv[])
 #ifdef TEST_REGEX
 	ADD_SUITE(regex_test);
 #endif
+#ifdef TEST_REACTOR
+	ADD_SUITE(reactor_test);
+	ADD_SUITE(rgroup_test);
+	ADD_SUITE(listener_test);
+	ADD_SUITE(bufev_test);
+	ADD_SUITE(dgram_test);
+	ADD_SUITE(fiber_test);
+#endif
 #ifdef TEST_CHARMAP
 	ADD_SUITE(charmap_test);
 #endif
 	ADD_SUITE(future_test);
 	ADD_SUITE(pathset_test);
 	ADD_SUITE(index_test);
+	ADD_SUITE(memory_test);
+	ADD_SUITE(hmap_test);
+	ADD_SUITE(chmap_test);
+	ADD_SUITE(ohmap_test);
+	ADD_SUITE(heap_test);
+	ADD_SUITE(twheel_test);
+	ADD_SUITE(mpsc_test);
+	ADD_SUITE(hist_test);
+	ADD_SUITE(tpool_test);
 
 	ut_runner_run(&r, process);
 }
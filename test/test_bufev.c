@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/bufev.h"
+#include "x/reactor.h"
+#include "x/errno.h"
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#ifdef X_OS_LINUX
+#include <unistd.h>
+#endif
+
+struct ctx {
+	int reads, writes, events;
+	short what;
+	bool echo;
+};
+
+static void on_read(x_bufev *bev, void *arg)
+{
+	struct ctx *c = arg;
+	char buf[256];
+	size_t n;
+	c->reads++;
+	if (!c->echo)
+		return;
+	while ((n = x_bufev_read(bev, buf, sizeof buf)))
+		x_bufev_write(bev, buf, n);
+}
+
+static void on_write(x_bufev *bev, void *arg)
+{
+	struct ctx *c = arg;
+	(void)bev;
+	c->writes++;
+}
+
+static void on_event(x_bufev *bev, short what, void *arg)
+{
+	struct ctx *c = arg;
+	(void)bev;
+	c->events++;
+	c->what |= what;
+}
+
+/* Wait once and dispatch, returns the number of events */
+static int step(x_reactor *reactor)
+{
+	x_event *e;
+	int n = x_reactor_wait(reactor);
+	while ((e = x_reactor_pop_event(reactor)))
+		if (e->type == X_EVENT_SOCKET)
+			x_bufev_dispatch(e);
+	return n;
+}
+
+static void bounded_wait(x_reactor *reactor, x_evtimer *timer)
+{
+	x_evtimer_init(timer, 30, X_EV_ONCE, NULL);
+	x_reactor_add(reactor, &timer->base);
+}
+
+static void echo(ut_runner *r)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_bufev bev;
+	struct ctx c = { .echo = true };
+	char buf[64];
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[0]));
+	ut_assert_int_equal(r, 0, x_bufev_init(&bev, &reactor, pair[0], 64, 64));
+	x_bufev_set_callbacks(&bev, on_read, on_write, on_event, &c);
+
+	ut_assert_int_equal(r, 5, send(pair[1], "hello", 5, 0));
+	ut_assert_int_equal(r, 6, send(pair[1], " world", 6, 0));
+	ut_assert_int_equal(r, 1, step(&reactor));
+	ut_assert_int_equal(r, 1, c.reads);
+	ut_assert_int_equal(r, 11, recv(pair[1], buf, sizeof buf, 0));
+	ut_assert(r, memcmp(buf, "hello world", 11) == 0);
+	ut_assert(r, x_pipe_is_empty(x_bufev_output(&bev)));
+
+	x_sock_close(pair[1]);
+	ut_assert_int_equal(r, 1, step(&reactor));
+	ut_assert_int_equal(r, 1, c.events);
+	ut_assert_int_equal(r, X_BUFEV_EOF, c.what);
+
+	x_bufev_free(&bev);
+	x_sock_close(pair[0]);
+	x_reactor_free(&reactor);
+}
+
+static void wrapped_ring(ut_runner *r)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_bufev bev;
+	struct ctx c = { 0 };
+	char buf[16];
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[0]));
+	ut_assert_int_equal(r, 0, x_bufev_init(&bev, &reactor, pair[0], 15, 15));
+	x_bufev_set_callbacks(&bev, on_read, on_write, on_event, &c);
+
+	/* Move the ring's start to the middle */
+	ut_assert_int_equal(r, 10, send(pair[1], "0123456789", 10, 0));
+	ut_assert_int_equal(r, 1, step(&reactor));
+	ut_assert_uint_equal(r, 10, x_bufev_drain(&bev, 10));
+
+	/* One readv fills both halves */
+	ut_assert_int_equal(r, 12, send(pair[1], "abcdefghijkl", 12, 0));
+	ut_assert_int_equal(r, 1, step(&reactor));
+	ut_assert_uint_equal(r, 12, x_pipe_data_size(x_bufev_input(&bev)));
+	ut_assert(r, x_pipe_zread_size(x_bufev_input(&bev)) < 12);
+	ut_assert_uint_equal(r, 12, x_bufev_read(&bev, buf, sizeof buf));
+	ut_assert(r, memcmp(buf, "abcdefghijkl", 12) == 0);
+
+	/* And one writev sends a wrapped output ring */
+	ut_assert_uint_equal(r, 10, x_bufev_write(&bev, "0123456789", 10));
+	ut_assert_int_equal(r, 10, recv(pair[1], buf, sizeof buf, 0));
+	ut_assert_uint_equal(r, 12, x_bufev_write(&bev, "abcdefghijkl", 12));
+	ut_assert(r, x_pipe_is_empty(x_bufev_output(&bev)));
+	ut_assert_int_equal(r, 12, recv(pair[1], buf, sizeof buf, 0));
+	ut_assert(r, memcmp(buf, "abcdefghijkl", 12) == 0);
+
+	x_bufev_free(&bev);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+static void watermarks(ut_runner *r)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_bufev bev;
+	x_evtimer timer;
+	struct ctx c = { 0 };
+	char buf[32];
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[0]));
+	ut_assert_int_equal(r, 0, x_bufev_init(&bev, &reactor, pair[0], 64, 64));
+	x_bufev_set_callbacks(&bev, on_read, on_write, on_event, &c);
+	x_bufev_set_watermark(&bev, X_EV_READ, 4, 8);
+
+	/* Below the low watermark nothing is reported */
+	ut_assert_int_equal(r, 2, send(pair[1], "ab", 2, 0));
+	ut_assert_int_equal(r, 1, step(&reactor));
+	ut_assert_int_equal(r, 0, c.reads);
+
+	/* Reading stops at the high watermark */
+	ut_assert_int_equal(r, 18, send(pair[1], "cdefghijklmnopqrst", 18, 0));
+	ut_assert_int_equal(r, 1, step(&reactor));
+	ut_assert_int_equal(r, 1, c.reads);
+	ut_assert_uint_equal(r, 8, x_pipe_data_size(x_bufev_input(&bev)));
+	bounded_wait(&reactor, &timer);
+	ut_assert_int_equal(r, 1, step(&reactor));
+	ut_assert_int_equal(r, 1, c.reads);
+
+	/* Consuming resumes it */
+	ut_assert_uint_equal(r, 8, x_bufev_read(&bev, buf, sizeof buf));
+	ut_assert(r, memcmp(buf, "abcdefgh", 8) == 0);
+	ut_assert_int_equal(r, 1, step(&reactor));
+	ut_assert_int_equal(r, 2, c.reads);
+	ut_assert_uint_equal(r, 8, x_bufev_read(&bev, buf, sizeof buf));
+	ut_assert(r, memcmp(buf, "ijklmnop", 8) == 0);
+
+	x_bufev_free(&bev);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+static void backpressure(ut_runner *r)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_bufev bev;
+	struct ctx c = { 0 };
+	static char data[1 << 20], got[1 << 20];
+	size_t received = 0;
+	for (size_t i = 0; i < sizeof data; i++)
+		data[i] = (char)(i * 7);
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[0]));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[1]));
+	ut_assert_int_equal(r, 0, x_bufev_init(&bev, &reactor, pair[0], 64, sizeof data));
+	x_bufev_set_callbacks(&bev, on_read, on_write, on_event, &c);
+
+	/* More than the socket takes, the rest waits for writability */
+	ut_assert_uint_equal(r, sizeof data, x_bufev_write(&bev, data, sizeof data));
+	ut_assert(r, !x_pipe_is_empty(x_bufev_output(&bev)));
+	ut_assert(r, bev.ev.base.ev_flags & X_EV_WRITE);
+	while (received < sizeof data) {
+		ssize_t n;
+		while ((n = recv(pair[1], got + received, sizeof got - received, 0)) > 0)
+			received += n;
+		if (received < sizeof data)
+			ut_assert(r, step(&reactor) > 0);
+	}
+	ut_assert(r, memcmp(data, got, sizeof data) == 0);
+	ut_assert(r, c.writes > 0);
+	ut_assert(r, !(bev.ev.base.ev_flags & X_EV_WRITE));
+	ut_assert_int_equal(r, 0, c.events);
+
+	x_bufev_free(&bev);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+/* Steps until the peer got size bytes and the transfer was reported */
+static size_t sendfile_drive(ut_runner *r, x_reactor *reactor, x_sock peer, struct ctx *c,
+		char *got, size_t size, int *steps)
+{
+	size_t received = 0;
+	for (*steps = 0; *steps < 10000; (*steps)++) {
+		ssize_t n;
+		while ((n = recv(peer, got + received, size - received, 0)) > 0)
+			received += n;
+		if (received == size && (c->what & X_BUFEV_SENDFILE))
+			break;
+		ut_assert(r, step(reactor) > 0);
+	}
+	return received;
+}
+
+static void sendfile_file(ut_runner *r)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_bufev bev;
+	struct ctx c = { 0 };
+	static char data[300000], got[200000];
+	const size_t offset = 1000, length = 150000;
+	int steps;
+	for (size_t i = 0; i < sizeof data; i++)
+		data[i] = (char)(i * 13);
+	FILE *fp = tmpfile();
+	ut_assert(r, fp != NULL);
+	ut_assert_uint_equal(r, sizeof data, fwrite(data, 1, sizeof data, fp));
+	fflush(fp);
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[0]));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[1]));
+	ut_assert_int_equal(r, 0, x_bufev_init(&bev, &reactor, pair[0], 64, 64));
+	x_bufev_set_callbacks(&bev, on_read, on_write, on_event, &c);
+
+	/* Output written before and after the file keeps its place */
+	x_bufev_write(&bev, "head", 4);
+	ut_assert_int_equal(r, 0, x_bufev_sendfile(&bev, fileno(fp), offset, length));
+	ut_assert_int_equal(r, -1, x_bufev_sendfile(&bev, fileno(fp), 0, 1));
+	ut_assert_int_equal(r, X_EBUSY, errno);
+	x_bufev_write(&bev, "tail", 4);
+	ut_assert_uint_equal(r, 4 + length + 4, sendfile_drive(r, &reactor, pair[1], &c, got, 4 + length + 4, &steps));
+	ut_assert(r, memcmp(got, "head", 4) == 0);
+	ut_assert(r, memcmp(got + 4, data + offset, length) == 0);
+	ut_assert(r, memcmp(got + 4 + length, "tail", 4) == 0);
+	ut_assert_int_equal(r, 1, c.events);
+	ut_assert_int_equal(r, X_BUFEV_SENDFILE, c.what);
+
+	/* Past the end of the file it completes with what there is */
+	c.what = 0;
+	ut_assert_int_equal(r, 0, x_bufev_sendfile(&bev, fileno(fp), sizeof data - 10, 100));
+	ut_assert_uint_equal(r, 10, sendfile_drive(r, &reactor, pair[1], &c, got, 10, &steps));
+	ut_assert(r, memcmp(got, data + sizeof data - 10, 10) == 0);
+	ut_assert_int_equal(r, X_BUFEV_SENDFILE, c.what);
+	ut_assert(r, !(bev.ev.base.ev_flags & X_EV_WRITE));
+
+	x_bufev_free(&bev);
+	fclose(fp);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+#ifdef X_OS_LINUX
+static void sendfile_pipe(ut_runner *r)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_bufev bev;
+	struct ctx c = { 0 };
+	int fds[2], steps;
+	char got[3000];
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[0]));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(pair[1]));
+	ut_assert_int_equal(r, 0, pipe(fds));
+	ut_assert_int_equal(r, 0, x_bufev_init(&bev, &reactor, pair[0], 64, 64));
+	x_bufev_set_callbacks(&bev, on_read, on_write, on_event, &c);
+
+	/* The pipe runs dry half way, the transfer waits for it */
+	ut_assert_int_equal(r, 1000, write(fds[1], memset(got, 'a', 1000), 1000));
+	ut_assert_int_equal(r, 0, x_bufev_sendfile(&bev, fds[0], 0, sizeof got));
+	ut_assert_int_equal(r, 1000, recv(pair[1], got, sizeof got, 0));
+	ut_assert(r, bev.xfer_wait_src);
+	ut_assert(r, !(bev.ev.base.ev_flags & X_EV_WRITE));
+	ut_assert_int_equal(r, 2000, write(fds[1], memset(got, 'b', 2000), 2000));
+	ut_assert_uint_equal(r, 2000, sendfile_drive(r, &reactor, pair[1], &c, got, 2000, &steps));
+	ut_assert(r, steps < 10);
+	ut_assert(r, got[0] == 'b' && got[1999] == 'b');
+	ut_assert_int_equal(r, X_BUFEV_SENDFILE, c.what);
+
+	x_bufev_free(&bev);
+	close(fds[0]);
+	close(fds[1]);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+#endif
+
+void bufev_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "bufev.h");
+	ut_suite_add(s, echo);
+	ut_suite_add(s, wrapped_ring);
+	ut_suite_add(s, watermarks);
+	ut_suite_add(s, backpressure);
+	ut_suite_add(s, sendfile_file);
+#ifdef X_OS_LINUX
+	ut_suite_add(s, sendfile_pipe);
+#endif
+}
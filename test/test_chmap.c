@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/chmap.h"
+#include "x/list.h"
+#include "x/thread.h"
+#include "x/macros.h"
+#include <stdlib.h>
+
+#define NELEMS 20000
+#define NREADERS 3
+
+struct elem {
+	x_link link;
+	size_t key;
+};
+
+static x_chmap s_map;
+static struct elem *s_elems;
+static volatile bool s_stop;
+
+static size_t elem_hash(const x_link *link)
+{
+	return x_container_of(link, struct elem, link)->key;
+}
+
+static bool elem_equal(const x_link *l1, const x_link *l2)
+{
+	return x_container_of(l1, struct elem, link)->key
+		== x_container_of(l2, struct elem, link)->key;
+}
+
+static void basic(ut_runner *r)
+{
+	x_chmap cm;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_chmap_init(&cm, 4, 0.75, elem_hash, elem_equal);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = i;
+		ut_assert(r, x_chmap_find_or_insert(&cm, &elems[i].link) == NULL);
+	}
+	ut_assert_uint_equal(r, NELEMS, x_chmap_count(&cm));
+	for (size_t i = 0; i < NELEMS; i++) {
+		struct elem key = { .key = i };
+		ut_assert(r, x_chmap_find(&cm, &key.link) == &elems[i].link);
+	}
+
+	struct elem dup = { .key = 7 };
+	ut_assert(r, x_chmap_find_or_insert(&cm, &dup.link) == &elems[7].link);
+	ut_assert(r, x_chmap_replace_or_insert(&cm, &dup.link) == &elems[7].link);
+	ut_assert(r, x_chmap_find(&cm, &elems[7].link) == &dup.link);
+
+	for (size_t i = 0; i < NELEMS; i += 2)
+		ut_assert(r, x_chmap_find_and_remove(&cm, &elems[i].link) != NULL);
+	for (size_t i = 1; i < NELEMS; i += 2)
+		x_chmap_remove(&cm, &elems[i].link);
+	ut_assert_uint_equal(r, 0, x_chmap_count(&cm));
+	x_chmap_free(&cm);
+	free(elems);
+}
+
+static int reader_thread(void)
+{
+	size_t i = 0, misses = 0;
+	while (!s_stop) {
+		/* Odd keys are never removed, even keys come and go */
+		struct elem key = { .key = (i++ % NELEMS) | 1 };
+		x_chmap_read_enter();
+		x_link *found = x_chmap_find(&s_map, &key.link);
+		if (!found || x_container_of(found, struct elem, link)->key != key.key)
+			misses++;
+		x_chmap_read_leave();
+	}
+	return misses ? -1 : 0;
+}
+
+static void concurrent(ut_runner *r)
+{
+	x_thread *thds[NREADERS];
+	s_elems = calloc(NELEMS, sizeof *s_elems);
+	s_stop = false;
+	x_chmap_init(&s_map, 2, 0.75, elem_hash, elem_equal);
+	for (size_t i = 1; i < NELEMS; i += 2) {
+		s_elems[i].key = i;
+		x_chmap_find_or_insert(&s_map, &s_elems[i].link);
+	}
+	for (int i = 0; i < NREADERS; i++)
+		thds[i] = x_thread_create(reader_thread, NULL, NULL);
+
+	/* Even keys are inserted and removed while readers run, forcing the
+	 * shards to grow under them */
+	for (int round = 0; round < 4; round++) {
+		for (size_t i = 0; i < NELEMS; i += 2) {
+			s_elems[i].key = i;
+			x_chmap_find_or_insert(&s_map, &s_elems[i].link);
+		}
+		for (size_t i = 0; i < NELEMS; i += 2)
+			x_chmap_remove(&s_map, &s_elems[i].link);
+		x_chmap_synchronize();
+	}
+	s_stop = true;
+	for (int i = 0; i < NREADERS; i++) {
+		int retval = -1;
+		x_thread_join(thds[i], &retval);
+		x_thread_free(thds[i]);
+		ut_assert_int_equal(r, 0, retval);
+	}
+	ut_assert_uint_equal(r, NELEMS / 2, x_chmap_count(&s_map));
+	x_chmap_free(&s_map);
+	free(s_elems);
+}
+
+void chmap_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "chmap.h");
+	ut_suite_add(s, basic);
+	ut_suite_add(s, concurrent);
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/dgram.h"
+#include "x/errno.h"
+#include <string.h>
+#include <errno.h>
+
+#define NMSGS 8
+
+/* A UDP socket on an ephemeral loopback port */
+static x_sock udp_socket(struct sockaddr_in *addr)
+{
+	socklen_t len = sizeof *addr;
+	x_sock sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock == X_BADSOCK)
+		return X_BADSOCK;
+	memset(addr, 0, sizeof *addr);
+	addr->sin_family = AF_INET;
+	addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(sock, (struct sockaddr *)addr, sizeof *addr)
+			|| getsockname(sock, (struct sockaddr *)addr, &len)
+			|| x_sock_set_nonblocking(sock)) {
+		x_sock_close(sock);
+		return X_BADSOCK;
+	}
+	return sock;
+}
+
+static void batches(ut_runner *r)
+{
+	struct sockaddr_in addr_a, addr_b, from[NMSGS];
+	x_dgram_msg msgs[NMSGS];
+	x_dgram_iov iov[NMSGS][2];
+	char out[NMSGS][16], head[NMSGS][4], body[NMSGS][16];
+	x_sock a = udp_socket(&addr_a), b = udp_socket(&addr_b);
+	ut_assert(r, a != X_BADSOCK && b != X_BADSOCK);
+
+	/* Nothing queued yet */
+	memset(msgs, 0, sizeof msgs);
+	for (int i = 0; i < NMSGS; i++) {
+		x_dgram_iov_set(&iov[i][0], body[i], sizeof body[i]);
+		msgs[i].iov = iov[i];
+		msgs[i].iovcnt = 1;
+	}
+	ut_assert_int_equal(r, -1, x_dgram_recv(b, msgs, NMSGS));
+	ut_assert(r, errno == X_EAGAIN || errno == X_EWOULDBLOCK);
+
+	/* Gathered from one buffer each, addressed per message */
+	memset(msgs, 0, sizeof msgs);
+	for (int i = 0; i < NMSGS; i++) {
+		memset(out[i], 'a' + i, sizeof out[i]);
+		x_dgram_iov_set(&iov[i][0], out[i], 4 + i);
+		msgs[i].iov = iov[i];
+		msgs[i].iovcnt = 1;
+		msgs[i].addr = (struct sockaddr *)&addr_b;
+		msgs[i].addrlen = sizeof addr_b;
+	}
+	ut_assert_int_equal(r, NMSGS, x_dgram_send(a, msgs, NMSGS));
+	for (int i = 0; i < NMSGS; i++)
+		ut_assert_uint_equal(r, 4 + i, msgs[i].len);
+
+	/* Scattered into two, the last one does not fit */
+	memset(msgs, 0, sizeof msgs);
+	for (int i = 0; i < NMSGS; i++) {
+		x_dgram_iov_set(&iov[i][0], head[i], sizeof head[i]);
+		x_dgram_iov_set(&iov[i][1], body[i], i == NMSGS - 1 ? 2 : sizeof body[i]);
+		msgs[i].iov = iov[i];
+		msgs[i].iovcnt = 2;
+		msgs[i].addr = (struct sockaddr *)&from[i];
+		msgs[i].addrlen = sizeof from[i];
+	}
+	x_sock wait[1] = { b };
+	ut_assert_int_equal(r, 0, x_sock_wait_readable(wait, 1, 1000));
+	int n = 0, ret;
+	while (n < NMSGS && (ret = x_dgram_recv(b, msgs + n, NMSGS - n)) > 0)
+		n += ret;
+	ut_assert_int_equal(r, NMSGS, n);
+	for (int i = 0; i < NMSGS; i++) {
+		ut_assert(r, memcmp(head[i], out[i], 4) == 0);
+		ut_assert(r, memcmp(body[i], out[i], i == NMSGS - 1 ? 2 : (size_t)i) == 0);
+		ut_assert(r, from[i].sin_port == addr_a.sin_port);
+		ut_assert_int_equal(r, i == NMSGS - 1, msgs[i].truncated);
+		ut_assert_int_equal(r, 0, msgs[i].segment);
+	}
+
+	x_sock_close(a);
+	x_sock_close(b);
+}
+
+#ifdef X_OS_LINUX
+static void segmentation(ut_runner *r)
+{
+	struct sockaddr_in addr_a, addr_b;
+	x_dgram_msg msg, in[16];
+	x_dgram_iov iov, iov_in[16];
+	static char out[1000], buf[16][1000];
+	x_sock a = udp_socket(&addr_a), b = udp_socket(&addr_b);
+	ut_assert(r, a != X_BADSOCK && b != X_BADSOCK);
+	for (size_t i = 0; i < sizeof out; i++)
+		out[i] = (char)i;
+
+	/* One send of 1000 bytes in datagrams of 100 */
+	memset(&msg, 0, sizeof msg);
+	x_dgram_iov_set(&iov, out, sizeof out);
+	msg.iov = &iov;
+	msg.iovcnt = 1;
+	msg.addr = (struct sockaddr *)&addr_b;
+	msg.addrlen = sizeof addr_b;
+	msg.segment = 100;
+	if (x_dgram_send(a, &msg, 1) != 1) {
+		/* Kernel without UDP_SEGMENT */
+		x_sock_close(a);
+		x_sock_close(b);
+		return;
+	}
+	memset(in, 0, sizeof in);
+	for (int i = 0; i < 16; i++) {
+		x_dgram_iov_set(&iov_in[i], buf[i], sizeof buf[i]);
+		in[i].iov = &iov_in[i];
+		in[i].iovcnt = 1;
+	}
+	x_sock wait[1] = { b };
+	ut_assert_int_equal(r, 0, x_sock_wait_readable(wait, 1, 1000));
+	int n = 0, ret;
+	while (n < 10 && (ret = x_dgram_recv(b, in + n, 16 - n)) > 0)
+		n += ret;
+	ut_assert_int_equal(r, 10, n);
+	for (int i = 0; i < 10; i++) {
+		ut_assert_uint_equal(r, 100, in[i].len);
+		ut_assert(r, memcmp(buf[i], out + i * 100, 100) == 0);
+	}
+
+	/* With GRO they may come back as one message */
+	ut_assert_int_equal(r, 0, x_dgram_set_gro(b, true));
+	ut_assert_int_equal(r, 1, x_dgram_send(a, &msg, 1));
+	ut_assert_int_equal(r, 0, x_sock_wait_readable(wait, 1, 1000));
+	size_t total = 0;
+	n = 0;
+	while (total < sizeof out && (ret = x_dgram_recv(b, in + n, 16 - n)) > 0) {
+		for (int i = n; i < n + ret; i++) {
+			ut_assert(r, memcmp(buf[i], out + total, in[i].len) == 0);
+			ut_assert(r, in[i].segment == 0 || in[i].segment == 100);
+			total += in[i].len;
+		}
+		n += ret;
+	}
+	ut_assert_uint_equal(r, sizeof out, total);
+
+	x_sock_close(a);
+	x_sock_close(b);
+}
+#endif
+
+void dgram_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "dgram.h");
+	ut_suite_add(s, batches);
+#ifdef X_OS_LINUX
+	ut_suite_add(s, segmentation);
+#endif
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/fiber.h"
+#include "x/reactor.h"
+#include "x/socket.h"
+#include "x/errno.h"
+#include <string.h>
+#include <errno.h>
+
+#define NCLIENTS 16
+
+struct trace
+{
+	char log[32];
+	int len;
+};
+
+static void yielder(x_fiber *self, void *arg)
+{
+	struct trace *t = arg;
+	char c = t->len ? 'b' : 'a';
+	for (int i = 0; i < 3; i++) {
+		t->log[t->len++] = c;
+		x_fiber_yield(self);
+	}
+}
+
+static void sleeper(x_fiber *self, void *arg)
+{
+	struct trace *t = arg;
+	int msec = t->len++ ? 10 : 30;
+	x_fiber_sleep(self, msec);
+	t->log[t->len++] = msec == 10 ? 's' : 'l';
+}
+
+static void switches(ut_runner *r)
+{
+	x_reactor reactor;
+	x_fiber_sched s;
+	struct trace t = { .len = 0 };
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_fiber_sched_init(&s, &reactor, 0));
+
+	/* Yielding fibers take turns */
+	ut_assert(r, x_fiber_spawn(&s, yielder, &t) != NULL);
+	ut_assert(r, x_fiber_spawn(&s, yielder, &t) != NULL);
+	ut_assert_int_equal(r, 0, x_fiber_sched_run(&s));
+	ut_assert_int_equal(r, 6, t.len);
+	ut_assert(r, memcmp(t.log, "ababab", 6) == 0);
+
+	/* Sleepers wake in order of their deadline, on recycled fibers */
+	t.len = 0;
+	ut_assert(r, x_fiber_spawn(&s, sleeper, &t) != NULL);
+	ut_assert(r, x_fiber_spawn(&s, sleeper, &t) != NULL);
+	ut_assert_uint_equal(r, 0, s.cache_cnt);
+	ut_assert_int_equal(r, 0, x_fiber_sched_run(&s));
+	ut_assert_int_equal(r, 4, t.len);
+	ut_assert(r, t.log[2] == 's' && t.log[3] == 'l');
+	ut_assert_uint_equal(r, 2, s.cache_cnt);
+
+	x_fiber_sched_free(&s);
+	x_reactor_free(&reactor);
+}
+
+struct server
+{
+	x_sock listener;
+	struct sockaddr_in addr;
+	int served;
+	int passed;
+	int timeouts;
+};
+
+static void echo(x_fiber *self, void *arg)
+{
+	x_sock sock = (x_sock)(intptr_t)arg;
+	char buf[256];
+	int n;
+	while ((n = x_fiber_recv(self, sock, buf, sizeof buf, -1)) > 0)
+		if (x_fiber_send(self, sock, buf, n, -1))
+			break;
+	x_fiber_close(self, sock);
+}
+
+static void acceptor(x_fiber *self, void *arg)
+{
+	struct server *srv = arg;
+	while (srv->served < NCLIENTS) {
+		x_sock sock = x_fiber_accept(self, srv->listener, NULL, NULL, 1000);
+		if (sock == X_BADSOCK)
+			break;
+		srv->served++;
+		x_fiber_spawn(x_fiber_sched_of(self), echo, (void *)(intptr_t)sock);
+	}
+}
+
+static void client(x_fiber *self, void *arg)
+{
+	struct server *srv = arg;
+	char out[4096], in[4096];
+	size_t got = 0;
+	x_sock sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (sock == X_BADSOCK || x_sock_set_nonblocking(sock)
+			|| x_fiber_connect(self, sock, (struct sockaddr *)&srv->addr, sizeof srv->addr, 1000))
+		goto out;
+	/* Nothing was sent yet, so nothing comes back in time */
+	if (x_fiber_recv(self, sock, in, sizeof in, 10) == -1 && errno == X_ETIMEDOUT)
+		srv->timeouts++;
+	for (size_t i = 0; i < sizeof out; i++)
+		out[i] = (char)(i * 7 + srv->passed);
+	if (x_fiber_send(self, sock, out, sizeof out, 1000))
+		goto out;
+	while (got < sizeof in) {
+		int n = x_fiber_recv(self, sock, in + got, sizeof in - got, 1000);
+		if (n <= 0)
+			goto out;
+		got += n;
+	}
+	if (memcmp(in, out, sizeof out) == 0)
+		srv->passed++;
+out:
+	if (sock != X_BADSOCK)
+		x_fiber_close(self, sock);
+}
+
+static void sockets(ut_runner *r)
+{
+	x_reactor reactor;
+	x_fiber_sched s;
+	struct server srv = { .served = 0, .passed = 0, .timeouts = 0 };
+	socklen_t len = sizeof srv.addr;
+	srv.listener = socket(AF_INET, SOCK_STREAM, 0);
+	ut_assert(r, srv.listener != X_BADSOCK);
+	memset(&srv.addr, 0, sizeof srv.addr);
+	srv.addr.sin_family = AF_INET;
+	srv.addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	ut_assert_int_equal(r, 0, bind(srv.listener, (struct sockaddr *)&srv.addr, sizeof srv.addr));
+	ut_assert_int_equal(r, 0, getsockname(srv.listener, (struct sockaddr *)&srv.addr, &len));
+	ut_assert_int_equal(r, 0, listen(srv.listener, NCLIENTS));
+	ut_assert_int_equal(r, 0, x_sock_set_nonblocking(srv.listener));
+
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_fiber_sched_init(&s, &reactor, 0));
+	ut_assert(r, x_fiber_spawn(&s, acceptor, &srv) != NULL);
+	for (int i = 0; i < NCLIENTS; i++)
+		ut_assert(r, x_fiber_spawn(&s, client, &srv) != NULL);
+	ut_assert_int_equal(r, 0, x_fiber_sched_run(&s));
+	ut_assert_int_equal(r, NCLIENTS, srv.served);
+	ut_assert_int_equal(r, NCLIENTS, srv.timeouts);
+	ut_assert_int_equal(r, NCLIENTS, srv.passed);
+
+	x_fiber_sched_free(&s);
+	x_reactor_free(&reactor);
+	x_sock_close(srv.listener);
+}
+
+void fiber_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "fiber.h");
+	ut_suite_add(s, switches);
+	ut_suite_add(s, sockets);
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/heap.h"
+#include "x/macros.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+#define NELEMS 5000
+
+struct elem {
+	x_ranode node;
+	uint64_t key;
+};
+
+static bool elem_ordered(const x_ranode *n1, const x_ranode *n2)
+{
+	return x_container_of(n1, struct elem, node)->key
+		<= x_container_of(n2, struct elem, node)->key;
+}
+
+static uint64_t scramble(size_t i)
+{
+	return (i * 2654435761u) % 100003;
+}
+
+static void heap_pop_index(ut_runner *r)
+{
+	x_heap h;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_heap_init(&h, elem_ordered);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = scramble(i);
+		x_heap_push(&h, &elems[i].node);
+	}
+	for (size_t i = 0; i < NELEMS / 2; i++)
+		x_heap_pop(&h);
+	for (size_t i = 0; i < h.entry_cnt; i++)
+		ut_assert_uint_equal(r, i, h.table[i]->index);
+	x_heap_free(&h);
+	free(elems);
+}
+
+static void dheap_order(ut_runner *r)
+{
+	x_dheap h;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_dheap_init(&h);
+	ut_assert(r, x_dheap_top(&h, NULL) == NULL);
+	ut_assert(r, x_dheap_pop(&h, NULL) == NULL);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = scramble(i);
+		x_dheap_push(&h, &elems[i].node, elems[i].key);
+	}
+	ut_assert_uint_equal(r, NELEMS, x_dheap_size(&h));
+	for (size_t i = 0; i < h.entry_cnt; i++)
+		ut_assert_uint_equal(r, i, h.table[i].node->index);
+
+	uint64_t prev = 0, key;
+	x_ranode *n;
+	size_t cnt = 0;
+	while ((n = x_dheap_pop(&h, &key))) {
+		struct elem *e = x_container_of(n, struct elem, node);
+		ut_assert_uint_equal(r, e->key, key);
+		ut_assert(r, prev <= key);
+		ut_assert_uint_equal(r, SIZE_MAX, n->index);
+		prev = key;
+		cnt++;
+	}
+	ut_assert_uint_equal(r, NELEMS, cnt);
+	x_dheap_free(&h);
+	free(elems);
+}
+
+static void dheap_remove_update(ut_runner *r)
+{
+	x_dheap h;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_dheap_init(&h);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = scramble(i);
+		x_dheap_push(&h, &elems[i].node, elems[i].key);
+	}
+	for (size_t i = 0; i < NELEMS; i += 3)
+		x_dheap_remove(&h, &elems[i].node);
+	for (size_t i = 1; i < NELEMS; i += 3) {
+		elems[i].key = (i & 2) ? elems[i].key / 2 : elems[i].key + 100003;
+		x_dheap_update(&h, &elems[i].node, elems[i].key);
+		ut_assert_uint_equal(r, elems[i].key, x_dheap_key(&h, &elems[i].node));
+	}
+	ut_assert_uint_equal(r, NELEMS - (NELEMS + 2) / 3, x_dheap_size(&h));
+
+	uint64_t prev = 0, key;
+	x_ranode *n;
+	while ((n = x_dheap_pop(&h, &key))) {
+		struct elem *e = x_container_of(n, struct elem, node);
+		ut_assert(r, (e - elems) % 3 != 0);
+		ut_assert_uint_equal(r, e->key, key);
+		ut_assert(r, prev <= key);
+		prev = key;
+	}
+	x_dheap_free(&h);
+	free(elems);
+}
+
+static void dheap_build(ut_runner *r)
+{
+	x_dheap h;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_ranode **nodes = calloc(NELEMS, sizeof *nodes);
+	uint64_t *keys = calloc(NELEMS, sizeof *keys);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = keys[i] = scramble(i);
+		nodes[i] = &elems[i].node;
+	}
+	x_dheap_init(&h);
+	x_dheap_push(&h, &elems[0].node, elems[0].key);
+	x_dheap_build(&h, nodes + 1, keys + 1, NELEMS - 1);
+	ut_assert_uint_equal(r, NELEMS, x_dheap_size(&h));
+	for (size_t i = 1; i < h.entry_cnt; i++) {
+		ut_assert(r, h.table[(i - 1) / X_DHEAP_ARITY].key <= h.table[i].key);
+		ut_assert_uint_equal(r, i, h.table[i].node->index);
+	}
+
+	uint64_t prev = 0, key;
+	size_t cnt = 0;
+	while (x_dheap_pop(&h, &key)) {
+		ut_assert(r, prev <= key);
+		prev = key;
+		cnt++;
+	}
+	ut_assert_uint_equal(r, NELEMS, cnt);
+	x_dheap_free(&h);
+	free(keys);
+	free(nodes);
+	free(elems);
+}
+
+static void dheap_reuse(ut_runner *r)
+{
+	x_dheap h;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_ranode **nodes = calloc(NELEMS, sizeof *nodes);
+	uint64_t *keys = calloc(NELEMS, sizeof *keys);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = keys[i] = scramble(i);
+		nodes[i] = &elems[i].node;
+	}
+	x_dheap_init(&h);
+	x_dheap_free(&h);
+	for (size_t i = 0; i < NELEMS; i++)
+		x_dheap_push(&h, &elems[i].node, elems[i].key);
+	ut_assert_uint_equal(r, NELEMS, x_dheap_size(&h));
+	x_dheap_free(&h);
+	ut_assert_uint_equal(r, 0, x_dheap_size(&h));
+
+	x_dheap_build(&h, nodes, keys, NELEMS);
+	uint64_t prev = 0, key;
+	size_t cnt = 0;
+	while (x_dheap_pop(&h, &key)) {
+		ut_assert(r, prev <= key);
+		prev = key;
+		cnt++;
+	}
+	ut_assert_uint_equal(r, NELEMS, cnt);
+	x_dheap_free(&h);
+	free(keys);
+	free(nodes);
+	free(elems);
+}
+
+void heap_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "heap.h");
+	ut_suite_add(s, heap_pop_index);
+	ut_suite_add(s, dheap_order);
+	ut_suite_add(s, dheap_remove_update);
+	ut_suite_add(s, dheap_build);
+	ut_suite_add(s, dheap_reuse);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/hist.h"
+
+static void buckets(ut_runner *r)
+{
+	/* Every value falls into a bucket whose range covers it */
+	uint64_t values[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 100, 1000, 123456789, UINT64_MAX };
+	for (size_t i = 0; i < sizeof values / sizeof values[0]; i++) {
+		unsigned idx = x_hist_index(values[i]);
+		ut_assert(r, idx < X_HIST_BUCKETS);
+		ut_assert(r, values[i] <= x_hist_bucket_max(idx));
+		if (idx > 0)
+			ut_assert(r, values[i] > x_hist_bucket_max(idx - 1));
+	}
+	ut_assert(r, x_hist_index(UINT64_MAX) == X_HIST_BUCKETS - 1);
+	ut_assert(r, x_hist_bucket_max(X_HIST_BUCKETS - 1) == UINT64_MAX);
+}
+
+static void percentiles(ut_runner *r)
+{
+	x_hist h;
+	x_hist_init(&h);
+	ut_assert(r, x_hist_percentile(&h, 50) == 0);
+	for (uint64_t v = 1; v <= 1000; v++)
+		x_hist_add(&h, v);
+	ut_assert(r, h.count == 1000);
+	ut_assert(r, h.sum == 500500);
+	ut_assert(r, h.min == 1);
+	ut_assert(r, h.max == 1000);
+
+	/* Within the 25% a bucket spans */
+	uint64_t p50 = x_hist_percentile(&h, 50), p99 = x_hist_percentile(&h, 99);
+	ut_assert(r, p50 >= 500 && p50 <= 625);
+	ut_assert(r, p99 >= 990 && p99 <= 1000);
+	ut_assert(r, x_hist_percentile(&h, 100) == 1000);
+	ut_assert(r, x_hist_percentile(&h, 0) == 1);
+
+	x_hist h2;
+	x_hist_init(&h2);
+	x_hist_add(&h2, 5000);
+	x_hist_merge(&h, &h2);
+	ut_assert(r, h.count == 1001);
+	ut_assert(r, h.max == 5000);
+	ut_assert(r, h.min == 1);
+	ut_assert(r, x_hist_percentile(&h, 100) == 5000);
+}
+
+void hist_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "hist.h");
+	ut_suite_add(s, buckets);
+	ut_suite_add(s, percentiles);
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/hmap.h"
+#include "x/list.h"
+#include "x/macros.h"
+#include "x/string.h"
+#include <stdlib.h>
+
+#define NELEMS 20000
+
+struct elem {
+	x_link link;
+	size_t key;
+};
+
+static size_t elem_hash(const x_link *link)
+{
+	return x_container_of(link, struct elem, link)->key;
+}
+
+static bool elem_equal(const x_link *l1, const x_link *l2)
+{
+	return x_container_of(l1, struct elem, link)->key
+		== x_container_of(l2, struct elem, link)->key;
+}
+
+static void check_all(ut_runner *r, x_hmap *ht, struct elem *elems, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		struct elem key = { .key = elems[i].key };
+		ut_assert(r, x_hmap_find(ht, &key.link) == &elems[i].link);
+	}
+}
+
+static void incremental(ut_runner *r)
+{
+	x_hmap ht;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_hmap_init(&ht, 0.75, elem_hash, elem_equal);
+	x_hmap_set_incremental(&ht, true);
+
+	bool migrating = false;
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = i * 3;
+		ut_assert(r, x_hmap_find_or_insert(&ht, &elems[i].link) == NULL);
+		migrating = migrating || ht.old_table;
+		if (i % 1000 == 0)
+			check_all(r, &ht, elems, i + 1);
+	}
+	ut_assert(r, migrating);
+	ut_assert_uint_equal(r, NELEMS, ht.elem_cnt);
+	check_all(r, &ht, elems, NELEMS);
+
+	for (size_t i = 0; i < NELEMS; i += 2)
+		x_hmap_remove(&ht, &elems[i].link);
+	for (size_t i = 1; i < NELEMS; i += 2) {
+		struct elem key = { .key = elems[i].key };
+		ut_assert(r, x_hmap_find_and_remove(&ht, &key.link) == &elems[i].link);
+	}
+	ut_assert_uint_equal(r, 0, ht.elem_cnt);
+	ut_assert(r, ht.old_table == NULL);
+	x_hmap_free(&ht);
+	free(elems);
+}
+
+static void reserve(ut_runner *r)
+{
+	x_hmap ht;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_hmap_init(&ht, 0.75, elem_hash, elem_equal);
+	x_hmap_set_incremental(&ht, true);
+	for (size_t i = 0; i < NELEMS / 2; i++) {
+		elems[i].key = i;
+		x_hmap_find_or_insert(&ht, &elems[i].link);
+	}
+	x_hmap_reserve(&ht, NELEMS);
+	ut_assert(r, ht.old_table == NULL);
+	ut_assert(r, ht.load_limit >= NELEMS);
+	size_t slot_cnt = ht.slot_cnt;
+	for (size_t i = NELEMS / 2; i < NELEMS; i++) {
+		elems[i].key = i;
+		x_hmap_find_or_insert(&ht, &elems[i].link);
+	}
+	ut_assert_uint_equal(r, slot_cnt, ht.slot_cnt);
+	check_all(r, &ht, elems, NELEMS);
+	x_hmap_free(&ht);
+	free(elems);
+}
+
+static void memhash64(ut_runner *r)
+{
+	uint8_t buf[2048];
+	for (size_t i = 0; i < sizeof buf; i++)
+		buf[i] = (uint8_t)(i * 131 + 7);
+	for (size_t len = 0; len <= sizeof buf; len += len < 80 ? 1 : 61) {
+		uint64_t h = x_memhash64(buf, len, 1);
+		ut_assert(r, h == x_memhash64(buf, len, 1));
+		ut_assert(r, h != x_memhash64(buf, len, 2));
+		if (len) {
+			buf[len - 1] ^= 0x10;
+			ut_assert(r, h != x_memhash64(buf, len, 1));
+			buf[len - 1] ^= 0x10;
+		}
+	}
+	ut_assert(r, x_strhash64("libx", 0) == x_memhash64("libx", 4, 0));
+	ut_assert(r, x_hmap_strhash("libx") == x_hmap_memhash("libx", 4));
+}
+
+void hmap_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "hmap.h");
+	ut_suite_add(s, incremental);
+	ut_suite_add(s, reserve);
+	ut_suite_add(s, memhash64);
+}
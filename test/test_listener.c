@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/listener.h"
+#include "x/reactor.h"
+#include "x/socket.h"
+#include <string.h>
+#ifndef X_OS_WIN32
+#include <fcntl.h>
+#endif
+
+#define NCONNS 10
+#define BUDGET 4
+
+struct accepted
+{
+	x_sock socks[NCONNS];
+	int cnt;
+};
+
+static void on_accept(x_listener *ln, x_sock sock, void *arg)
+{
+	struct accepted *acc = arg;
+	(void)ln;
+	acc->socks[acc->cnt++] = sock;
+}
+
+static x_sock tcp_listener(struct sockaddr_in *addr)
+{
+	socklen_t len = sizeof *addr;
+	x_sock sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (sock == X_BADSOCK)
+		return X_BADSOCK;
+	memset(addr, 0, sizeof *addr);
+	addr->sin_family = AF_INET;
+	addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(sock, (struct sockaddr *)addr, sizeof *addr)
+			|| getsockname(sock, (struct sockaddr *)addr, &len)
+			|| listen(sock, NCONNS)
+			|| x_sock_set_nonblocking(sock)) {
+		x_sock_close(sock);
+		return X_BADSOCK;
+	}
+	return sock;
+}
+
+/* One reactor turn, returns how many sockets the listener took */
+static int turn(x_reactor *reactor)
+{
+	x_event *e;
+	int n = 0;
+	if (x_reactor_wait(reactor) < 0)
+		return -1;
+	while ((e = x_reactor_pop_event(reactor)))
+		n += x_listener_dispatch(e);
+	return n;
+}
+
+static void drain(ut_runner *r, short flags)
+{
+	x_reactor reactor;
+	x_listener ln;
+	struct sockaddr_in addr;
+	struct accepted acc = { .cnt = 0 };
+	x_sock clients[NCONNS];
+	x_sock sock = tcp_listener(&addr);
+	ut_assert(r, sock != X_BADSOCK);
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_listener_init(&ln, &reactor, sock, flags, on_accept, &acc));
+	ln.budget = BUDGET;
+
+	for (int i = 0; i < NCONNS; i++) {
+		clients[i] = socket(AF_INET, SOCK_STREAM, 0);
+		ut_assert(r, clients[i] != X_BADSOCK);
+		ut_assert_int_equal(r, 0, connect(clients[i], (struct sockaddr *)&addr, sizeof addr));
+	}
+
+	/* The backlog is taken a budget per turn, also when edge triggered */
+	ut_assert_int_equal(r, BUDGET, turn(&reactor));
+	ut_assert_int_equal(r, BUDGET, turn(&reactor));
+	ut_assert_int_equal(r, NCONNS - 2 * BUDGET, turn(&reactor));
+	ut_assert_int_equal(r, NCONNS, acc.cnt);
+
+	for (int i = 0; i < acc.cnt; i++) {
+#ifndef X_OS_WIN32
+		ut_assert(r, fcntl(acc.socks[i], F_GETFL) & O_NONBLOCK);
+		ut_assert(r, fcntl(acc.socks[i], F_GETFD) & FD_CLOEXEC);
+#endif
+		x_sock_close(acc.socks[i]);
+	}
+	for (int i = 0; i < NCONNS; i++)
+		x_sock_close(clients[i]);
+	x_listener_free(&ln);
+	x_sock_close(sock);
+	x_reactor_free(&reactor);
+}
+
+static void level(ut_runner *r)
+{
+	drain(r, 0);
+}
+
+static void edge(ut_runner *r)
+{
+	drain(r, X_EV_EDGE);
+}
+
+void listener_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "listener.h");
+	ut_suite_add(s, level);
+	ut_suite_add(s, edge);
+}
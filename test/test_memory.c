@@ -0,0 +1,261 @@
+#include "x/test.h"
+#include "x/memory.h"
+#include "x/thread.h"
+#include "x/dump.h"
+#include "x/printf.h"
+#include <stdio.h>
+#include <string.h>
+
+#define NTHREADS 4
+#define NOBJS 1000
+
+static x_mpool s_pool;
+
+static void arena(ut_runner *r)
+{
+	x_mset mset;
+	x_mset_init_arena(&mset, 256);
+
+	char *p1 = x_malloc(&mset, 10);
+	memset(p1, 'a', 10);
+	char *p2 = x_realloc(p1, 40);
+	ut_assert(r, p1 == p2);
+	ut_assert_mem_equal(r, "aaaaaaaaaa", 10, p2, 10);
+
+	char *big = x_malloc(&mset, 1024);
+	memset(big, 'b', 1024);
+	char *p3 = x_malloc(&mset, 8);
+	ut_assert(r, p3 != big);
+
+	x_free(p3);
+	char *p4 = x_malloc(&mset, 8);
+	ut_assert(r, p3 == p4);
+
+	x_mset_clear(&mset);
+	char *p5 = x_malloc(&mset, 10);
+	ut_assert(r, p5 == p1);
+	x_mset_free(&mset);
+}
+
+struct dump_buf
+{
+	x_uchar data[2048];
+	size_t len;
+};
+
+static int dump_out(const x_uchar *str, size_t len, void *ctx)
+{
+	struct dump_buf *buf = ctx;
+	if (len >= x_arrlen(buf->data) - buf->len)
+		return -1;
+	memcpy(buf->data + buf->len, str, len * sizeof *str);
+	buf->len += len;
+	buf->data[buf->len] = 0;
+	return 0;
+}
+
+static bool dump_has_site(const struct dump_buf *buf, const x_location *loc, int cnt, int bytes)
+{
+	x_uchar expect[256];
+	x_snprintf(expect, x_arrlen(expect), x_u("%s:%d\" = site {count = %d, bytes = %d}"),
+			loc->file, loc->line, cnt, bytes);
+	return x_ustrstr(buf->data, expect) != NULL;
+}
+
+static void stats(ut_runner *r)
+{
+	x_mset mset;
+	x_mset_stats st;
+	struct dump_buf buf = { .len = 0 };
+	const x_location *site_a = X_WHERE;
+	const x_location *site_b = X_WHERE;
+	void *a[3], *b1, *b2;
+	x_mset_init(&mset);
+	ut_assert_int_equal(r, 0, x_mset_stats_enable(&mset, true));
+
+	for (int i = 0; i < 3; i++)
+		a[i] = __x_malloc_at(site_a, &mset, 100);
+	b1 = __x_malloc_at(site_b, &mset, 50);
+	x_mset_stats_get(&mset, &st);
+	ut_assert_uint_equal(r, 350, st.live_bytes);
+	ut_assert_uint_equal(r, 4, st.live_blocks);
+	ut_assert_uint_equal(r, 350, st.peak_bytes);
+	ut_assert_uint_equal(r, 4, st.alloc_cnt);
+	ut_assert_uint_equal(r, 0, st.free_cnt);
+
+	/* A resize moves live and peak bytes but is not a new allocation */
+	a[0] = x_realloc(a[0], 200);
+	x_free(a[1]);
+	x_free(b1);
+	b2 = __x_malloc_at(site_b, &mset, 20);
+	x_mset_stats_get(&mset, &st);
+	ut_assert_uint_equal(r, 320, st.live_bytes);
+	ut_assert_uint_equal(r, 3, st.live_blocks);
+	ut_assert_uint_equal(r, 450, st.peak_bytes);
+	ut_assert_uint_equal(r, 5, st.alloc_cnt);
+	ut_assert_uint_equal(r, 2, st.free_cnt);
+
+	/* Sites keep what was allocated there, frees included */
+	x_dump *dmp = x_mset_stats_dump(&mset);
+	ut_assert(r, dmp != NULL);
+	ut_assert_int_equal(r, 0, x_dump_serialize(dmp, x_dump_default_format(), dump_out, &buf));
+	x_dump_free(dmp);
+	ut_assert(r, dump_has_site(&buf, site_a, 3, 300));
+	ut_assert(r, dump_has_site(&buf, site_b, 2, 70));
+	ut_assert(r, x_ustrstr(buf.data, x_u("unknown")) == NULL);
+
+	x_free(a[0]);
+	x_free(a[2]);
+	x_free(b2);
+	x_mset_stats_get(&mset, &st);
+	ut_assert_uint_equal(r, 0, st.live_bytes);
+	ut_assert_uint_equal(r, 0, st.live_blocks);
+	ut_assert_uint_equal(r, 450, st.peak_bytes);
+	ut_assert_uint_equal(r, 5, st.free_cnt);
+	x_mset_free(&mset);
+}
+
+/* Blocks that were live before stats were enabled are not counted */
+static void stats_late_enable(ut_runner *r)
+{
+	x_mset mset, arena;
+	x_mset_stats st;
+	x_mset_init(&mset);
+	x_mset_init_arena(&arena, 0);
+	void *old = x_malloc(&mset, 100), *grown = x_malloc(&mset, 100);
+	void *old_arena = x_malloc(&arena, 100);
+	ut_assert_int_equal(r, 0, x_mset_stats_enable(&mset, false));
+	ut_assert_int_equal(r, 0, x_mset_stats_enable(&arena, false));
+
+	void *p = x_malloc(&mset, 50);
+	grown = x_realloc(grown, X_MSET_MMAP_THRESHOLD);
+	x_free(old);
+	x_mset_stats_get(&mset, &st);
+	ut_assert_uint_equal(r, 50, st.live_bytes);
+	ut_assert_uint_equal(r, 1, st.live_blocks);
+	ut_assert_uint_equal(r, 0, st.free_cnt);
+	x_free(grown);
+	x_free(p);
+	x_mset_stats_get(&mset, &st);
+	ut_assert_uint_equal(r, 0, st.live_bytes);
+	ut_assert_uint_equal(r, 0, st.live_blocks);
+	ut_assert_uint_equal(r, 1, st.free_cnt);
+
+	/* Grown in place at the top of the chunk, then freed */
+	old_arena = x_realloc(old_arena, 200);
+	p = x_malloc(&arena, 30);
+	x_free(old_arena);
+	x_mset_stats_get(&arena, &st);
+	ut_assert_uint_equal(r, 30, st.live_bytes);
+	ut_assert_uint_equal(r, 1, st.live_blocks);
+	x_free(p);
+	x_mset_stats_get(&arena, &st);
+	ut_assert_uint_equal(r, 0, st.live_bytes);
+	ut_assert_uint_equal(r, 0, st.live_blocks);
+	x_mset_free(&arena);
+	x_mset_free(&mset);
+}
+
+static void large_realloc(ut_runner *r)
+{
+	x_mset mset;
+	x_mset_init(&mset);
+	size_t size = X_MSET_MMAP_THRESHOLD / 2;
+	uint8_t *p = x_malloc(&mset, size);
+	for (size_t i = 0; i < size; i++)
+		p[i] = i % 251;
+	for (int n = 0; n < 6; n++) {
+		size *= 2;
+		p = x_realloc(p, size);
+		for (size_t i = size / 2; i < size; i++)
+			p[i] = i % 251;
+	}
+	(void)x_mhuge(p);
+	bool match = true;
+	for (size_t i = 0; i < size; i++)
+		match = match && p[i] == i % 251;
+	ut_assert(r, match);
+	p = x_realloc(p, 1024);
+	ut_assert_uint_equal(r, 1023 % 251, p[1023]);
+	x_free(p);
+	x_mset_free(&mset);
+}
+
+/* A heap block shrunk to a size that is mapped now */
+static void shrink_to_mapped(ut_runner *r)
+{
+	size_t size = 4 * 1024 * 1024, new_size = 300 * 1024;
+	x_mset_set_mmap_threshold(X_MSET_MMAP_THRESHOLD_MAX);
+	uint8_t *p = x_malloc(NULL, size);
+	for (size_t i = 0; i < size; i++)
+		p[i] = i % 251;
+	x_mset_set_mmap_threshold(X_MSET_MMAP_THRESHOLD);
+	p = x_realloc(p, new_size);
+	bool match = true;
+	for (size_t i = 0; i < new_size; i++)
+		match = match && p[i] == i % 251;
+	ut_assert(r, match);
+	x_free(p);
+}
+
+static void mpool_reuse(ut_runner *r)
+{
+	void *objs[NOBJS];
+	x_mpool_init(&s_pool, 24);
+	for (int i = 0; i < NOBJS; i++) {
+		objs[i] = x_mpool_get(&s_pool);
+		memset(objs[i], i & 0xff, 24);
+	}
+	for (int i = 1; i < NOBJS; i++)
+		ut_assert(r, objs[i] != objs[i - 1]);
+	void *last = objs[NOBJS - 1];
+	x_mpool_put(&s_pool, last);
+	ut_assert(r, x_mpool_get(&s_pool) == last);
+	for (int i = 0; i < NOBJS; i++)
+		x_mpool_put(&s_pool, objs[i]);
+	x_mpool_free(&s_pool);
+}
+
+static int mpool_thread(void)
+{
+	void *objs[NOBJS];
+	for (int round = 0; round < 10; round++) {
+		for (int i = 0; i < NOBJS; i++) {
+			objs[i] = x_mpool_get(&s_pool);
+			*(uintptr_t *)objs[i] = (uintptr_t)objs[i];
+		}
+		for (int i = 0; i < NOBJS; i++) {
+			if (*(uintptr_t *)objs[i] != (uintptr_t)objs[i])
+				return -1;
+			x_mpool_put(&s_pool, objs[i]);
+		}
+	}
+	return 0;
+}
+
+static void mpool_threads(ut_runner *r)
+{
+	x_thread *thds[NTHREADS];
+	x_mpool_init(&s_pool, sizeof(uintptr_t));
+	for (int i = 0; i < NTHREADS; i++)
+		thds[i] = x_thread_create(mpool_thread, NULL, NULL);
+	for (int i = 0; i < NTHREADS; i++) {
+		int retval = -1;
+		x_thread_join(thds[i], &retval);
+		x_thread_free(thds[i]);
+		ut_assert_int_equal(r, 0, retval);
+	}
+	x_mpool_free(&s_pool);
+}
+
+void memory_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "memory.h");
+	ut_suite_add(s, arena);
+	ut_suite_add(s, stats);
+	ut_suite_add(s, stats_late_enable);
+	ut_suite_add(s, large_realloc);
+	ut_suite_add(s, shrink_to_mapped);
+	ut_suite_add(s, mpool_reuse);
+	ut_suite_add(s, mpool_threads);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/mpsc.h"
+#include "x/thread.h"
+#include "x/macros.h"
+#include <stdlib.h>
+
+#define NPRODUCERS 4
+#define NELEMS 50000
+
+struct elem {
+	x_mpsc_node node;
+	int producer;
+	int seq;
+};
+
+static x_mpsc s_queue;
+static struct elem *s_elems;
+
+static void single_thread(ut_runner *r)
+{
+	x_mpsc q;
+	struct elem e[3];
+	x_mpsc_init(&q);
+	ut_assert(r, x_mpsc_is_empty(&q));
+	ut_assert(r, x_mpsc_pop(&q) == NULL);
+	for (int i = 0; i < 3; i++)
+		x_mpsc_push(&q, &e[i].node);
+	ut_assert(r, !x_mpsc_is_empty(&q));
+	ut_assert(r, x_mpsc_pop(&q) == &e[0].node);
+	ut_assert(r, x_mpsc_pop(&q) == &e[1].node);
+
+	/* Reuse a popped node while the queue is not yet empty */
+	x_mpsc_push(&q, &e[0].node);
+	ut_assert(r, x_mpsc_pop(&q) == &e[2].node);
+	ut_assert(r, !x_mpsc_is_empty(&q));
+	ut_assert(r, x_mpsc_pop(&q) == &e[0].node);
+	ut_assert(r, x_mpsc_is_empty(&q));
+	ut_assert(r, x_mpsc_pop(&q) == NULL);
+}
+
+static int producer_thread(void)
+{
+	int id = (int)(intptr_t)x_thread_data();
+	for (int i = 0; i < NELEMS; i++) {
+		struct elem *e = &s_elems[id * NELEMS + i];
+		e->producer = id;
+		e->seq = i;
+		x_mpsc_push(&s_queue, &e->node);
+	}
+	return 0;
+}
+
+static void producers(ut_runner *r)
+{
+	x_thread *thds[NPRODUCERS];
+	int next[NPRODUCERS] = { 0 };
+	size_t total = 0;
+	bool ordered = true;
+	s_elems = calloc(NPRODUCERS * NELEMS, sizeof *s_elems);
+	x_mpsc_init(&s_queue);
+	for (int i = 0; i < NPRODUCERS; i++)
+		thds[i] = x_thread_create(producer_thread, NULL, (void *)(intptr_t)i);
+
+	/* Every element shows up once, in push order per producer */
+	while (total < NPRODUCERS * NELEMS) {
+		x_mpsc_node *node = x_mpsc_pop(&s_queue);
+		if (!node) {
+			x_thread_yield();
+			continue;
+		}
+		struct elem *e = x_container_of(node, struct elem, node);
+		if (e->seq != next[e->producer])
+			ordered = false;
+		next[e->producer] = e->seq + 1;
+		total++;
+	}
+	for (int i = 0; i < NPRODUCERS; i++) {
+		x_thread_join(thds[i], NULL);
+		x_thread_free(thds[i]);
+	}
+	ut_assert(r, ordered);
+	ut_assert(r, x_mpsc_is_empty(&s_queue));
+	ut_assert(r, x_mpsc_pop(&s_queue) == NULL);
+	free(s_elems);
+}
+
+void mpsc_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "mpsc.h");
+	ut_suite_add(s, single_thread);
+	ut_suite_add(s, producers);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/ohmap.h"
+#include "x/list.h"
+#include "x/macros.h"
+#include <stdlib.h>
+
+#define NELEMS 10000
+
+struct elem {
+	x_link link;
+	size_t key;
+};
+
+static size_t elem_hash(const x_link *link)
+{
+	return x_container_of(link, struct elem, link)->key;
+}
+
+static bool elem_equal(const x_link *l1, const x_link *l2)
+{
+	return x_container_of(l1, struct elem, link)->key
+		== x_container_of(l2, struct elem, link)->key;
+}
+
+static void find_insert(ut_runner *r)
+{
+	x_ohmap om;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_ohmap_init(&om, elem_hash, elem_equal);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = i * 7;
+		ut_assert(r, x_ohmap_find_or_insert(&om, &elems[i].link) == NULL);
+	}
+	ut_assert_uint_equal(r, NELEMS, om.elem_cnt);
+
+	for (size_t i = 0; i < NELEMS; i++) {
+		struct elem key = { .key = i * 7 };
+		ut_assert(r, x_ohmap_find(&om, &key.link) == &elems[i].link);
+		key.key = i * 7 + 1;
+		ut_assert(r, x_ohmap_find(&om, &key.link) == NULL);
+	}
+
+	struct elem dup = { .key = 14 };
+	ut_assert(r, x_ohmap_find_or_insert(&om, &dup.link) == &elems[2].link);
+	ut_assert(r, x_ohmap_replace_or_insert(&om, &dup.link) == &elems[2].link);
+	ut_assert(r, x_ohmap_find(&om, &elems[2].link) == &dup.link);
+	ut_assert_uint_equal(r, NELEMS, om.elem_cnt);
+
+	x_ohmap_free(&om);
+	free(elems);
+}
+
+static void remove_reinsert(ut_runner *r)
+{
+	x_ohmap om;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_ohmap_init(&om, elem_hash, elem_equal);
+	x_ohmap_reserve(&om, NELEMS);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].key = i;
+		x_ohmap_find_or_insert(&om, &elems[i].link);
+	}
+
+	/* Churn through removals and insertions to leave tombstones behind */
+	for (int round = 0; round < 8; round++) {
+		for (size_t i = round & 1; i < NELEMS; i += 2) {
+			if (i % 4 < 2)
+				x_ohmap_remove(&om, &elems[i].link);
+			else
+				ut_assert(r, x_ohmap_find_and_remove(&om, &elems[i].link) == &elems[i].link);
+		}
+		for (size_t i = round & 1; i < NELEMS; i += 2)
+			ut_assert(r, x_ohmap_find_or_insert(&om, &elems[i].link) == NULL);
+	}
+	ut_assert_uint_equal(r, NELEMS, om.elem_cnt);
+
+	size_t iter = 0, cnt = 0;
+	x_link *link;
+	while ((link = x_ohmap_next(&om, &iter))) {
+		struct elem *e = x_container_of(link, struct elem, link);
+		ut_assert(r, e == &elems[e->key]);
+		cnt++;
+	}
+	ut_assert_uint_equal(r, NELEMS, cnt);
+
+	for (size_t i = 0; i < NELEMS; i++)
+		x_ohmap_remove(&om, &elems[i].link);
+	ut_assert_uint_equal(r, 0, om.elem_cnt);
+	iter = 0;
+	ut_assert(r, x_ohmap_next(&om, &iter) == NULL);
+
+	x_ohmap_free(&om);
+	free(elems);
+}
+
+void ohmap_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "ohmap.h");
+	ut_suite_add(s, find_insert);
+	ut_suite_add(s, remove_reinsert);
+}
@@ -0,0 +1,631 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/reactor.h"
+#include "x/sockmux.h"
+#include "x/errno.h"
+#include "x/time.h"
+#include "x/thread.h"
+#include "x/atomic.h"
+#ifdef TEST_JSON
+#include "x/json.h"
+#endif
+#include <errno.h>
+#include <stdlib.h>
+#ifdef X_OS_LINUX
+#include <unistd.h>
+#endif
+
+static void run_timers(ut_runner *r, int store)
+{
+	x_reactor reactor;
+	x_evtimer periodic, once;
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_reactor_set_timer_store(&reactor, store));
+
+	x_evtimer_init(&periodic, 5, X_EV_ACCURATE, NULL);
+	x_evtimer_init(&once, 40, X_EV_ONCE, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &periodic.base));
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &once.base));
+	ut_assert_int_equal(r, -1, x_reactor_set_timer_store(&reactor, !store));
+	ut_assert_int_equal(r, X_EBUSY, errno);
+
+	uint64_t start = x_time_tick();
+	int ticks = 0;
+	bool done = false;
+	while (!done && x_reactor_wait(&reactor) > 0) {
+		x_event *e;
+		while ((e = x_reactor_pop_event(&reactor))) {
+			if (e == &periodic.base)
+				ticks++;
+			else if (e == &once.base)
+				done = true;
+		}
+	}
+	ut_assert(r, done);
+	ut_assert(r, x_time_tick() - start >= 40);
+	ut_assert(r, ticks >= 2);
+	ut_assert(r, !(once.base.ev_flags & X_EV_REACTING));
+
+	x_reactor_remove(&reactor, &periodic.base);
+	ut_assert_int_equal(r, 0, x_reactor_set_timer_store(&reactor, !store));
+	x_reactor_free(&reactor);
+}
+
+static void heap_timers(ut_runner *r)
+{
+	run_timers(r, X_REACTOR_TIMER_HEAP);
+}
+
+static void wheel_timers(ut_runner *r)
+{
+	run_timers(r, X_REACTOR_TIMER_WHEEL);
+}
+
+static void run_sockets(ut_runner *r, const struct x_sockmux_ops_st *ops)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_evsocket ev;
+	x_event *e;
+	char buf[4];
+	ut_assert_int_equal(r, 0, x_reactor_init_mux(&reactor, ops));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	x_evsocket_init(&ev, pair[0], X_EV_READ, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &ev.base));
+	ut_assert_int_equal(r, -1, x_reactor_add(&reactor, &ev.base));
+
+	ut_assert_int_equal(r, 2, send(pair[1], "ab", 2, 0));
+	/* Level triggered: reported again until drained */
+	for (int i = 0; i < 2; i++) {
+		ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+		e = x_reactor_pop_event(&reactor);
+		ut_assert(r, e == &ev.base);
+		ut_assert(r, e->res_flags & X_EV_READ);
+		ut_assert(r, x_reactor_pop_event(&reactor) == NULL);
+	}
+	ut_assert_int_equal(r, 2, recv(pair[0], buf, sizeof buf, 0));
+
+	ev.base.ev_flags |= X_EV_WRITE;
+	ut_assert_int_equal(r, 0, x_reactor_modify(&ev.base));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	e = x_reactor_pop_event(&reactor);
+	ut_assert(r, e == &ev.base);
+	ut_assert_int_equal(r, X_EV_WRITE, e->res_flags);
+
+	/* A removed socket must not be reported and can be added back */
+	ut_assert_int_equal(r, 1, send(pair[1], "c", 1, 0));
+	x_reactor_remove(&reactor, &ev.base);
+	ut_assert(r, !(ev.base.ev_flags & X_EV_REACTING));
+	ev.base.ev_flags = X_EV_READ;
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &ev.base));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &ev.base);
+
+	x_reactor_remove(&reactor, &ev.base);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+static void run_edge(ut_runner *r, const struct x_sockmux_ops_st *ops)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_evsocket ev;
+	x_evtimer timer;
+	x_event *e;
+	char buf[4];
+	ut_assert_int_equal(r, 0, x_reactor_init_mux(&reactor, ops));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	x_evsocket_init(&ev, pair[0], X_EV_READ | X_EV_EDGE, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &ev.base));
+
+	ut_assert_int_equal(r, 2, send(pair[1], "ab", 2, 0));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &ev.base);
+
+	/* Not drained, but no new data either: only the timer fires */
+	x_evtimer_init(&timer, 30, X_EV_ONCE, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &timer.base));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &timer.base);
+	ut_assert(r, x_reactor_pop_event(&reactor) == NULL);
+
+	ut_assert_int_equal(r, 1, send(pair[1], "c", 1, 0));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	e = x_reactor_pop_event(&reactor);
+	ut_assert(r, e == &ev.base);
+	ut_assert(r, e->res_flags & X_EV_READ);
+	ut_assert_int_equal(r, 3, recv(pair[0], buf, sizeof buf, 0));
+	x_reactor_remove(&reactor, &ev.base);
+
+	/* Exclusive entries still report and can be modified */
+	x_evsocket_init(&ev, pair[0], X_EV_READ | X_EV_EXCLUSIVE, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &ev.base));
+	ut_assert_int_equal(r, 1, send(pair[1], "d", 1, 0));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &ev.base);
+	ev.base.ev_flags |= X_EV_WRITE;
+	ut_assert_int_equal(r, 0, x_reactor_modify(&ev.base));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	e = x_reactor_pop_event(&reactor);
+	ut_assert(r, e == &ev.base);
+	ut_assert_int_equal(r, X_EV_READ | X_EV_WRITE, e->res_flags);
+
+	x_reactor_remove(&reactor, &ev.base);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+static void epoll_sockets(ut_runner *r)
+{
+	run_sockets(r, &x_sockmux_epoll);
+	run_edge(r, &x_sockmux_epoll);
+}
+
+static void uring_sockets(ut_runner *r)
+{
+	run_sockets(r, &x_sockmux_uring);
+	run_edge(r, &x_sockmux_uring);
+}
+
+static int raise_thread(void)
+{
+	x_evobject *obj = x_thread_data();
+	x_thread_sleep(20);
+	x_reactor_raise(obj, 1);
+	return 0;
+}
+
+static void wakeups(ut_runner *r)
+{
+	x_reactor reactor;
+	x_evtimer timer;
+	x_evobject obj;
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+
+	/* Redundant signals collapse into one wakeup, never into an event */
+	for (int i = 0; i < 1000; i++)
+		x_reactor_signal(&reactor);
+	x_evtimer_init(&timer, 20, X_EV_ONCE, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &timer.base));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &timer.base);
+	ut_assert(r, x_reactor_pop_event(&reactor) == NULL);
+
+	/* A signal from another thread still wakes a blocked wait */
+	x_evobject_init(&obj, 0, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &obj.base));
+	x_thread *t = x_thread_create(raise_thread, NULL, &obj);
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &obj.base);
+	x_thread_join(t, NULL);
+	x_thread_free(t);
+
+	x_reactor_remove(&reactor, &obj.base);
+	x_reactor_free(&reactor);
+}
+
+struct foreign_ctx
+{
+	x_reactor *reactor;
+	x_evsocket sock, dup;
+	x_evobject obj;
+};
+
+static int foreign_thread(void)
+{
+	struct foreign_ctx *ctx = x_thread_data();
+	x_thread_sleep(20);
+	if (x_reactor_add(ctx->reactor, &ctx->obj.base))
+		return -1;
+	x_thread_sleep(20);
+	if (x_reactor_add(ctx->reactor, &ctx->sock.base))
+		return -1;
+	/* Same socket twice, only the loop can find out */
+	x_thread_sleep(20);
+	if (x_reactor_add(ctx->reactor, &ctx->dup.base))
+		return -1;
+	return 0;
+}
+
+static void foreign_commands(ut_runner *r)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	struct foreign_ctx ctx;
+	int retval = -1;
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	ut_assert_int_equal(r, 1, send(pair[1], "a", 1, 0));
+	ctx.reactor = &reactor;
+	x_evsocket_init(&ctx.sock, pair[0], X_EV_READ, NULL);
+	x_evsocket_init(&ctx.dup, pair[0], X_EV_READ, NULL);
+	x_evobject_init(&ctx.obj, 0, NULL);
+	ctx.obj.base.res_flags = 1;
+
+	x_thread *t = x_thread_create(foreign_thread, NULL, &ctx);
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &ctx.obj.base);
+	ctx.obj.base.res_flags = 0;
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &ctx.sock.base);
+	char c;
+	ut_assert_int_equal(r, 1, recv(pair[0], &c, 1, 0));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	x_event *e = x_reactor_pop_event(&reactor);
+	ut_assert(r, e == &ctx.dup.base);
+	ut_assert_int_equal(r, X_EV_ERROR, e->res_flags);
+	ut_assert(r, !(e->ev_flags & X_EV_REACTING));
+	x_thread_join(t, &retval);
+	x_thread_free(t);
+	ut_assert_int_equal(r, 0, retval);
+
+	x_reactor_remove(&reactor, &ctx.sock.base);
+	x_reactor_remove(&reactor, &ctx.obj.base);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+#define NOBJECTS 10000
+#define NRAISERS 4
+#define NRAISES 100
+
+static x_evobject *s_objs;
+
+static int raiser_thread(void)
+{
+	int id = (int)(intptr_t)x_thread_data();
+	for (int i = 0; i < NRAISES; i++) {
+		x_reactor_raise(&s_objs[id * NRAISES + i], X_EV_READ);
+		if (i % 10 == 0)
+			x_thread_yield();
+	}
+	return 0;
+}
+
+static void raised_objects(ut_runner *r)
+{
+	x_reactor reactor;
+	x_evtimer timer;
+	x_thread *thds[NRAISERS];
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	s_objs = calloc(NOBJECTS, sizeof *s_objs);
+	for (int i = 0; i < NOBJECTS; i++) {
+		x_evobject_init(&s_objs[i], 0, NULL);
+		x_reactor_add(&reactor, &s_objs[i].base);
+	}
+
+	/* Raised on the loop thread, reported in raise order */
+	x_reactor_raise(&s_objs[20], X_EV_READ);
+	x_reactor_raise(&s_objs[10], X_EV_WRITE);
+	x_reactor_raise(&s_objs[20], X_EV_WRITE);
+	ut_assert_int_equal(r, 2, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &s_objs[20].base);
+	ut_assert(r, x_reactor_pop_event(&reactor) == &s_objs[10].base);
+	ut_assert(r, x_reactor_pop_event(&reactor) == NULL);
+	ut_assert_int_equal(r, X_EV_READ | X_EV_WRITE, s_objs[20].base.res_flags);
+
+	/* Reported until the flags are cleared */
+	s_objs[20].base.res_flags = 0;
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &s_objs[10].base);
+	s_objs[10].base.res_flags = 0;
+	x_evtimer_init(&timer, 10, X_EV_ONCE, NULL);
+	x_reactor_add(&reactor, &timer.base);
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &timer.base);
+
+	/* Raised by other threads, each one shows up */
+	for (int i = 0; i < NRAISERS; i++)
+		thds[i] = x_thread_create(raiser_thread, NULL, (void *)(intptr_t)i);
+	int seen = 0;
+	while (seen < NRAISERS * NRAISES && x_reactor_wait(&reactor) > 0) {
+		x_event *e;
+		while ((e = x_reactor_pop_event(&reactor))) {
+			x_evobject *obj = x_container_of(e, x_evobject, base);
+			if (obj->index == 0 && x_atomic_exchange(&e->res_flags, 0, X_ATOMIC_ACQ_REL)) {
+				obj->index = 1;
+				seen++;
+			}
+		}
+	}
+	for (int i = 0; i < NRAISERS; i++) {
+		x_thread_join(thds[i], NULL);
+		x_thread_free(thds[i]);
+	}
+	ut_assert_int_equal(r, NRAISERS * NRAISES, seen);
+	for (int i = 0; i < NRAISERS * NRAISES; i++)
+		ut_assert(r, s_objs[i].index == 1);
+
+	for (int i = 0; i < NOBJECTS; i++)
+		x_reactor_remove(&reactor, &s_objs[i].base);
+	x_reactor_free(&reactor);
+	free(s_objs);
+}
+
+#define NPINGS 2000
+#define NSPAMMERS 2
+
+static x_reactor *s_wake_reactor;
+static x_evobject s_ping;
+static int s_acks, s_pings_done, s_wakeup_lost;
+
+/* Wake the loop behind io_signaled's back, even if it got stuck set */
+static void poke_loop(x_reactor *reactor)
+{
+#ifdef X_OS_LINUX
+	if (reactor->io_pipe1 == -1) {
+		uint64_t one = 1;
+		(void)!write(reactor->io_event.sock, &one, sizeof one);
+		return;
+	}
+#endif
+	char octet = 0;
+	send(reactor->io_pipe1, &octet, sizeof octet, 0);
+}
+
+static int spam_thread(void)
+{
+	while (!x_atomic_load(&s_pings_done, X_ATOMIC_ACQUIRE)) {
+		for (int i = 0; i < 100; i++)
+			x_reactor_signal(s_wake_reactor);
+		x_thread_yield();
+	}
+	return 0;
+}
+
+static int ping_thread(void)
+{
+	for (int i = 0; i < NPINGS; i++) {
+		x_reactor_raise(&s_ping, X_EV_READ);
+		uint64_t deadline = x_time_tick() + 2000;
+		while (x_atomic_load(&s_acks, X_ATOMIC_ACQUIRE) <= i) {
+			if (x_time_tick() > deadline) {
+				x_atomic_store(&s_wakeup_lost, 1, X_ATOMIC_RELEASE);
+				goto out;
+			}
+			x_thread_yield();
+		}
+	}
+out:
+	x_atomic_store(&s_pings_done, 1, X_ATOMIC_RELEASE);
+	x_reactor_break(s_wake_reactor);
+	poke_loop(s_wake_reactor);
+	return 0;
+}
+
+/* Signals racing with the loop draining the wakeup must not be lost */
+static void wakeup_race(ut_runner *r)
+{
+	x_reactor reactor;
+	x_thread *spammers[NSPAMMERS], *pinger;
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	s_wake_reactor = &reactor;
+	s_acks = s_pings_done = s_wakeup_lost = 0;
+	x_evobject_init(&s_ping, 0, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &s_ping.base));
+
+	for (int i = 0; i < NSPAMMERS; i++)
+		spammers[i] = x_thread_create(spam_thread, NULL, NULL);
+	pinger = x_thread_create(ping_thread, NULL, NULL);
+	while (x_reactor_wait(&reactor) > 0) {
+		x_event *e;
+		while ((e = x_reactor_pop_event(&reactor)))
+			if (e == &s_ping.base && x_atomic_exchange(&e->res_flags, 0, X_ATOMIC_ACQ_REL))
+				x_atomic_fetch_add(&s_acks, 1, X_ATOMIC_RELEASE);
+	}
+	x_thread_join(pinger, NULL);
+	x_thread_free(pinger);
+	for (int i = 0; i < NSPAMMERS; i++) {
+		x_thread_join(spammers[i], NULL);
+		x_thread_free(spammers[i]);
+	}
+	ut_assert(r, !s_wakeup_lost);
+	ut_assert_int_equal(r, NPINGS, s_acks);
+
+	x_reactor_remove(&reactor, &s_ping.base);
+	x_reactor_free(&reactor);
+}
+
+static void stats(ut_runner *r)
+{
+	x_reactor reactor;
+	x_evtimer periodic, once;
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert(r, x_reactor_get_stats(&reactor) == NULL);
+	x_reactor_enable_stats(&reactor, true);
+	const x_reactor_stats *st = x_reactor_get_stats(&reactor);
+	ut_assert(r, st != NULL);
+
+	x_evtimer_init(&periodic, 2, 0, NULL);
+	x_evtimer_init(&once, 20, X_EV_ONCE, NULL);
+	x_reactor_add(&reactor, &periodic.base);
+	x_reactor_add(&reactor, &once.base);
+	uint64_t waits = 0, pops = 0;
+	bool done = false;
+	while (!done && x_reactor_wait(&reactor) > 0) {
+		waits++;
+		x_event *e;
+		while ((e = x_reactor_pop_event(&reactor))) {
+			pops++;
+			if (e == &once.base)
+				done = true;
+		}
+	}
+	ut_assert(r, done);
+	ut_assert(r, st->iterations >= waits);
+	ut_assert(r, st->poll_ns.count == st->iterations);
+	ut_assert(r, st->events.count == st->iterations);
+	ut_assert(r, st->events.sum >= pops);
+	ut_assert(r, st->pending_depth.count == waits);
+	ut_assert(r, st->dispatch_ns.count == pops);
+	ut_assert(r, st->timer_late_us.count == pops);
+	ut_assert(r, st->poll_ns.max >= 1000000);
+
+#ifdef TEST_JSON
+	x_json *json = x_reactor_stats_json(st);
+	ut_assert(r, json != NULL);
+	x_json *poll = x_json_object_at(json, "poll_ns", true);
+	ut_assert(r, x_json_is_object(poll));
+	ut_assert(r, x_json_number(x_json_object_at(poll, "count", true)) == (double)st->iterations);
+	ut_assert(r, x_json_array_size(x_json_object_at(poll, "buckets", true)) > 0);
+	x_json_free(json);
+#endif
+
+	x_reactor_reset_stats(&reactor);
+	ut_assert(r, st->iterations == 0 && st->poll_ns.count == 0);
+	x_reactor_enable_stats(&reactor, false);
+	ut_assert(r, x_reactor_get_stats(&reactor) == NULL);
+	x_reactor_remove(&reactor, &periodic.base);
+	x_reactor_free(&reactor);
+}
+
+static void busy_poll(ut_runner *r)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_evsocket ev;
+	x_evtimer timer;
+	char buf[4];
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	x_evsocket_init(&ev, pair[0], X_EV_READ, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &ev.base));
+
+	/* Events are picked up by the spinning polls */
+	x_reactor_set_busy_poll(&reactor, 1000000);
+	ut_assert_int_equal(r, 1, send(pair[1], "a", 1, 0));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &ev.base);
+	ut_assert_int_equal(r, 1, recv(pair[0], buf, sizeof buf, 0));
+
+	/* Spinning stops at the next timer */
+	x_evtimer_init(&timer, 5, X_EV_ONCE, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &timer.base));
+	uint64_t start = x_time_nsec();
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &timer.base);
+	ut_assert(r, x_time_nsec() - start < 500000000);
+
+	/* Blocks for the rest of the timeout once the budget is spent */
+	x_reactor_set_busy_poll(&reactor, 2000);
+	x_evtimer_init(&timer, 30, X_EV_ONCE, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &timer.base));
+	start = x_time_nsec();
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &timer.base);
+	ut_assert(r, x_time_nsec() - start >= 29000000);
+
+	x_reactor_remove(&reactor, &ev.base);
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+static void run_clear(ut_runner *r, int store)
+{
+	x_reactor reactor;
+	x_sock pair[2];
+	x_evsocket ev;
+	x_evtimer timer;
+	x_evobject obj;
+	x_event *e;
+	ut_assert_int_equal(r, 0, x_reactor_init(&reactor));
+	ut_assert_int_equal(r, 0, x_reactor_set_timer_store(&reactor, store));
+	x_reactor_clear(&reactor);
+
+	ut_assert_int_equal(r, 0, x_sock_pair(AF_UNIX, SOCK_STREAM, 0, pair));
+	x_evsocket_init(&ev, pair[0], X_EV_READ, NULL);
+	x_evtimer_init(&timer, 10, X_EV_ONCE, NULL);
+	x_evobject_init(&obj, 0, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &ev.base));
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &timer.base));
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &obj.base));
+	ut_assert_int_equal(r, 1, send(pair[1], "a", 1, 0));
+	x_reactor_raise(&obj, X_EV_READ);
+	ut_assert_int_equal(r, 2, x_reactor_wait(&reactor));
+
+	/* Everything is dropped, pended events included */
+	x_reactor_clear(&reactor);
+	ut_assert(r, x_reactor_pop_event(&reactor) == NULL);
+	ut_assert(r, !(ev.base.ev_flags & X_EV_REACTING) && !ev.base.reactor);
+	ut_assert(r, !(timer.base.ev_flags & X_EV_REACTING) && !timer.base.reactor);
+	ut_assert(r, !(obj.base.ev_flags & X_EV_REACTING) && !obj.base.reactor);
+
+	/* The reactor keeps working and the events can be added again */
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &ev.base));
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &timer.base));
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &obj.base));
+	bool got_sock = false, got_obj = false, got_timer = false;
+	while (!got_timer && x_reactor_wait(&reactor) > 0) {
+		while ((e = x_reactor_pop_event(&reactor))) {
+			got_sock |= e == &ev.base;
+			got_obj |= e == &obj.base;
+			got_timer |= e == &timer.base;
+		}
+	}
+	ut_assert(r, got_sock && got_obj && got_timer);
+
+	/* A signal after clear still wakes the loop */
+	x_reactor_clear(&reactor);
+	x_reactor_signal(&reactor);
+	x_evtimer_init(&timer, 5, X_EV_ONCE, NULL);
+	ut_assert_int_equal(r, 0, x_reactor_add(&reactor, &timer.base));
+	ut_assert_int_equal(r, 1, x_reactor_wait(&reactor));
+	ut_assert(r, x_reactor_pop_event(&reactor) == &timer.base);
+
+	x_sock_close(pair[0]);
+	x_sock_close(pair[1]);
+	x_reactor_free(&reactor);
+}
+
+static void heap_clear(ut_runner *r)
+{
+	run_clear(r, X_REACTOR_TIMER_HEAP);
+}
+
+static void wheel_clear(ut_runner *r)
+{
+	run_clear(r, X_REACTOR_TIMER_WHEEL);
+}
+
+void reactor_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "reactor.h");
+	ut_suite_add(s, heap_timers);
+	ut_suite_add(s, wheel_timers);
+	ut_suite_add(s, epoll_sockets);
+	ut_suite_add(s, uring_sockets);
+	ut_suite_add(s, wakeups);
+	ut_suite_add(s, foreign_commands);
+	ut_suite_add(s, raised_objects);
+	ut_suite_add(s, wakeup_race);
+	ut_suite_add(s, stats);
+	ut_suite_add(s, busy_poll);
+	ut_suite_add(s, heap_clear);
+	ut_suite_add(s, wheel_clear);
+}
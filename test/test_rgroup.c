@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/rgroup.h"
+#include "x/atomic.h"
+#include "x/thread.h"
+#include "x/time.h"
+#include <string.h>
+
+#define NLOOPS 3
+#define NMSGS 1000
+
+struct count_msg {
+	x_rgroup_msg base;
+	int target;
+};
+
+static int s_delivered;
+static int s_misrouted;
+static int s_accepted[NLOOPS];
+
+static bool wait_for(int *counter, int expected)
+{
+	uint64_t deadline = x_time_tick() + 5000;
+	while (x_atomic_load(counter, X_ATOMIC_ACQUIRE) < expected) {
+		if (x_time_tick() > deadline)
+			return false;
+		x_thread_sleep(1);
+	}
+	return true;
+}
+
+static void count_msg_fn(x_rgroup_loop *loop, x_rgroup_msg *msg)
+{
+	struct count_msg *m = x_container_of(msg, struct count_msg, base);
+	if (m->target != loop->index)
+		x_atomic_fetch_add(&s_misrouted, 1, X_ATOMIC_RELAXED);
+	x_atomic_fetch_add(&s_delivered, 1, X_ATOMIC_RELEASE);
+}
+
+static void messages(ut_runner *r)
+{
+	x_rgroup g;
+	static struct count_msg msgs[NMSGS];
+	s_delivered = s_misrouted = 0;
+	ut_assert_int_equal(r, 0, x_rgroup_init(&g, NLOOPS, 0, NULL, NULL));
+	/* Sent before the loops run, delivered once they do */
+	for (int i = 0; i < NMSGS / 2; i++) {
+		msgs[i].base.fn = count_msg_fn;
+		msgs[i].target = i % NLOOPS;
+		x_rgroup_send(x_rgroup_loop_at(&g, msgs[i].target), &msgs[i].base);
+	}
+	ut_assert_int_equal(r, 0, x_rgroup_start(&g));
+	for (int i = NMSGS / 2; i < NMSGS; i++) {
+		msgs[i].base.fn = count_msg_fn;
+		msgs[i].target = i % NLOOPS;
+		x_rgroup_send(x_rgroup_loop_at(&g, msgs[i].target), &msgs[i].base);
+	}
+	ut_assert(r, wait_for(&s_delivered, NMSGS));
+	x_rgroup_stop(&g);
+	ut_assert_int_equal(r, NMSGS, s_delivered);
+	ut_assert_int_equal(r, 0, s_misrouted);
+	x_rgroup_free(&g);
+}
+
+static void count_accept(x_rgroup_loop *loop, x_sock sock)
+{
+	x_sock_close(sock);
+	x_atomic_fetch_add(&s_accepted[loop->index], 1, X_ATOMIC_RELEASE);
+}
+
+static int accepted_total(void)
+{
+	int total = 0;
+	for (int i = 0; i < NLOOPS; i++)
+		total += x_atomic_load(&s_accepted[i], X_ATOMIC_ACQUIRE);
+	return total;
+}
+
+static bool run_accept(ut_runner *r, int dispatch, int nconns)
+{
+	x_rgroup g;
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof addr;
+	memset(s_accepted, 0, sizeof s_accepted);
+	memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	ut_assert_int_equal(r, 0, x_rgroup_init(&g, NLOOPS, 0, NULL, NULL));
+	if (x_rgroup_listen(&g, (struct sockaddr *)&addr, sizeof addr, dispatch, count_accept)) {
+		x_rgroup_free(&g);
+		return false;
+	}
+	ut_assert_int_equal(r, 0, getsockname(x_rgroup_loop_at(&g, 0)->listener.ev.sock,
+				(struct sockaddr *)&addr, &addrlen));
+	ut_assert_int_equal(r, 0, x_rgroup_start(&g));
+	for (int i = 0; i < nconns; i++) {
+		x_sock sock = socket(AF_INET, SOCK_STREAM, 0);
+		ut_assert_int_equal(r, 0, connect(sock, (struct sockaddr *)&addr, sizeof addr));
+		/* One at a time, so round robin is exact */
+		int total = 0;
+		uint64_t deadline = x_time_tick() + 5000;
+		while ((total = accepted_total()) <= i && x_time_tick() < deadline)
+			x_thread_sleep(1);
+		x_sock_close(sock);
+		ut_assert_int_equal(r, i + 1, total);
+	}
+	x_rgroup_stop(&g);
+	x_rgroup_free(&g);
+	return true;
+}
+
+static void round_robin(ut_runner *r)
+{
+	ut_assert(r, run_accept(r, X_RGROUP_ROUND_ROBIN, NLOOPS * 2));
+	for (int i = 0; i < NLOOPS; i++)
+		ut_assert_int_equal(r, 2, s_accepted[i]);
+}
+
+static void reuseport(ut_runner *r)
+{
+	/* Kernels without SO_REUSEPORT refuse the listen, nothing to test */
+	if (!run_accept(r, X_RGROUP_REUSEPORT, 30))
+		return;
+	ut_assert_int_equal(r, 30, accepted_total());
+}
+
+void rgroup_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "rgroup.h");
+	ut_suite_add(s, messages);
+	ut_suite_add(s, round_robin);
+	ut_suite_add(s, reuseport);
+}
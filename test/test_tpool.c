@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/tpool.h"
+#include "x/atomic.h"
+
+#define NTASKS 10000
+#define DEPTH 12
+
+static x_tpool *s_pool;
+static size_t s_done;
+
+static void count(void *arg)
+{
+	(void)arg;
+	x_atomic_fetch_add(&s_done, 1, X_ATOMIC_RELAXED);
+}
+
+/* Each task below the top adds two children from the worker running it */
+static void split(void *arg)
+{
+	intptr_t depth = (intptr_t)arg;
+	x_atomic_fetch_add(&s_done, 1, X_ATOMIC_RELAXED);
+	if (depth == 0)
+		return;
+	for (int i = 0; i < 2; i++)
+		x_tpool_add_work(s_pool, x_tpool_work_create(split, (void *)(depth - 1)));
+}
+
+static void run(ut_runner *r, int mode)
+{
+	x_tpool pool;
+	s_pool = &pool;
+	ut_assert_int_equal(r, 0, x_tpool_init_mode(&pool, 4, mode));
+
+	s_done = 0;
+	for (int i = 0; i < NTASKS; i++)
+		x_tpool_add_work(&pool, x_tpool_work_create(count, NULL));
+	x_tpool_wait(&pool);
+	ut_assert_uint_equal(r, NTASKS, x_atomic_load(&s_done, X_ATOMIC_RELAXED));
+
+	s_done = 0;
+	x_tpool_add_work(&pool, x_tpool_work_create(split, (void *)(intptr_t)DEPTH));
+	x_tpool_wait(&pool);
+	ut_assert_uint_equal(r, (1 << (DEPTH + 1)) - 1, x_atomic_load(&s_done, X_ATOMIC_RELAXED));
+
+	x_tpool_destroy(&pool);
+}
+
+static void shared(ut_runner *r)
+{
+	run(r, X_TPOOL_SHARED);
+}
+
+static void stealing(ut_runner *r)
+{
+	run(r, X_TPOOL_STEALING);
+}
+
+static void bad_mode(ut_runner *r)
+{
+	x_tpool pool;
+	ut_assert_int_equal(r, -1, x_tpool_init_mode(&pool, 1, -1));
+}
+
+void tpool_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "tpool.h");
+	ut_suite_add(s, shared);
+	ut_suite_add(s, stealing);
+	ut_suite_add(s, bad_mode);
+}
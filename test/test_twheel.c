@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026 Li Xilin <lixilin@gmx.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "x/test.h"
+#include "x/twheel.h"
+#include "x/macros.h"
+#include <stdlib.h>
+
+#define NELEMS 20000
+#define HORIZON 300000
+
+struct elem {
+	x_twnode node;
+	uint64_t due;
+	bool fired;
+};
+
+static uint64_t s_rnd = 88172645463325252ULL;
+
+static uint64_t rnd(void)
+{
+	s_rnd ^= s_rnd << 13, s_rnd ^= s_rnd >> 7, s_rnd ^= s_rnd << 17;
+	return s_rnd;
+}
+
+static size_t drain(ut_runner *r, x_list *expired, uint64_t prev, uint64_t now)
+{
+	size_t cnt = 0;
+	x_link *link;
+	while ((link = x_list_first(expired))) {
+		x_list_del(link);
+		struct elem *e = x_container_of(link, struct elem, node.link);
+		ut_assert(r, !e->fired);
+		ut_assert(r, e->due > prev && e->due <= now);
+		e->fired = true;
+		cnt++;
+	}
+	return cnt;
+}
+
+static void expire_order(ut_runner *r)
+{
+	x_twheel w;
+	x_list expired;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	uint64_t now = 1000;
+	x_list_init(&expired);
+	x_twheel_init(&w, now + 1);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].due = now + 1 + rnd() % HORIZON;
+		x_twheel_add(&w, &elems[i].node, elems[i].due);
+	}
+	ut_assert_uint_equal(r, NELEMS, x_twheel_size(&w));
+
+	size_t fired = 0;
+	while (now < 1000 + HORIZON + 1) {
+		uint64_t earliest = UINT64_MAX;
+		for (size_t i = 0; i < NELEMS; i++)
+			if (!elems[i].fired && elems[i].due < earliest)
+				earliest = elems[i].due;
+		if (earliest != UINT64_MAX)
+			ut_assert(r, x_twheel_next(&w) <= earliest);
+		uint64_t prev = now;
+		now += 1 + rnd() % 5000;
+		size_t n = x_twheel_advance(&w, now, &expired);
+		ut_assert_uint_equal(r, n, drain(r, &expired, prev, now));
+		fired += n;
+	}
+	ut_assert_uint_equal(r, NELEMS, fired);
+	ut_assert_uint_equal(r, 0, x_twheel_size(&w));
+	ut_assert(r, x_twheel_next(&w) == UINT64_MAX);
+	x_twheel_free(&w);
+	free(elems);
+}
+
+static void remove_readd(ut_runner *r)
+{
+	x_twheel w;
+	x_list expired;
+	struct elem *elems = calloc(NELEMS, sizeof *elems);
+	x_list_init(&expired);
+	x_twheel_init(&w, 0);
+	for (size_t i = 0; i < NELEMS; i++) {
+		elems[i].due = 1 + rnd() % HORIZON;
+		x_twheel_add(&w, &elems[i].node, elems[i].due);
+	}
+	for (size_t i = 0; i < NELEMS; i += 2) {
+		x_twheel_remove(&w, &elems[i].node);
+		ut_assert(r, !x_twnode_pending(&elems[i].node));
+	}
+	/* Push the rest further out, as an idle timer reset would */
+	for (size_t i = 1; i < NELEMS; i += 4) {
+		x_twheel_remove(&w, &elems[i].node);
+		elems[i].due += HORIZON;
+		x_twheel_add(&w, &elems[i].node, elems[i].due);
+	}
+	ut_assert_uint_equal(r, NELEMS / 2, x_twheel_size(&w));
+
+	size_t n = x_twheel_advance(&w, 3 * HORIZON, &expired);
+	ut_assert_uint_equal(r, NELEMS / 2, n);
+	ut_assert_uint_equal(r, n, drain(r, &expired, 0, 3 * HORIZON));
+	for (size_t i = 0; i < NELEMS; i++)
+		ut_assert(r, elems[i].fired == (i & 1));
+	x_twheel_free(&w);
+	free(elems);
+}
+
+static void far_and_past(ut_runner *r)
+{
+	x_twheel w;
+	x_list expired;
+	struct elem far = { .due = 0 }, past = { .due = 0 };
+	uint64_t span = (uint64_t)1 << (X_TWHEEL_BITS * X_TWHEEL_LEVELS);
+	x_list_init(&expired);
+	x_twheel_init(&w, 100);
+
+	x_twheel_add(&w, &past.node, 10);
+	ut_assert(r, x_twheel_next(&w) == 100);
+	ut_assert_uint_equal(r, 1, x_twheel_advance(&w, 100, &expired));
+	ut_assert(r, x_list_first(&expired) == &past.node.link);
+	x_list_del(&past.node.link);
+
+	far.due = 100 + 2 * span + 5;
+	x_twheel_add(&w, &far.node, far.due);
+	ut_assert_uint_equal(r, 0, x_twheel_advance(&w, far.due - 1, &expired));
+	ut_assert(r, x_twnode_pending(&far.node));
+	ut_assert(r, x_twheel_next(&w) == far.due);
+	ut_assert_uint_equal(r, 1, x_twheel_advance(&w, far.due, &expired));
+	ut_assert(r, x_list_first(&expired) == &far.node.link);
+	x_twheel_free(&w);
+}
+
+static void cross_block(ut_runner *r)
+{
+	x_twheel w;
+	x_list expired;
+	struct elem a = { .due = 70 }, b = { .due = 110 };
+	x_list_init(&expired);
+	x_twheel_init(&w, 10);
+	x_twheel_add(&w, &a.node, a.due);
+	x_twheel_add(&w, &b.node, b.due);
+	ut_assert(r, x_twheel_next(&w) <= a.due);
+
+	/* a sits in level 0 past the boundary at 64, b in the level 1 slot
+	 * that must be cascaded there */
+	size_t fired = 0;
+	for (uint64_t now = 20; now <= 5000; now += 50) {
+		fired += x_twheel_advance(&w, now, &expired);
+		drain(r, &expired, now - 50, now);
+	}
+	ut_assert_uint_equal(r, 2, fired);
+	ut_assert(r, a.fired && b.fired);
+	ut_assert(r, x_twheel_next(&w) == UINT64_MAX);
+	x_twheel_free(&w);
+}
+
+void twheel_test_init(ut_suite *s)
+{
+	ut_suite_init(s, "twheel.h");
+	ut_suite_add(s, expire_order);
+	ut_suite_add(s, remove_readd);
+	ut_suite_add(s, far_and_past);
+	ut_suite_add(s, cross_block);
+}